@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "animation.h"
+
+class2(CFXAnimation);
+
+/**
+ * Shortest frame duration accepted, so Update always makes progress.
+ */
+constexpr float MinFrameTime = 0.001f;
+
+/**
+ * @brief Constructor for the CFXAnimation object.
+ *
+ * @param this     Pointer to the CFXAnimation instance to initialize.
+ * @param texture  Sprite sheet the frames are cut from.
+ * @return         Pointer to the initialized CFXAnimation instance.
+ */
+proc void* Ctor(CFXAnimationRef this, CFXTexture2DRef texture)
+{
+    CFXAnimation->dtor = dtor;
+    this->texture = texture;
+    this->frameUV = nullptr;
+    this->frameTime = nullptr;
+    this->frameCount = 0;
+    this->frameCapacity = 0;
+    this->clips = nullptr;
+    this->clipCount = 0;
+    this->clipCapacity = 0;
+    this->clip = nullptr;
+    this->frame = nullptr;
+    this->time = nullptr;
+    this->speed = nullptr;
+    this->finished = nullptr;
+    this->uv = nullptr;
+    this->count = 0;
+    this->capacity = 0;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXAnimation object.
+ *
+ * @param self Pointer to the CFXAnimation instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXAnimationRef this = self;
+    for (int i = 0; i < this->clipCount; i++)
+        free(this->clips[i].name);
+    free(this->clips);
+    free(this->frameUV);
+    free(this->frameTime);
+    free(this->clip);
+    free(this->frame);
+    free(this->time);
+    free(this->speed);
+    free(this->finished);
+    free(this->uv);
+}
+
+/**
+ * @brief Appends a frame, converting its pixel rectangle to uv space.
+ *
+ * Pixel rectangles are measured from the top left of the sheet, while
+ * textures are loaded flipped on the y axis.
+ */
+static void PushFrame(CFXAnimationRef this, CFXRect rect, GLfloat duration)
+{
+    if (this->frameCount == this->frameCapacity) {
+        this->frameCapacity = this->frameCapacity ? this->frameCapacity * 2 : 32;
+        this->frameUV = realloc(this->frameUV, this->frameCapacity * sizeof(Vec4));
+        this->frameTime = realloc(this->frameTime, this->frameCapacity * sizeof(GLfloat));
+    }
+    float iw = 1.0f / (float)this->texture->Width;
+    float ih = 1.0f / (float)this->texture->Height;
+    this->frameUV[this->frameCount] = (Vec4) {
+        rect.x * iw, 1.0f - (rect.y + rect.h) * ih, rect.w * iw, rect.h * ih };
+    this->frameTime[this->frameCount] = duration > MinFrameTime ? duration : MinFrameTime;
+    this->frameCount++;
+}
+
+/**
+ * @brief Registers a clip over the frames just pushed.
+ */
+static int PushClip(CFXAnimationRef this, const char* name, int first, bool loop)
+{
+    if (this->clipCount == this->clipCapacity) {
+        this->clipCapacity = this->clipCapacity ? this->clipCapacity * 2 : 8;
+        this->clips = realloc(this->clips, this->clipCapacity * sizeof(CFXAnimationClip));
+    }
+    this->clips[this->clipCount] = (CFXAnimationClip) {
+        .name = CFStrDup((char*)name), .first = first, .count = this->frameCount - first, .loop = loop };
+    return this->clipCount++;
+}
+
+/**
+ * @brief Adds a clip from explicit frame rectangles, as found in atlas metadata.
+ *
+ * @param this       Reference to the animation set.
+ * @param name       Clip name.
+ * @param frames     Frame rectangles in pixels from the top left of the sheet.
+ * @param durations  Duration of each frame in seconds.
+ * @param count      Number of frames.
+ * @param loop       Whether the clip repeats.
+ * @return           Index of the clip, or -1 if it has no frames.
+ */
+proc int AddClip(
+    CFXAnimationRef this,
+    const char* name,
+    const CFXRect* frames,
+    const GLfloat* durations,
+    int count,
+    bool loop)
+{
+    if (count <= 0)
+        return -1;
+    int first = this->frameCount;
+    for (int i = 0; i < count; i++)
+        PushFrame(this, frames[i], durations[i]);
+    return PushClip(this, name, first, loop);
+}
+
+/**
+ * @brief Adds a clip of evenly sized, evenly timed frames from a grid or strip.
+ *
+ * Frames are numbered left to right, then top to bottom.
+ *
+ * @param this         Reference to the animation set.
+ * @param name         Clip name.
+ * @param frameWidth   Width of a cell in pixels.
+ * @param frameHeight  Height of a cell in pixels.
+ * @param first        Number of the clip's first cell.
+ * @param count        Number of frames.
+ * @param fps          Playback rate in frames per second.
+ * @param loop         Whether the clip repeats.
+ * @return             Index of the clip, or -1 if it has no frames.
+ */
+proc int AddClip(
+    CFXAnimationRef this,
+    const char* name,
+    int frameWidth,
+    int frameHeight,
+    int first,
+    int count,
+    GLfloat fps,
+    bool loop)
+{
+    if (count <= 0 || frameWidth <= 0 || frameHeight <= 0)
+        return -1;
+    int columns = Max((int)this->texture->Width / frameWidth, 1);
+    int start = this->frameCount;
+    for (int i = first; i < first + count; i++) {
+        CFXRect cell = { (i % columns) * frameWidth, (i / columns) * frameHeight, frameWidth, frameHeight };
+        PushFrame(this, cell, fps > 0.0f ? 1.0f / fps : 0.0f);
+    }
+    return PushClip(this, name, start, loop);
+}
+
+/**
+ * @brief Loads clips from a frame table file.
+ *
+ * One directive per line; blank lines and lines starting with # are ignored.
+ * - clip NAME loop|once: starts a clip; following frame lines belong to it.
+ * - frame X Y W H MS: a frame rectangle in pixels and its duration in milliseconds.
+ * - grid NAME W H FIRST COUNT FPS loop|once: a whole clip, as the grid AddClip.
+ *
+ * @param this  Reference to the animation set.
+ * @param file  Path to the frame table.
+ * @return      false if the file could not be read or has a malformed line.
+ */
+proc bool Load(CFXAnimationRef this, const char* file)
+{
+    CFStringRef text = CFFS.readTextFile((char*)file);
+    if (text == nullptr) {
+        printf("| ERROR::ANIMATION: Failed to read %s\n", file);
+        return false;
+    }
+
+    bool ok = true;
+    char clipName[64] = { 0 }, name[64], mode[16];
+    int first = -1, lineNumber = 0;
+    bool loop = true;
+    const char* line = CFStringC(text);
+    while (line != nullptr) {
+        const char* next = strchr(line, '\n');
+        int length = next ? (int)(next - line) : (int)strlen(line);
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%.*s", length < 255 ? length : 255, line);
+        line = next ? next + 1 : nullptr;
+        lineNumber++;
+
+        char* s = buffer;
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (*s == '\0' || *s == '#' || *s == '\r')
+            continue;
+
+        int x, y, w, h, begin, count;
+        float value;
+        if (sscanf(s, "frame %d %d %d %d %f", &x, &y, &w, &h, &value) == 5 && first >= 0) {
+            PushFrame(this, (CFXRect) { x, y, w, h }, value / 1000.0f);
+            continue;
+        }
+        // Any other directive ends the clip being collected.
+        if (first >= 0 && this->frameCount > first)
+            PushClip(this, clipName, first, loop);
+        first = -1;
+        if (sscanf(s, "clip %63s %15s", clipName, mode) == 2) {
+            first = this->frameCount;
+            loop = strcmp(mode, "once") != 0;
+        } else if (sscanf(s, "grid %63s %d %d %d %d %f %15s", name, &w, &h, &begin, &count, &value, mode) == 7) {
+            AddClip(this, name, w, h, begin, count, value, strcmp(mode, "once") != 0);
+        } else {
+            printf("| ERROR::ANIMATION: %s:%d: cannot parse \"%s\"\n", file, lineNumber, s);
+            ok = false;
+        }
+    }
+    if (first >= 0 && this->frameCount > first)
+        PushClip(this, clipName, first, loop);
+    CFUnref(text);
+    return ok;
+}
+
+/**
+ * @brief Looks up a clip by name.
+ *
+ * @param this  Reference to the animation set.
+ * @param name  Clip name.
+ * @return      Index of the clip, or -1.
+ */
+proc int FindClip(CFXAnimationRef this, const char* name)
+{
+    for (int i = 0; i < this->clipCount; i++)
+        if (strcmp(this->clips[i].name, name) == 0)
+            return i;
+    return -1;
+}
+
+/**
+ * @brief Adds an instance playing a clip from its first frame.
+ *
+ * @param this  Reference to the animation set.
+ * @param clip  Index of the clip.
+ * @return      Index of the instance, or -1 if there is no such clip.
+ */
+proc int AddInstance(CFXAnimationRef this, int clip)
+{
+    if (clip < 0 || clip >= this->clipCount) {
+        printf("| ERROR::ANIMATION: No clip %d\n", clip);
+        return -1;
+    }
+    if (this->count == this->capacity) {
+        this->capacity = this->capacity ? this->capacity * 2 : 64;
+        this->clip = realloc(this->clip, this->capacity * sizeof(int));
+        this->frame = realloc(this->frame, this->capacity * sizeof(int));
+        this->time = realloc(this->time, this->capacity * sizeof(GLfloat));
+        this->speed = realloc(this->speed, this->capacity * sizeof(GLfloat));
+        this->finished = realloc(this->finished, this->capacity * sizeof(bool));
+        this->uv = realloc(this->uv, this->capacity * sizeof(Vec4));
+    }
+    int instance = this->count++;
+    this->speed[instance] = 1.0f;
+    Play(this, instance, clip);
+    return instance;
+}
+
+/**
+ * @brief Removes an instance by moving the last instance into its slot.
+ *
+ * @param this      Reference to the animation set.
+ * @param instance  Index of the instance; the last instance takes this index.
+ */
+proc void RemoveInstance(CFXAnimationRef this, int instance)
+{
+    if (instance < 0 || instance >= this->count)
+        return;
+    int last = --this->count;
+    this->clip[instance] = this->clip[last];
+    this->frame[instance] = this->frame[last];
+    this->time[instance] = this->time[last];
+    this->speed[instance] = this->speed[last];
+    this->finished[instance] = this->finished[last];
+    this->uv[instance] = this->uv[last];
+}
+
+/**
+ * @brief Restarts an instance on a clip, keeping its speed.
+ *
+ * Does nothing for an instance or clip that does not exist, such as the -1
+ * FindClip returns for an unknown name.
+ *
+ * @param this      Reference to the animation set.
+ * @param instance  Index of the instance.
+ * @param clip      Index of the clip.
+ */
+proc void Play(CFXAnimationRef this, int instance, int clip)
+{
+    if (instance < 0 || instance >= this->count || clip < 0 || clip >= this->clipCount) {
+        printf("| ERROR::ANIMATION: No instance %d or clip %d\n", instance, clip);
+        return;
+    }
+    this->clip[instance] = clip;
+    this->frame[instance] = this->clips[clip].first;
+    this->time[instance] = 0.0f;
+    this->finished[instance] = false;
+    this->uv[instance] = this->frameUV[this->clips[clip].first];
+}
+
+/**
+ * @brief Advances every instance.
+ *
+ * Pass the delta from Tick. Large deltas skip as many frames as needed.
+ *
+ * @param this   Reference to the animation set.
+ * @param delta  Seconds since the last update.
+ */
+proc void Update(CFXAnimationRef this, GLfloat delta)
+{
+    const GLfloat* frameTime = this->frameTime;
+    for (int i = 0; i < this->count; i++) {
+        if (this->finished[i])
+            continue;
+        GLfloat t = this->time[i] + delta * this->speed[i];
+        int f = this->frame[i];
+        if (t >= frameTime[f]) {
+            const CFXAnimationClip* clip = &this->clips[this->clip[i]];
+            int end = clip->first + clip->count;
+            while (t >= frameTime[f]) {
+                t -= frameTime[f];
+                if (++f < end)
+                    continue;
+                if (clip->loop)
+                    f = clip->first;
+                else {
+                    f = end - 1;
+                    t = 0.0f;
+                    this->finished[i] = true;
+                    break;
+                }
+            }
+            this->frame[i] = f;
+            this->uv[i] = this->frameUV[f];
+        }
+        this->time[i] = t;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rect.h"
+#include "texture2d.h"
+#include "tglm.h"
+
+extern CFClassRef CFXAnimation;
+typedef struct __CFXAnimation* CFXAnimationRef;
+
+/**
+ * @struct CFXAnimationClip
+ * @brief A named run of frames in the frame table.
+ *
+ * Members:
+ * - name:   Clip name, for FindClip.
+ * - first:  Index of the clip's first frame in the frame table.
+ * - count:  Number of frames.
+ * - loop:   Whether playback wraps to the first frame or holds the last one.
+ */
+typedef struct CFXAnimationClip {
+    char* name;
+    int first;
+    int count;
+    bool loop;
+} CFXAnimationClip;
+
+/**
+ * @struct __CFXAnimation
+ * @brief Frame tables for one sprite sheet and the instances playing them.
+ *
+ * Frames are stored once, as uv rectangles ready for the sprite renderer and
+ * their durations in seconds; clips index runs of them. Instances are kept
+ * as parallel arrays so Update is a single pass over contiguous memory, and
+ * Update writes each instance's current uv rectangle to uv, which Draw
+ * reads as is. Nothing is allocated per frame.
+ *
+ * Members:
+ * - obj:           Base object information for the animation set.
+ * - texture:       Sheet the frames refer to.
+ * - frameUV:       Frame table: uv rectangle of each frame.
+ * - frameTime:     Frame table: duration of each frame in seconds.
+ * - frameCount:    Number of frames.
+ * - frameCapacity: Allocated size of the frame table.
+ * - clips:         Clips defined on the frame table.
+ * - clipCount:     Number of clips.
+ * - clipCapacity:  Allocated size of clips.
+ * - clip:          Per instance: clip playing.
+ * - frame:         Per instance: absolute index of the current frame.
+ * - time:          Per instance: seconds spent in the current frame.
+ * - speed:         Per instance: playback rate, 0 pauses.
+ * - finished:      Per instance: set when a non-looping clip reaches its end.
+ * - uv:            Per instance: uv rectangle of the current frame.
+ * - count:         Number of instances.
+ * - capacity:      Allocated size of the instance arrays.
+ */
+typedef struct __CFXAnimation {
+    __CFObject obj;
+    CFXTexture2DRef texture;
+    Vec4* frameUV;
+    GLfloat* frameTime;
+    int frameCount;
+    int frameCapacity;
+    CFXAnimationClip* clips;
+    int clipCount;
+    int clipCapacity;
+    int* clip;
+    int* frame;
+    GLfloat* time;
+    GLfloat* speed;
+    bool* finished;
+    Vec4* uv;
+    int count;
+    int capacity;
+} __CFXAnimation;
+
+extern proc void* Ctor(
+    CFXAnimationRef this,
+    CFXTexture2DRef texture);
+
+extern proc int AddClip(
+    CFXAnimationRef this,
+    const char* name,
+    const CFXRect* frames,
+    const GLfloat* durations,
+    int count,
+    bool loop);
+
+extern proc int AddClip(
+    CFXAnimationRef this,
+    const char* name,
+    int frameWidth,
+    int frameHeight,
+    int first,
+    int count,
+    GLfloat fps,
+    bool loop);
+
+extern proc bool Load(
+    CFXAnimationRef this,
+    const char* file);
+
+extern proc int FindClip(
+    CFXAnimationRef this,
+    const char* name);
+
+extern proc int AddInstance(
+    CFXAnimationRef this,
+    int clip);
+
+extern proc void RemoveInstance(
+    CFXAnimationRef this,
+    int instance);
+
+extern proc void Play(
+    CFXAnimationRef this,
+    int instance,
+    int clip);
+
+extern proc void Update(
+    CFXAnimationRef this,
+    GLfloat delta);
+
+/**
+ * @brief Creates a new, empty CFXAnimation for a sprite sheet.
+ *
+ * @param texture  Atlas or strip texture the frames are cut from.
+ * @return A reference to the newly created CFXAnimation.
+ */
+static inline CFXAnimationRef NewCFXAnimation(CFXTexture2DRef texture)
+{
+    return Ctor((CFXAnimationRef)CFCreate(CFXAnimation), texture);
+}
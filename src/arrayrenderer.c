@@ -30,6 +30,7 @@ class2(CFXArrayRenderer);
  proc void* Ctor(CFXArrayRendererRef this, CFXShaderRef shader)
 {
     this->shader = shader;
+    this->soft = nullptr;
     CFXArrayRenderer->dtor = &dtor;
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -69,8 +70,8 @@ class2(CFXArrayRenderer);
 static void dtor(void* self)
 {
     CFXArrayRendererRef this = self;
-    glDeleteVertexArrays(1, &this->VAO);
-    glDeleteBuffers(1, &this->VBO);
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
 }
 
 /**
@@ -95,6 +96,11 @@ proc void Draw(
     GLfloat rotate,
     Vec3 color)
 {
+    if (this->soft != nullptr) {
+        Draw(this->soft, texture, (Vec2) { bounds->x, bounds->y }, (Vec2) { bounds->w, bounds->h }, rotate, color, (Vec4) { 0.0f, 0.0f, 1.0f, 1.0f });
+        return;
+    }
+
     // Prepare transformations
     Use(this->shader);
     Mat model = {
@@ -148,6 +154,11 @@ proc void Draw(
     GLfloat rotate,
     Vec3 color)
 {
+    if (this->soft != nullptr) {
+        Draw(this->soft, texture, position, size, rotate, color, (Vec4) { 0.0f, 0.0f, 1.0f, 1.0f });
+        return;
+    }
+
     // Prepare transformations
     Use(this->shader);
     Mat model = {
@@ -7,6 +7,7 @@
 #include "texture2d.h"          // IWYU pragma: keep
 #include "shader.h"
 #include "rect.h"
+#include "softrenderer.h"
 #include "tglm.h"
 
 extern CFClassRef CFXArrayRenderer;
@@ -25,12 +26,14 @@ typedef struct __CFXArrayRenderer* CFXArrayRendererRef;
  * - shader:     Reference to the shader program used for rendering.
  * - VBO:        OpenGL Vertex Buffer Object identifier.
  * - VAO:        OpenGL Vertex Array Object identifier.
+ * - soft:       When set, Draw records into this software renderer instead of GL.
  */
 typedef struct __CFXArrayRenderer {
     __CFObject obj;
     CFXShaderRef shader;
     GLuint VBO;
     GLuint VAO;
+    CFXSoftRendererRef soft;
 } __CFXArrayRenderer;
 
 extern proc void* Ctor(
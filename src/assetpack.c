@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "assetpack.h"
+#if CFX_WITH_LZ4
+#include <lz4.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+class2(CFXAssetPack);
+
+static void Close(CFXAssetPackRef this)
+{
+    if (this->data != nullptr) {
+#if __EMSCRIPTEN__
+        free(this->data);
+#else
+        if (this->mapped)
+            munmap(this->data, this->size);
+        else
+            free(this->data);
+#endif
+    }
+    this->data = nullptr;
+    this->size = 0;
+    this->mapped = false;
+    this->header = nullptr;
+    this->slots = nullptr;
+    this->entries = nullptr;
+}
+
+/**
+ * @brief Destructor for the CFXAssetPack object.
+ *
+ * Pointers handed out by Find are invalid afterwards.
+ *
+ * @param self Pointer to the CFXAssetPack instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXAssetPackRef this = self;
+    Close(this);
+    free(this->path);
+}
+
+/**
+ * @brief Reads or maps the whole file into data.
+ */
+static bool Open(CFXAssetPackRef this)
+{
+    int fd = open(this->path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CFXPackHeader)) {
+        close(fd);
+        return false;
+    }
+    this->size = (size_t)info.st_size;
+#if !__EMSCRIPTEN__
+    void* data = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+        close(fd);
+        this->data = data;
+        this->mapped = true;
+        return true;
+    }
+#endif
+    this->data = malloc(this->size);
+    size_t done = 0;
+    while (done < this->size) {
+        ssize_t n = read(fd, this->data + done, this->size - done);
+        if (n <= 0)
+            break;
+        done += (size_t)n;
+    }
+    close(fd);
+    return done == this->size;
+}
+
+/**
+ * @brief Checks that a decoded image's size matches its dimensions.
+ */
+static bool ValidateImage(const CFXPackEntry* entry)
+{
+    if (entry->channels == 0 || entry->channels > 4)
+        return false;
+    uint64_t pixels = (uint64_t)entry->width * entry->height;
+    return pixels <= UINT64_MAX / entry->channels && pixels * entry->channels == entry->size;
+}
+
+/**
+ * @brief Checks that a compressed entry's blocks can be unpacked, and that this build can unpack them.
+ */
+static bool ValidateBlocks(CFXAssetPackRef this, const CFXPackEntry* entry)
+{
+#if CFX_WITH_LZ4
+    // Blocks are decompressed with int sizes, and counted in a uint32_t
+    uint64_t block = entry->blockSize != 0 ? entry->blockSize : entry->size;
+    if (block > LZ4_MAX_INPUT_SIZE || (entry->size > 0 && (entry->size - 1) / block >= UINT32_MAX))
+        return false;
+    return CFXPack_BlockCount(entry) * sizeof(uint32_t) <= entry->packedSize;
+#else
+    printf("| ERROR::ASSETPACK: %s has LZ4 entries; build with CFX_WITH_LZ4 to read it\n", this->path);
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks that the header and the tables it points to lie within the file.
+ */
+static bool Validate(CFXAssetPackRef this)
+{
+    const CFXPackHeader* header = (const CFXPackHeader*)this->data;
+    if (memcmp(header->magic, CFX_PACK_MAGIC, sizeof(CFX_PACK_MAGIC)) != 0
+        || header->version != CFX_PACK_VERSION
+        || header->size != this->size)
+        return false;
+    if (header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0
+        || header->slotCount < header->entryCount)
+        return false;
+    // Sizes are compared against what is left past each offset, so corrupt
+    // offsets cannot wrap around and pass
+    if (header->slots > this->size
+        || (uint64_t)header->slotCount * sizeof(uint32_t) > this->size - header->slots
+        || header->entries > this->size
+        || (uint64_t)header->entryCount * sizeof(CFXPackEntry) > this->size - header->entries
+        || header->names > this->size)
+        return false;
+    uint64_t names = this->size - header->names;
+    const CFXPackEntry* entries = (const CFXPackEntry*)(this->data + header->entries);
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const CFXPackEntry* entry = &entries[i];
+        if (entry->offset > this->size || entry->packedSize >= this->size - entry->offset
+            || entry->name > names || entry->nameLength >= names - entry->name)
+            return false;
+        if ((entry->flags & CFX_PACK_IMAGE) && !ValidateImage(entry))
+            return false;
+        if ((entry->flags & CFX_PACK_LZ4) == 0 && entry->packedSize != entry->size)
+            return false;
+        if ((entry->flags & CFX_PACK_LZ4) && !ValidateBlocks(this, entry))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Constructor for the CFXAssetPack object.
+ *
+ * @param this  Pointer to the CFXAssetPack instance to initialize.
+ * @param path  Pack file, as written by cfxpack.
+ * @return      Pointer to the initialized CFXAssetPack instance.
+ */
+proc void* Ctor(CFXAssetPackRef this, const char* path)
+{
+    CFXAssetPack->dtor = dtor;
+    this->path = CFStrDup((char*)path);
+    this->data = nullptr;
+    Close(this);
+
+    if (!Open(this)) {
+        printf("| ERROR::ASSETPACK: Failed to read %s\n", path);
+        Close(this);
+        return this;
+    }
+    if (!Validate(this)) {
+        printf("| ERROR::ASSETPACK: %s is not a version %d pack\n", path, CFX_PACK_VERSION);
+        Close(this);
+        return this;
+    }
+    this->header = (const CFXPackHeader*)this->data;
+    this->slots = (const uint32_t*)(this->data + this->header->slots);
+    this->entries = (const CFXPackEntry*)(this->data + this->header->entries);
+    return this;
+}
+
+/**
+ * @brief Reports whether the pack opened and validated.
+ */
+proc bool IsOpen(CFXAssetPackRef this)
+{
+    return this->header != nullptr;
+}
+
+/**
+ * @brief Looks an entry up by name.
+ *
+ * The name hashes straight to its slot, so the cost does not grow with the
+ * number of entries. A leading "./" is ignored, as with embedded files.
+ * Safe on any thread.
+ *
+ * @param this  Reference to the asset pack.
+ * @param name  Path relative to the packed directory.
+ * @return      The entry, valid while the pack is, or nullptr.
+ */
+proc const CFXPackEntry* Lookup(CFXAssetPackRef this, const char* name)
+{
+    if (this->header == nullptr)
+        return nullptr;
+    while (strncmp(name, "./", 2) == 0)
+        name += 2;
+    size_t length = strlen(name);
+    uint64_t hash = CFXPack_Hash(name, length);
+    const char* names = (const char*)this->data + this->header->names;
+    uint32_t mask = this->header->slotCount - 1;
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        uint32_t slot = this->slots[(hash + probe) & mask];
+        if (slot == 0 || slot > this->header->entryCount)
+            return nullptr;
+        const CFXPackEntry* entry = &this->entries[slot - 1];
+        if (entry->hash == hash && entry->nameLength == length
+            && memcmp(names + entry->name, name, length) == 0)
+            return entry;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Looks a file up by name.
+ *
+ * Safe on any thread.
+ *
+ * @param this  Reference to the asset pack.
+ * @param name  Path relative to the packed directory.
+ * @param file  Set to the entry, pointing into the pack, when found.
+ * @return      true if the pack holds the file as is, false for missing
+ *              files and decoded images.
+ */
+proc bool Find(CFXAssetPackRef this, const char* name, CFXEmbeddedFile* file)
+{
+    const CFXPackEntry* entry = Lookup(this, name);
+    if (entry == nullptr || entry->flags != 0)
+        return false;
+    file->name = (const char*)this->data + this->header->names + entry->name;
+    file->data = this->data + entry->offset;
+    file->size = (size_t)entry->size;
+    return true;
+}
+
+/**
+ * @brief Copies or decompresses one block of an entry into place.
+ *
+ * The block lands at its own offset in out, so different blocks may be
+ * unpacked into the same destination from different threads at once.
+ *
+ * @param this   Reference to the asset pack.
+ * @param entry  Entry from Lookup.
+ * @param block  Block index, below CFXPack_BlockCount(entry).
+ * @param out    Destination of entry->size bytes for the whole entry.
+ * @return       false if the block is corrupt.
+ */
+proc bool Unpack(CFXAssetPackRef this, const CFXPackEntry* entry, uint32_t block, void* out)
+{
+    uint32_t count = CFXPack_BlockCount(entry);
+    if (block >= count)
+        return false;
+    uint64_t start = (uint64_t)block * entry->blockSize;
+    uint64_t length = entry->blockSize == 0 ? entry->size : entry->size - start;
+    if (entry->blockSize != 0 && length > entry->blockSize)
+        length = entry->blockSize;
+    const unsigned char* blob = this->data + entry->offset;
+    if ((entry->flags & CFX_PACK_LZ4) == 0) {
+        memcpy((unsigned char*)out + start, blob + start, (size_t)length);
+        return true;
+    }
+
+#if CFX_WITH_LZ4
+    const uint32_t* ends = (const uint32_t*)blob;
+    const char* blocks = (const char*)(ends + count);
+    uint32_t begin = block > 0 ? ends[block - 1] : 0;
+    uint32_t end = ends[block];
+    if (end < begin || count * sizeof(uint32_t) + end > entry->packedSize)
+        return false;
+    int n = LZ4_decompress_safe(blocks + begin, (char*)out + start, (int)(end - begin), (int)length);
+    return n == (int)length;
+#else
+    // Validate turns away packs with LZ4 entries
+    return false;
+#endif
+}
+
+/**
+ * @brief Copies or decompresses a whole entry on the calling thread.
+ *
+ * @param out  Destination of entry->size bytes.
+ * @return     false if the entry is corrupt.
+ */
+proc bool Unpack(CFXAssetPackRef this, const CFXPackEntry* entry, void* out)
+{
+    uint32_t count = CFXPack_BlockCount(entry);
+    for (uint32_t i = 0; i < count; i++)
+        if (!Unpack(this, entry, i, out))
+            return false;
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <corefw.h>   // IWYU pragma: keep
+#include "embedded.h"
+#include "packformat.h"
+
+extern CFClassRef CFXAssetPack;
+typedef struct __CFXAssetPack* CFXAssetPackRef;
+
+/**
+ * @struct __CFXAssetPack
+ * @brief A read-only pack of asset files, in the layout of packformat.h.
+ *
+ * Natively the pack is mapped with mmap, so opening it costs one open and
+ * the pages of an entry are read only when it is used. Under Emscripten,
+ * where the virtual filesystem is in memory anyway, the file is read whole
+ * in one call. Either way Find hands out pointers into the pack, which
+ * stay valid while the pack is referenced, so entries go to
+ * stbi_load_from_memory and the shader compiler without copying.
+ *
+ * Decoded images (CFX_PACK_IMAGE) are not files to Find: Lookup returns
+ * their entry and Unpack copies or decompresses them a block at a time,
+ * so several threads can fill one destination together.
+ *
+ * A pack that fails to open or validate is kept empty: Find finds nothing.
+ *
+ * Members:
+ * - obj:      Base object information for the asset pack.
+ * - path:     File the pack was opened from.
+ * - data:     The pack's contents, or nullptr if it failed to open.
+ * - size:     Length of data in bytes.
+ * - mapped:   data is mapped rather than allocated.
+ * - header:   Header at the start of data.
+ * - slots:    Hashed index.
+ * - entries:  Entry table.
+ */
+typedef struct __CFXAssetPack {
+    __CFObject obj;
+    char* path;
+    unsigned char* data;
+    size_t size;
+    bool mapped;
+    const CFXPackHeader* header;
+    const uint32_t* slots;
+    const CFXPackEntry* entries;
+} __CFXAssetPack;
+
+extern proc void* Ctor(
+    CFXAssetPackRef this,
+    const char* path);
+
+extern proc bool IsOpen(
+    CFXAssetPackRef this);
+
+extern proc const CFXPackEntry* Lookup(
+    CFXAssetPackRef this,
+    const char* name);
+
+extern proc bool Find(
+    CFXAssetPackRef this,
+    const char* name,
+    CFXEmbeddedFile* file);
+
+extern proc bool Unpack(
+    CFXAssetPackRef this,
+    const CFXPackEntry* entry,
+    uint32_t block,
+    void* out);
+
+extern proc bool Unpack(
+    CFXAssetPackRef this,
+    const CFXPackEntry* entry,
+    void* out);
+
+/**
+ * @brief Opens an asset pack.
+ *
+ * @param path  Pack file, as written by cfxpack.
+ * @return A reference to the newly created CFXAssetPack.
+ */
+static inline CFXAssetPackRef NewCFXAssetPack(const char* path)
+{
+    return Ctor((CFXAssetPackRef)CFCreate(CFXAssetPack), path);
+}
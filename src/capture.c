@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include <stb_image_write.h>
+#include "capture.h"
+
+class2(CFXCapture);
+
+/**
+ * Frame rate written to the Y4M header; frames are captured once per Frame
+ * call, so this should match the game's target rate.
+ */
+constexpr int CaptureFramesPerSecond = 60;
+
+static inline unsigned char Clamp8(int value)
+{
+    return (unsigned char)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+/**
+ * @brief Converts a bottom-up RGBA frame to full range BT.601 YUV 4:2:0 and appends it.
+ *
+ * Chroma is the average of each 2x2 block, clamped at odd edges.
+ */
+static void WriteY4MFrame(CFXCaptureRef this, const unsigned char* rgba, unsigned char* yuv)
+{
+    int w = this->width, h = this->height;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    unsigned char* Y = yuv;
+    unsigned char* U = yuv + w * h;
+    unsigned char* V = U + cw * ch;
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char* row = rgba + (size_t)(h - 1 - y) * w * 4;
+        for (int x = 0; x < w; x++) {
+            const unsigned char* p = row + x * 4;
+            Y[y * w + x] = (unsigned char)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+    for (int y = 0; y < ch; y++) {
+        for (int x = 0; x < cw; x++) {
+            int r = 0, g = 0, b = 0;
+            for (int j = 0; j < 2; j++) {
+                int sy = h - 1 - (y * 2 + j < h ? y * 2 + j : h - 1);
+                for (int i = 0; i < 2; i++) {
+                    int sx = x * 2 + i < w ? x * 2 + i : w - 1;
+                    const unsigned char* p = rgba + ((size_t)sy * w + sx) * 4;
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+            U[y * cw + x] = Clamp8((-43 * r - 85 * g + 128 * b + 4 * 128 * 256 + 512) >> 10);
+            V[y * cw + x] = Clamp8((128 * r - 107 * g - 21 * b + 4 * 128 * 256 + 512) >> 10);
+        }
+    }
+    fputs("FRAME\n", this->file);
+    fwrite(yuv, 1, (size_t)w * h + 2 * (size_t)cw * ch, this->file);
+}
+
+/**
+ * @brief Writer thread: encodes queued frames until Stop drains the queue.
+ */
+static void* Writer(void* arg)
+{
+    CFXCaptureRef this = arg;
+    unsigned char* yuv = nullptr;
+    if (this->format == CFX_CAPTURE_Y4M)
+        yuv = malloc((size_t)this->width * this->height * 2);
+    else
+        stbi_flip_vertically_on_write(1);
+    char name[1024];
+
+    pthread_mutex_lock(&this->lock);
+    while (true) {
+        while (this->queueCount == 0 && this->running)
+            pthread_cond_wait(&this->ready, &this->lock);
+        if (this->queueCount == 0)
+            break;
+        CFXCaptureFrame frame = this->queue[0];
+        memmove(this->queue, this->queue + 1, --this->queueCount * sizeof(CFXCaptureFrame));
+        pthread_mutex_unlock(&this->lock);
+
+        if (this->format == CFX_CAPTURE_Y4M)
+            WriteY4MFrame(this, frame.pixels, yuv);
+        else {
+            snprintf(name, sizeof(name), this->path, frame.number);
+            if (!stbi_write_png(name, this->width, this->height, 4, frame.pixels, this->width * 4))
+                printf("| ERROR::CAPTURE: Failed to write %s\n", name);
+        }
+        free(frame.pixels);
+
+        pthread_mutex_lock(&this->lock);
+        this->written++;
+    }
+    pthread_mutex_unlock(&this->lock);
+    free(yuv);
+    return nullptr;
+}
+
+/**
+ * @brief Constructor for the CFXCapture object.
+ *
+ * Opens the output, allocates the pixel buffer ring and starts the writer thread.
+ *
+ * @param this    Pointer to the CFXCapture instance to initialize.
+ * @param width   Width of the captured region.
+ * @param height  Height of the captured region.
+ * @param path    Y4M file name or PNG file name pattern.
+ * @param format  Output format.
+ * @return        Pointer to the initialized CFXCapture instance.
+ */
+proc void* Ctor(CFXCaptureRef this, int width, int height, const char* path, CFXCaptureFormat format)
+{
+    CFXCapture->dtor = dtor;
+    this->width = width;
+    this->height = height;
+    this->format = format;
+    this->path = CFStrDup((char*)path);
+    this->file = nullptr;
+    this->head = 0;
+    this->pending = 0;
+    this->queueCount = 0;
+    this->frames = 0;
+    this->written = 0;
+    this->dropped = 0;
+    this->running = false;
+    memset(this->PBO, 0, sizeof(this->PBO));
+    memset(this->fences, 0, sizeof(this->fences));
+    pthread_mutex_init(&this->lock, nullptr);
+    pthread_cond_init(&this->ready, nullptr);
+
+#if __EMSCRIPTEN__
+    printf("| ERROR::CAPTURE: Not supported on the web build\n");
+#else
+    if (format == CFX_CAPTURE_Y4M) {
+        this->file = fopen(path, "wb");
+        if (this->file == nullptr) {
+            printf("| ERROR::CAPTURE: Failed to open %s\n", path);
+            return this;
+        }
+        fprintf(this->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, CaptureFramesPerSecond);
+    }
+
+    glGenBuffers(CFX_CAPTURE_RING, this->PBO);
+    for (int i = 0; i < CFX_CAPTURE_RING; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->PBO[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    this->running = true;
+    pthread_create(&this->thread, nullptr, Writer, this);
+#endif
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXCapture object.
+ *
+ * Stops the capture if still running, which flushes every pending frame.
+ *
+ * @param self Pointer to the CFXCapture instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXCaptureRef this = self;
+    Stop(this);
+    pthread_cond_destroy(&this->ready);
+    pthread_mutex_destroy(&this->lock);
+    free(this->path);
+}
+
+#ifndef __EMSCRIPTEN__
+/**
+ * @brief Hands finished readbacks to the writer thread, oldest first.
+ *
+ * Stops at the first buffer whose copy the GPU has not completed, unless
+ * block is set, as when flushing on Stop.
+ */
+static void Harvest(CFXCaptureRef this, bool block)
+{
+    size_t size = (size_t)this->width * this->height * 4;
+    while (this->pending > 0) {
+        GLsync fence = this->fences[this->head];
+        if (block) {
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                continue;
+        } else if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(fence);
+        this->fences[this->head] = nullptr;
+
+        pthread_mutex_lock(&this->lock);
+        bool room = this->queueCount < CFX_CAPTURE_QUEUE;
+        pthread_mutex_unlock(&this->lock);
+
+        void* mapped = nullptr;
+        if (room) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->PBO[this->head]);
+            mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        }
+        // A failed map leaves nothing to encode, so the frame is skipped
+        if (mapped != nullptr) {
+            CFXCaptureFrame frame = { .pixels = malloc(size), .number = this->frames - this->pending };
+            memcpy(frame.pixels, mapped, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            pthread_mutex_lock(&this->lock);
+            this->queue[this->queueCount++] = frame;
+            pthread_cond_signal(&this->ready);
+            pthread_mutex_unlock(&this->lock);
+        } else
+            this->dropped++;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        this->head = (this->head + 1) % CFX_CAPTURE_RING;
+        this->pending--;
+    }
+}
+#endif
+
+/**
+ * @brief Captures the current contents of the framebuffer.
+ *
+ * Call once per frame after drawing and before swapping buffers. Only
+ * queues GPU work and copies out readbacks that have already completed.
+ *
+ * @param this Reference to the capture.
+ */
+proc void Frame(CFXCaptureRef this)
+{
+#ifndef __EMSCRIPTEN__
+    if (!this->running)
+        return;
+    Harvest(this, false);
+    if (this->pending == CFX_CAPTURE_RING) {
+        this->dropped++;
+        return;
+    }
+    int slot = (this->head + this->pending) % CFX_CAPTURE_RING;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, this->PBO[slot]);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->pending++;
+    this->frames++;
+#endif
+}
+
+/**
+ * @brief Finishes the capture.
+ *
+ * Waits for the readbacks still in flight, lets the writer thread encode
+ * everything queued and closes the output.
+ *
+ * @param this Reference to the capture.
+ */
+proc void Stop(CFXCaptureRef this)
+{
+#ifndef __EMSCRIPTEN__
+    if (!this->running)
+        return;
+    Harvest(this, true);
+
+    pthread_mutex_lock(&this->lock);
+    this->running = false;
+    pthread_cond_broadcast(&this->ready);
+    pthread_mutex_unlock(&this->lock);
+    pthread_join(this->thread, nullptr);
+
+    CFXDeletionQueue_Buffers(CFX_CAPTURE_RING, this->PBO);
+    if (this->file != nullptr)
+        fclose(this->file);
+    this->file = nullptr;
+    printf("| CAPTURE: %d frames written, %d dropped\n", this->written, this->dropped);
+#endif
+}
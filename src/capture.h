@@ -0,0 +1,125 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <corefw.h>   // IWYU pragma: keep
+
+extern CFClassRef CFXCapture;
+typedef struct __CFXCapture* CFXCaptureRef;
+
+/**
+ * Number of pixel buffers frames are read into. A buffer is mapped at the
+ * earliest CFX_CAPTURE_RING - 1 frames after its readback was issued.
+ */
+#define CFX_CAPTURE_RING 3
+
+/**
+ * Frames waiting for the writer thread beyond this are dropped.
+ */
+#define CFX_CAPTURE_QUEUE 8
+
+/**
+ * @enum CFXCaptureFormat
+ * @brief Output of a capture.
+ *
+ * - CFX_CAPTURE_Y4M: One raw YUV 4:2:0 video stream; path names the file.
+ * - CFX_CAPTURE_PNG: One image per frame; path is a printf pattern taking the frame number.
+ */
+typedef enum CFXCaptureFormat {
+    CFX_CAPTURE_Y4M,
+    CFX_CAPTURE_PNG,
+} CFXCaptureFormat;
+
+/**
+ * @struct CFXCaptureFrame
+ * @brief A frame copied out of a pixel buffer, queued for the writer thread.
+ */
+typedef struct CFXCaptureFrame {
+    unsigned char* pixels;
+    int number;
+} CFXCaptureFrame;
+
+/**
+ * @struct __CFXCapture
+ * @brief Records the framebuffer without stalling the render thread.
+ *
+ * Frame calls glReadPixels into the next pixel buffer object of a ring and
+ * fences it, which only queues a copy on the GPU. Buffers are mapped once
+ * their fence has signaled, which by then costs a memcpy instead of a
+ * pipeline flush, and the pixels are handed to a writer thread that encodes
+ * them. When every buffer is still in flight or the writer has fallen
+ * behind, the frame is dropped and counted rather than waited for.
+ *
+ * Capture relies on buffer mapping and threads, so it is native only; on
+ * Emscripten the constructor reports an error and Frame does nothing.
+ *
+ * Members:
+ * - obj:        Base object information for the capture.
+ * - width, height: Size of the captured region, from the origin of the framebuffer.
+ * - format:     Output format.
+ * - path:       Output file, or file name pattern for PNG sequences.
+ * - file:       Open Y4M stream.
+ * - PBO:        Ring of pixel pack buffers.
+ * - fences:     Fence of the readback pending in each buffer, or nullptr.
+ * - head:       Oldest pending buffer.
+ * - pending:    Number of buffers with a readback in flight.
+ * - queue:      Frames waiting for the writer thread.
+ * - queueCount: Number of queued frames.
+ * - frames:     Frames read back so far, also the next frame number.
+ * - written:    Frames the writer thread has finished.
+ * - dropped:    Frames skipped because the ring or the queue was full, or
+ *               their readback could not be mapped.
+ * - running:    Cleared by Stop to end the writer thread.
+ * - thread, lock, ready: Writer thread and its queue synchronization.
+ */
+typedef struct __CFXCapture {
+    __CFObject obj;
+    int width;
+    int height;
+    CFXCaptureFormat format;
+    char* path;
+    FILE* file;
+    GLuint PBO[CFX_CAPTURE_RING];
+    GLsync fences[CFX_CAPTURE_RING];
+    int head;
+    int pending;
+    CFXCaptureFrame queue[CFX_CAPTURE_QUEUE];
+    int queueCount;
+    int frames;
+    int written;
+    int dropped;
+    bool running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} __CFXCapture;
+
+extern proc void* Ctor(
+    CFXCaptureRef this,
+    int width,
+    int height,
+    const char* path,
+    CFXCaptureFormat format);
+
+extern proc void Frame(
+    CFXCaptureRef this);
+
+extern proc void Stop(
+    CFXCaptureRef this);
+
+/**
+ * @brief Starts capturing to a file or a numbered image sequence.
+ *
+ * @param width   Width of the region to capture, normally the framebuffer width.
+ * @param height  Height of the region to capture.
+ * @param path    Y4M file name, or a PNG pattern such as "capture/%05d.png".
+ * @param format  CFX_CAPTURE_Y4M or CFX_CAPTURE_PNG.
+ * @return A reference to the newly created CFXCapture.
+ */
+static inline CFXCaptureRef NewCFXCapture(int width, int height, const char* path, CFXCaptureFormat format)
+{
+    return Ctor((CFXCaptureRef)CFCreate(CFXCapture), width, height, path, format);
+}
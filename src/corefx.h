@@ -7,6 +7,29 @@
 #include "resourcemanager.h"        // IWYU pragma: keep
 #include "arrayrenderer.h"          // IWYU pragma: keep
 #include "elementrenderer.h"        // IWYU pragma: keep
+#include "particlesystem.h"         // IWYU pragma: keep
+#include "gpuparticlesystem.h"      // IWYU pragma: keep
+#include "uinode.h"                 // IWYU pragma: keep
+#include "uilayer.h"                // IWYU pragma: keep
+#include "rendertarget.h"           // IWYU pragma: keep
+#include "framegraph.h"             // IWYU pragma: keep
+#include "postprocess.h"            // IWYU pragma: keep
+#include "lighting.h"               // IWYU pragma: keep
+#include "resolutionscaler.h"       // IWYU pragma: keep
+#include "capture.h"                // IWYU pragma: keep
+#include "animation.h"              // IWYU pragma: keep
+#include "skeleton.h"               // IWYU pragma: keep
+#include "skeletonbatch.h"          // IWYU pragma: keep
+#include "path.h"                   // IWYU pragma: keep
+#include "pathrenderer.h"           // IWYU pragma: keep
+#include "virtualtexture.h"         // IWYU pragma: keep
+#include "softrenderer.h"           // IWYU pragma: keep
+#include "deletionqueue.h"          // IWYU pragma: keep
+#include "embedded.h"               // IWYU pragma: keep
+#include "textureloader.h"          // IWYU pragma: keep
+#include "stagingpool.h"            // IWYU pragma: keep
+#include "loadercontext.h"          // IWYU pragma: keep
+#include "assetpack.h"              // IWYU pragma: keep
 #include "shader.h"                 // IWYU pragma: keep
 #include "texture2d.h"              // IWYU pragma: keep
 #include "tglm.h"                   // IWYU pragma: keep
@@ -0,0 +1,179 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "deletionqueue.h"
+
+typedef enum DeletionKind {
+    KindBuffer,
+    KindVertexArray,
+    KindTexture,
+    KindFramebuffer,
+    KindProgram,
+    KindShader,
+    KindCount,
+} DeletionKind;
+
+/**
+ * Names of each kind waiting on one fence.
+ */
+typedef struct DeletionBatch {
+    GLsync fence;
+    GLuint* names[KindCount];
+    int count[KindCount];
+    int capacity[KindCount];
+} DeletionBatch;
+
+/**
+ * PendingBatch is filled from any thread under Lock; Retired is only touched on
+ * the GL thread, oldest batch first.
+ */
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static DeletionBatch PendingBatch;
+static DeletionBatch* Retired;
+static int RetiredCount;
+static int RetiredCapacity;
+
+static void Enqueue(DeletionKind kind, GLsizei count, const GLuint* names)
+{
+    pthread_mutex_lock(&Lock);
+    int needed = PendingBatch.count[kind] + count;
+    if (needed > PendingBatch.capacity[kind]) {
+        int capacity = PendingBatch.capacity[kind] ? PendingBatch.capacity[kind] : 64;
+        while (capacity < needed)
+            capacity *= 2;
+        PendingBatch.names[kind] = realloc(PendingBatch.names[kind], capacity * sizeof(GLuint));
+        PendingBatch.capacity[kind] = capacity;
+    }
+    for (int i = 0; i < count; i++)
+        if (names[i] != 0)
+            PendingBatch.names[kind][PendingBatch.count[kind]++] = names[i];
+    pthread_mutex_unlock(&Lock);
+}
+
+/**
+ * @brief Queues buffer names for deletion.
+ */
+void CFXDeletionQueue_Buffers(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindBuffer, count, names);
+}
+
+/**
+ * @brief Queues vertex array names for deletion.
+ */
+void CFXDeletionQueue_VertexArrays(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindVertexArray, count, names);
+}
+
+/**
+ * @brief Queues texture names for deletion.
+ */
+void CFXDeletionQueue_Textures(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindTexture, count, names);
+}
+
+/**
+ * @brief Queues framebuffer names for deletion.
+ */
+void CFXDeletionQueue_Framebuffers(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindFramebuffer, count, names);
+}
+
+/**
+ * @brief Queues program names for deletion.
+ */
+void CFXDeletionQueue_Programs(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindProgram, count, names);
+}
+
+/**
+ * @brief Queues shader names for deletion.
+ */
+void CFXDeletionQueue_Shaders(GLsizei count, const GLuint* names)
+{
+    Enqueue(KindShader, count, names);
+}
+
+/**
+ * @brief Closes the pending batch behind a fence placed after the commands issued so far.
+ *
+ * Call on the GL thread once the frame's draw calls have been issued.
+ */
+void CFXDeletionQueue_Retire(void)
+{
+    pthread_mutex_lock(&Lock);
+    bool empty = true;
+    for (int k = 0; k < KindCount; k++)
+        empty = empty && PendingBatch.count[k] == 0;
+    if (empty) {
+        pthread_mutex_unlock(&Lock);
+        return;
+    }
+    DeletionBatch batch = PendingBatch;
+    memset(&PendingBatch, 0, sizeof(PendingBatch));
+    pthread_mutex_unlock(&Lock);
+
+    batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (RetiredCount == RetiredCapacity) {
+        RetiredCapacity = RetiredCapacity ? RetiredCapacity * 2 : 8;
+        Retired = realloc(Retired, RetiredCapacity * sizeof(DeletionBatch));
+    }
+    Retired[RetiredCount++] = batch;
+}
+
+static void Delete(DeletionBatch* batch)
+{
+    if (batch->count[KindBuffer])
+        glDeleteBuffers(batch->count[KindBuffer], batch->names[KindBuffer]);
+    if (batch->count[KindVertexArray])
+        glDeleteVertexArrays(batch->count[KindVertexArray], batch->names[KindVertexArray]);
+    if (batch->count[KindTexture])
+        glDeleteTextures(batch->count[KindTexture], batch->names[KindTexture]);
+    if (batch->count[KindFramebuffer])
+        glDeleteFramebuffers(batch->count[KindFramebuffer], batch->names[KindFramebuffer]);
+    for (int i = 0; i < batch->count[KindProgram]; i++)
+        glDeleteProgram(batch->names[KindProgram][i]);
+    for (int i = 0; i < batch->count[KindShader]; i++)
+        glDeleteShader(batch->names[KindShader][i]);
+    for (int k = 0; k < KindCount; k++)
+        free(batch->names[k]);
+    if (batch->fence != nullptr)
+        glDeleteSync(batch->fence);
+}
+
+/**
+ * @brief Deletes the names of every retired batch the GPU is done with.
+ *
+ * Call on the GL thread. Batches are checked oldest first and checking
+ * stops at the first unsignaled fence, since later ones cannot have
+ * signaled before it.
+ *
+ * @param wait  Retire the pending batch and block until everything queued
+ *              is deleted, as before destroying the context.
+ */
+void CFXDeletionQueue_Collect(bool wait)
+{
+    if (wait) {
+        CFXDeletionQueue_Retire();
+        glFinish();
+    }
+    int done = 0;
+    while (done < RetiredCount) {
+        GLsync fence = Retired[done].fence;
+        if (!wait && fence != nullptr && glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+        Delete(&Retired[done++]);
+    }
+    RetiredCount -= done;
+    memmove(Retired, Retired + done, RetiredCount * sizeof(DeletionBatch));
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+
+/**
+ * Deferred deletion of GL object names.
+ *
+ * Destructors hand their names to the queue instead of calling glDelete*
+ * themselves, so the last CFUnref may happen mid-frame or on any thread.
+ * The queue collects names into a pending batch under a mutex. Once per
+ * frame CFXGame::Tick retires the pending batch behind a fence, and
+ * RunLoop deletes every retired batch whose fence has signaled, one
+ * glDelete* call per kind, when the GPU can no longer be using them.
+ *
+ * Programs without a CFXGame loop call CFXDeletionQueue_Retire and
+ * CFXDeletionQueue_Collect themselves, or CFXDeletionQueue_Collect(true)
+ * before destroying the context.
+ */
+
+extern void CFXDeletionQueue_Buffers(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_VertexArrays(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_Textures(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_Framebuffers(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_Programs(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_Shaders(
+    GLsizei count,
+    const GLuint* names);
+
+extern void CFXDeletionQueue_Retire(void);
+
+extern void CFXDeletionQueue_Collect(
+    bool wait);
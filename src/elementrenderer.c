@@ -32,6 +32,7 @@ proc void* Ctor(CFXElementRendererRef this, CFXShaderRef shader)
 {
     CFXElementRenderer->dtor = dtor;
     this->shader = shader;
+    this->soft = nullptr;
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
     float vertices[] = {
@@ -79,9 +80,9 @@ proc void* Ctor(CFXElementRendererRef this, CFXShaderRef shader)
 static void dtor(void* self)
 {
     CFXElementRendererRef this = self;
-    glDeleteVertexArrays(1, &this->VAO);
-    glDeleteBuffers(1, &this->VBO);
-    glDeleteBuffers(1, &this->EBO);
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
+    CFXDeletionQueue_Buffers(1, &this->EBO);
 }
 
 /**
@@ -104,6 +105,11 @@ proc void Draw(
     GLfloat rotate,
     Vec3 color)
 {
+    if (this->soft != nullptr) {
+        Draw(this->soft, texture, (Vec2) { bounds.x, bounds.y }, (Vec2) { bounds.w, bounds.h }, rotate, color, (Vec4) { 0.0f, 0.0f, 1.0f, 1.0f });
+        return;
+    }
+
     // Prepare transformations
 
     Vec3 size = { bounds.w, bounds.h, 1 };
@@ -121,9 +127,12 @@ proc void Draw(
     model = glm_translate(model, (Vec3) { -0.5f * size.x, -0.5f * size.y, 0.0f }); // Move origin back
     model = glm_scale(model, (Vec3) { size.x, size.y, 1.0f }); // Last scale
 
+    // The whole texture, not the atlas frame a Vec2 draw left behind
+    Vec4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f };
     Use(this->shader);
     SetMatrix(this->shader, "model", &model); //, true);
     SetVector3v(this->shader, "spriteColor", &color, true);
+    SetVector4v(this->shader, "spriteRect", &uvRect);
     glActiveTexture(GL_TEXTURE0);
     Bind(texture);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -133,9 +142,7 @@ proc void Draw(
 /**
  * @brief Draws a textured quad (sprite) with specified transformations and color.
  *
- * This function prepares the transformation matrix for a 2D element, applying translation,
- * rotation (around the center), and scaling in the correct order. It then sets up the shader,
- * passes the transformation matrix and color, binds the texture, and issues a draw call.
+ * Draws the whole texture; see the overload taking a uvRect for atlas frames.
  *
  * @param this      Reference to the element renderer.
  * @param texture   Reference to the texture to be drawn.
@@ -152,6 +159,39 @@ proc void Draw(
     GLfloat rotate,
     Vec3 color)
 {
+    Draw(this, texture, position, size, rotate, color, (Vec4) { 0.0f, 0.0f, 1.0f, 1.0f });
+}
+
+/**
+ * @brief Draws a region of a texture, such as one frame of a sprite sheet.
+ *
+ * This function prepares the transformation matrix for a 2D element, applying translation,
+ * rotation (around the center), and scaling in the correct order. The region is passed to
+ * the shader as the "spriteRect" uniform, which maps the quad's texture coordinates with
+ * spriteRect.xy + texCoords * spriteRect.zw.
+ *
+ * @param this      Reference to the element renderer.
+ * @param texture   Reference to the texture to be drawn.
+ * @param position  Position (x, y) where the quad will be drawn.
+ * @param size      Size (width, height) of the quad.
+ * @param rotate    Rotation angle (in radians) to apply to the quad.
+ * @param color     Color (RGB) to tint the sprite.
+ * @param uvRect    Region of the texture in uv space: offset (x, y) and size (z, w).
+ */
+proc void Draw(
+    CFXElementRendererRef this,
+    CFXTexture2DRef texture,
+    Vec2 position,
+    Vec2 size,
+    GLfloat rotate,
+    Vec3 color,
+    Vec4 uvRect)
+{
+    if (this->soft != nullptr) {
+        Draw(this->soft, texture, position, size, rotate, color, uvRect);
+        return;
+    }
+
     // Prepare transformations
 
     Mat model = {
@@ -170,8 +210,8 @@ proc void Draw(
     Use(this->shader);
     SetMatrix(this->shader, "model", &model); //, true);
     SetVector3v(this->shader, "spriteColor", &color, true);
+    SetVector4v(this->shader, "spriteRect", &uvRect);
     glActiveTexture(GL_TEXTURE0);
     Bind(texture);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
-
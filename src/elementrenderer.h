@@ -6,6 +6,7 @@
 #include <corefw.h>       // IWYU pragma: keep
 #include "corefx.h"                 // IWYU pragma: keep
 #include "rect.h"
+#include "softrenderer.h"
 #include "texture2d.h"
 #include "tglm.h"
 
@@ -26,6 +27,7 @@ typedef struct __CFXElementRenderer* CFXElementRendererRef;
  * - VBO:        OpenGL Vertex Buffer Object identifier.
  * - VAO:        OpenGL Vertex Array Object identifier.
  * - EBO:        OpenGL Element Buffer Object identifier.
+ * - soft:       When set, Draw records into this software renderer instead of GL.
  */
 typedef struct __CFXElementRenderer {
     __CFObject obj;
@@ -33,6 +35,7 @@ typedef struct __CFXElementRenderer {
     GLuint VBO;
     GLuint VAO;
     GLuint EBO;
+    CFXSoftRendererRef soft;
 } __CFXElementRenderer;
 
 extern proc void* Ctor(
@@ -54,6 +57,15 @@ extern proc void Draw(
     GLfloat rotate, 
     Vec3 color);
 
+extern proc void Draw(
+    CFXElementRendererRef this,
+    CFXTexture2DRef texture,
+    Vec2 position,
+    Vec2 size,
+    GLfloat rotate,
+    Vec3 color,
+    Vec4 uvRect);
+
 /**
  * @brief Creates a new CFXElementRenderer instance using the specified shader.
  *
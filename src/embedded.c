@@ -0,0 +1,24 @@
+#include <stdlib.h>
+#include <string.h>
+#include "embedded.h"
+
+static int CompareName(const void* name, const void* file)
+{
+    return strcmp(name, ((const CFXEmbeddedFile*)file)->name);
+}
+
+/**
+ * @brief Finds an embedded file by path.
+ *
+ * A leading "./" is ignored, so "./shaders/sprite.vs" and
+ * "shaders/sprite.vs" name the same file.
+ *
+ * @param name  Path relative to CFX_EMBED_ROOT.
+ * @return The file, or nullptr if it was not embedded.
+ */
+const CFXEmbeddedFile* CFXEmbedded_Find(const char* name)
+{
+    while (strncmp(name, "./", 2) == 0)
+        name += 2;
+    return bsearch(name, CFXEmbeddedFiles, CFXEmbeddedFileCount, sizeof(CFXEmbeddedFile), CompareName);
+}
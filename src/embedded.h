@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+
+/**
+ * Files compiled into the binary by the CFX_EMBED_FILES step in
+ * CMakeLists.txt.
+ *
+ * Each file is a static array in read-only data, named by its path
+ * relative to CFX_EMBED_ROOT and followed by a NUL byte, so text files can
+ * be used as C strings in place. CFXResourceManager looks files up here
+ * before touching the filesystem, which saves the file I/O natively and
+ * the preload bundle fetch under Emscripten.
+ */
+
+/**
+ * @struct CFXEmbeddedFile
+ * @brief One embedded file.
+ *
+ * Members:
+ * - name:  Path relative to CFX_EMBED_ROOT, with '/' separators.
+ * - data:  Contents, followed by a NUL byte not counted in size.
+ * - size:  Length of the contents in bytes.
+ */
+typedef struct CFXEmbeddedFile {
+    const char* name;
+    const unsigned char* data;
+    size_t size;
+} CFXEmbeddedFile;
+
+/** Embedded files, sorted by name; generated into the build directory. */
+extern const CFXEmbeddedFile CFXEmbeddedFiles[];
+extern const int CFXEmbeddedFileCount;
+
+extern const CFXEmbeddedFile* CFXEmbedded_Find(
+    const char* name);
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "framegraph.h"
+
+class2(CFXFrameGraph);
+
+/**
+ * Pooled targets that have not been used for this many frames are released.
+ */
+constexpr int RetireAfterFrames = 120;
+
+/**
+ * @brief Returns the size in bytes of a render target of the given format.
+ */
+static size_t TargetBytes(int width, int height, GLuint format)
+{
+    int bpp = format == GL_RGBA16F ? 8 : format == GL_R8 ? 1 : 4;
+    return (size_t)width * (size_t)height * bpp;
+}
+
+/**
+ * @brief Constructor for the CFXFrameGraph object.
+ *
+ * @param this Pointer to the CFXFrameGraph instance to initialize.
+ * @return     Pointer to the initialized CFXFrameGraph instance.
+ */
+proc void* Ctor(CFXFrameGraphRef this)
+{
+    CFXFrameGraph->dtor = dtor;
+    this->passes = nullptr;
+    this->passCount = 0;
+    this->passCapacity = 0;
+    this->resources = nullptr;
+    this->resourceCount = 0;
+    this->resourceCapacity = 0;
+    this->order = nullptr;
+    this->orderCount = 0;
+    this->pool = nullptr;
+    this->poolCount = 0;
+    this->poolCapacity = 0;
+    this->frame = 0;
+    this->bytesRequested = 0;
+    this->bytesAllocated = 0;
+    this->bytesSaved = 0;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXFrameGraph object.
+ *
+ * Releases the pooled render targets and the per-frame arrays.
+ *
+ * @param self Pointer to the CFXFrameGraph instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXFrameGraphRef this = self;
+    for (int i = 0; i < this->poolCount; i++)
+        CFUnref(this->pool[i].target);
+    free(this->pool);
+    free(this->passes);
+    free(this->resources);
+    free(this->order);
+}
+
+/**
+ * @brief Forgets every pass and resource declared for the previous frame.
+ *
+ * Pooled render targets are kept so the next frame can reuse them.
+ *
+ * @param this Reference to the frame graph.
+ */
+proc void Reset(CFXFrameGraphRef this)
+{
+    this->passCount = 0;
+    this->resourceCount = 0;
+    this->orderCount = 0;
+    this->frame++;
+}
+
+/**
+ * @brief Appends a resource declaration and returns its handle.
+ */
+static int AddResource(CFXFrameGraphRef this, CFXFrameResource resource)
+{
+    if (this->resourceCount == this->resourceCapacity) {
+        this->resourceCapacity = this->resourceCapacity ? this->resourceCapacity * 2 : 16;
+        this->resources = realloc(this->resources, this->resourceCapacity * sizeof(CFXFrameResource));
+    }
+    this->resources[this->resourceCount] = resource;
+    return this->resourceCount++;
+}
+
+/**
+ * @brief Declares a transient texture that lives only within this frame.
+ *
+ * @param this    Reference to the frame graph.
+ * @param name    Debug name; must outlive the frame (string literals are fine).
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ * @param format  Sized internal format, see CFXRenderTarget.
+ * @return        Handle of the resource.
+ */
+proc int CreateTexture(CFXFrameGraphRef this, const char* name, int width, int height, GLuint format)
+{
+    return AddResource(this, (CFXFrameResource) {
+        .name = name, .width = width, .height = height, .format = format,
+        .imported = false, .target = nullptr, .producer = -1 });
+}
+
+/**
+ * @brief Declares a render target owned outside the graph, such as the window.
+ *
+ * Imported resources are outputs of the frame: passes writing them are never culled.
+ *
+ * @param this    Reference to the frame graph.
+ * @param name    Debug name; must outlive the frame.
+ * @param target  The render target, or nullptr for the default framebuffer.
+ * @return        Handle of the resource.
+ */
+proc int Import(CFXFrameGraphRef this, const char* name, CFXRenderTargetRef target)
+{
+    return AddResource(this, (CFXFrameResource) {
+        .name = name,
+        .width = target ? target->width : 0,
+        .height = target ? target->height : 0,
+        .imported = true, .target = target, .producer = -1 });
+}
+
+/**
+ * @brief Declares a render pass and returns its handle.
+ *
+ * @param this      Reference to the frame graph.
+ * @param name      Debug name; must outlive the frame.
+ * @param execute   Callback recording the pass's GL commands.
+ * @param userData  Passed back to execute.
+ * @return          Handle of the pass.
+ */
+proc int AddPass(CFXFrameGraphRef this, const char* name, CFXFramePassProc execute, void* userData)
+{
+    if (this->passCount == this->passCapacity) {
+        this->passCapacity = this->passCapacity ? this->passCapacity * 2 : 16;
+        this->passes = realloc(this->passes, this->passCapacity * sizeof(CFXFramePass));
+    }
+    this->passes[this->passCount] = (CFXFramePass) { .name = name, .execute = execute, .userData = userData };
+    return this->passCount++;
+}
+
+/**
+ * @brief Declares that a pass samples a resource.
+ */
+proc void Read(CFXFrameGraphRef this, int pass, int resource)
+{
+    CFXFramePass* p = &this->passes[pass];
+    assert(p->readCount < CFX_FRAMEGRAPH_MAX_IO);
+    p->reads[p->readCount++] = resource;
+}
+
+/**
+ * @brief Declares that a pass renders into a resource.
+ *
+ * A resource has a single producer; a later Write replaces the earlier one.
+ */
+proc void Write(CFXFrameGraphRef this, int pass, int resource)
+{
+    CFXFramePass* p = &this->passes[pass];
+    assert(p->writeCount < CFX_FRAMEGRAPH_MAX_IO);
+    p->writes[p->writeCount++] = resource;
+    this->resources[resource].producer = pass;
+}
+
+/**
+ * @brief Culls unused passes, orders the rest and assigns physical targets.
+ *
+ * Culling counts, for every pass, the resources it writes and, for every
+ * resource, the passes that read it. Transient resources nobody reads are
+ * popped off a stack and decrement their producer; a producer reaching zero
+ * is culled and releases its own inputs in turn. Passes that write nothing
+ * are treated as having side effects and always run.
+ *
+ * The surviving passes are scheduled in declaration order, deferring any
+ * pass whose inputs are produced by a pass not yet scheduled. Finally each
+ * transient resource takes the first pooled target with the same size and
+ * format whose previous user finished before the resource's first use.
+ *
+ * @param this Reference to the frame graph.
+ */
+proc void Compile(CFXFrameGraphRef this)
+{
+    int scratch = Max(this->passCount, this->resourceCount);
+    this->order = realloc(this->order, Max(scratch, 1) * sizeof(int));
+
+    for (int r = 0; r < this->resourceCount; r++) {
+        this->resources[r].readers = 0;
+        this->resources[r].firstUse = -1;
+        this->resources[r].lastUse = -1;
+    }
+    for (int p = 0; p < this->passCount; p++) {
+        CFXFramePass* pass = &this->passes[p];
+        pass->refCount = pass->writeCount;
+        pass->culled = false;
+        pass->scheduled = false;
+        for (int i = 0; i < pass->readCount; i++)
+            this->resources[pass->reads[i]].readers++;
+    }
+
+    // Cull, using order as the work stack.
+    int top = 0;
+    for (int r = 0; r < this->resourceCount; r++)
+        if (!this->resources[r].imported && this->resources[r].readers == 0)
+            this->order[top++] = r;
+    while (top > 0) {
+        int producer = this->resources[this->order[--top]].producer;
+        if (producer < 0)
+            continue;
+        CFXFramePass* pass = &this->passes[producer];
+        if (--pass->refCount > 0)
+            continue;
+        pass->culled = true;
+        for (int i = 0; i < pass->readCount; i++) {
+            CFXFrameResource* input = &this->resources[pass->reads[i]];
+            if (--input->readers == 0 && !input->imported)
+                this->order[top++] = pass->reads[i];
+        }
+    }
+
+    // Schedule.
+    this->orderCount = 0;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int p = 0; p < this->passCount; p++) {
+            CFXFramePass* pass = &this->passes[p];
+            if (pass->culled || pass->scheduled)
+                continue;
+            bool ready = true;
+            for (int i = 0; i < pass->readCount && ready; i++) {
+                int producer = this->resources[pass->reads[i]].producer;
+                ready = producer < 0 || producer == p || this->passes[producer].scheduled;
+            }
+            if (!ready)
+                continue;
+            pass->scheduled = true;
+            this->order[this->orderCount++] = p;
+            progress = true;
+        }
+    }
+    for (int p = 0; p < this->passCount; p++) {
+        if (!this->passes[p].culled && !this->passes[p].scheduled) {
+            printf("| ERROR::FRAMEGRAPH: Dependency cycle at pass %s\n", this->passes[p].name);
+            this->passes[p].scheduled = true;
+            this->order[this->orderCount++] = p;
+        }
+    }
+
+    // Lifetimes, in execution order.
+    for (int i = 0; i < this->orderCount; i++) {
+        CFXFramePass* pass = &this->passes[this->order[i]];
+        for (int j = 0; j < pass->readCount + pass->writeCount; j++) {
+            int r = j < pass->readCount ? pass->reads[j] : pass->writes[j - pass->readCount];
+            if (this->resources[r].firstUse < 0)
+                this->resources[r].firstUse = i;
+            this->resources[r].lastUse = i;
+        }
+    }
+
+    // Alias transient resources onto pooled targets.
+    for (int k = 0; k < this->poolCount; k++)
+        this->pool[k].freeAfter = -1;
+    this->bytesRequested = 0;
+    for (int i = 0; i < this->orderCount; i++) {
+        for (int r = 0; r < this->resourceCount; r++) {
+            CFXFrameResource* resource = &this->resources[r];
+            if (resource->imported || resource->firstUse != i)
+                continue;
+            CFXFramePooledTarget* slot = nullptr;
+            for (int k = 0; k < this->poolCount && slot == nullptr; k++) {
+                CFXFramePooledTarget* candidate = &this->pool[k];
+                if (candidate->freeAfter < i
+                    && candidate->format == resource->format
+                    && candidate->target->width == resource->width
+                    && candidate->target->height == resource->height)
+                    slot = candidate;
+            }
+            if (slot == nullptr) {
+                if (this->poolCount == this->poolCapacity) {
+                    this->poolCapacity = this->poolCapacity ? this->poolCapacity * 2 : 8;
+                    this->pool = realloc(this->pool, this->poolCapacity * sizeof(CFXFramePooledTarget));
+                }
+                slot = &this->pool[this->poolCount++];
+                slot->target = NewCFXRenderTarget(resource->width, resource->height, resource->format);
+                slot->format = resource->format;
+            }
+            slot->freeAfter = resource->lastUse;
+            slot->lastFrame = this->frame;
+            resource->target = slot->target;
+            this->bytesRequested += TargetBytes(resource->width, resource->height, resource->format);
+        }
+    }
+
+    // Retire stale targets and total up the memory actually in use.
+    this->bytesAllocated = 0;
+    for (int k = 0; k < this->poolCount;) {
+        CFXFramePooledTarget* slot = &this->pool[k];
+        if (this->frame - slot->lastFrame > RetireAfterFrames) {
+            CFUnref(slot->target);
+            *slot = this->pool[--this->poolCount];
+            continue;
+        }
+        if (slot->lastFrame == this->frame)
+            this->bytesAllocated += TargetBytes(slot->target->width, slot->target->height, slot->format);
+        k++;
+    }
+    this->bytesSaved = this->bytesRequested - this->bytesAllocated;
+}
+
+/**
+ * @brief Runs the scheduled passes in order.
+ *
+ * @param this Reference to the frame graph.
+ */
+proc void Execute(CFXFrameGraphRef this)
+{
+    for (int i = 0; i < this->orderCount; i++) {
+        CFXFramePass* pass = &this->passes[this->order[i]];
+        pass->execute(pass->userData, this);
+    }
+}
+
+/**
+ * @brief Returns the render target backing a resource for this frame.
+ *
+ * Only valid after Compile. Returns nullptr for the imported default framebuffer.
+ *
+ * @param this      Reference to the frame graph.
+ * @param resource  Handle returned by CreateTexture or Import.
+ * @return          The render target to Begin/End or to bind the texture of.
+ */
+proc CFXRenderTargetRef GetTarget(CFXFrameGraphRef this, int resource)
+{
+    return this->resources[resource].target;
+}
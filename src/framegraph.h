@@ -0,0 +1,174 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rendertarget.h"
+
+extern CFClassRef CFXFrameGraph;
+typedef struct __CFXFrameGraph* CFXFrameGraphRef;
+
+#define CFX_FRAMEGRAPH_MAX_IO 8
+
+/**
+ * @typedef CFXFramePassProc
+ * @brief Records the GL commands of one pass.
+ *
+ * Called during Execute with the pass's user data. Targets for the pass's
+ * resources are looked up with GetTarget.
+ */
+typedef void (*CFXFramePassProc)(void* userData, CFXFrameGraphRef graph);
+
+/**
+ * @struct CFXFrameResource
+ * @brief A texture declared in the graph for the current frame.
+ *
+ * Transient resources are backed by a pooled render target chosen at
+ * Compile time; imported resources wrap a target owned elsewhere (nullptr
+ * stands for the default framebuffer) and count as outputs of the frame.
+ */
+typedef struct CFXFrameResource {
+    const char* name;
+    int width;
+    int height;
+    GLuint format;
+    bool imported;
+    CFXRenderTargetRef target;
+    int producer;
+    int readers;
+    int firstUse;
+    int lastUse;
+} CFXFrameResource;
+
+/**
+ * @struct CFXFramePass
+ * @brief A render pass and the resources it reads and writes.
+ */
+typedef struct CFXFramePass {
+    const char* name;
+    CFXFramePassProc execute;
+    void* userData;
+    int reads[CFX_FRAMEGRAPH_MAX_IO];
+    int readCount;
+    int writes[CFX_FRAMEGRAPH_MAX_IO];
+    int writeCount;
+    int refCount;
+    bool culled;
+    bool scheduled;
+} CFXFramePass;
+
+/**
+ * @struct CFXFramePooledTarget
+ * @brief A physical render target kept alive across frames for reuse.
+ */
+typedef struct CFXFramePooledTarget {
+    CFXRenderTargetRef target;
+    GLuint format;
+    int freeAfter;
+    int lastFrame;
+} CFXFramePooledTarget;
+
+/**
+ * @struct __CFXFrameGraph
+ * @brief Orders, culls and allocates render passes declared each frame.
+ *
+ * Passes and resources are declared from scratch every frame, typically in
+ * the game's Draw. Compile then walks backwards from the frame's outputs to
+ * cull passes whose results are never read, sorts the survivors so every
+ * producer runs before its readers, and assigns each transient resource a
+ * pooled render target. Targets are shared between resources whose
+ * lifetimes do not overlap. Tick resets the graph before Draw and compiles
+ * and executes it right after, whenever the game has a frame graph.
+ *
+ * Members:
+ * - obj:             Base object information for the frame graph.
+ * - passes:          Passes declared this frame.
+ * - passCount:       Number of passes.
+ * - passCapacity:    Allocated size of passes.
+ * - resources:       Resources declared this frame.
+ * - resourceCount:   Number of resources.
+ * - resourceCapacity: Allocated size of resources.
+ * - order:           Indices of the surviving passes in execution order; also
+ *                    used as the culling work stack during Compile.
+ * - orderCount:      Number of surviving passes.
+ * - pool:            Physical render targets available for aliasing.
+ * - poolCount:       Number of pooled targets.
+ * - poolCapacity:    Allocated size of pool.
+ * - frame:           Frame counter, used to retire unused pool entries.
+ * - bytesRequested:  Bytes the transient resources would need without aliasing.
+ * - bytesAllocated:  Bytes of the distinct pooled targets actually used.
+ * - bytesSaved:      bytesRequested - bytesAllocated for the last compiled frame.
+ */
+typedef struct __CFXFrameGraph {
+    __CFObject obj;
+    CFXFramePass* passes;
+    int passCount;
+    int passCapacity;
+    CFXFrameResource* resources;
+    int resourceCount;
+    int resourceCapacity;
+    int* order;
+    int orderCount;
+    CFXFramePooledTarget* pool;
+    int poolCount;
+    int poolCapacity;
+    int frame;
+    size_t bytesRequested;
+    size_t bytesAllocated;
+    size_t bytesSaved;
+} __CFXFrameGraph;
+
+extern proc void* Ctor(
+    CFXFrameGraphRef this);
+
+extern proc void Reset(
+    CFXFrameGraphRef this);
+
+extern proc int CreateTexture(
+    CFXFrameGraphRef this,
+    const char* name,
+    int width,
+    int height,
+    GLuint format);
+
+extern proc int Import(
+    CFXFrameGraphRef this,
+    const char* name,
+    CFXRenderTargetRef target);
+
+extern proc int AddPass(
+    CFXFrameGraphRef this,
+    const char* name,
+    CFXFramePassProc execute,
+    void* userData);
+
+extern proc void Read(
+    CFXFrameGraphRef this,
+    int pass,
+    int resource);
+
+extern proc void Write(
+    CFXFrameGraphRef this,
+    int pass,
+    int resource);
+
+extern proc void Compile(
+    CFXFrameGraphRef this);
+
+extern proc void Execute(
+    CFXFrameGraphRef this);
+
+extern proc CFXRenderTargetRef GetTarget(
+    CFXFrameGraphRef this,
+    int resource);
+
+/**
+ * @brief Creates a new, empty CFXFrameGraph.
+ *
+ * @return A reference to the newly created CFXFrameGraph.
+ */
+static inline CFXFrameGraphRef NewCFXFrameGraph()
+{
+    return Ctor((CFXFrameGraphRef)CFCreate(CFXFrameGraph));
+}
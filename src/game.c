@@ -7,6 +7,10 @@
 #define GL_GLEXT_PROTOTYPES
 #define EGL_EGLEXT_PROTOTYPES
 #include <GLFW/glfw3.h>
+#if CFX_HEADLESS && !__EMSCRIPTEN__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 #include <corefw.h>   // IWYU pragma: keep
 #include "corefx.h"             // IWYU pragma: keep
 
@@ -24,7 +28,8 @@ CFXGameRef CFXGame_instance;
  *
  * This function releases resources associated with the CFXGame instance.
  * It frees dynamically allocated memory for the title and keys fields,
- * and terminates the GLFW library.
+ * flushes the deletion queue, and terminates the GLFW library, or releases
+ * the EGL context of a headless game.
  *
  * @param self Pointer to the CFXGame instance to be destroyed.
  */
@@ -34,7 +39,24 @@ static void dtor(void* self)
 
     free(this->title);
     free(this->keys);
-    glfwTerminate();
+    if (this->loader != nullptr)
+        CFUnref(this->loader);
+    if (this->target != nullptr)
+        CFUnref(this->target);
+    // Names queued by anything released before the game must go while the context lives
+    CFXDeletionQueue_Collect(true);
+    for (int i = 0; i < CFX_MAX_FRAMES_IN_FLIGHT; i++)
+        if (this->fences[i] != nullptr)
+            glDeleteSync(this->fences[i]);
+#if CFX_HEADLESS && !__EMSCRIPTEN__
+    if (this->context != nullptr) {
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(this->display, this->context);
+        eglTerminate(this->display);
+    }
+#endif
+    if (this->window != nullptr)
+        glfwTerminate();
 }
 
 /**
@@ -104,6 +126,54 @@ static uint64_t GetTicks()
     return ((ts * 1000000L) + us) * 10;
 }
 
+/**
+ * @brief Creates a GLES 3 context with no surface through EGL.
+ *
+ * Uses Mesa's surfaceless platform when available, which needs neither a
+ * display server nor a GPU: without one Mesa renders with llvmpipe. Falls
+ * back to the default display for drivers without that platform.
+ *
+ * Only builds defining CFX_HEADLESS, which links EGL, can do this.
+ *
+ * @return Whether a context was made current.
+ */
+static bool CreateHeadlessContext(CFXGameRef this)
+{
+#if __EMSCRIPTEN__
+    printf("| ERROR::GAME: Headless mode is not supported on the web build\n");
+    return false;
+#elif !CFX_HEADLESS
+    printf("| ERROR::GAME: Headless mode needs a build with CFX_HEADLESS\n");
+    return false;
+#else
+    EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        printf("| ERROR::GAME: No EGL display for headless mode\n");
+        return false;
+    }
+
+    static const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT, EGL_NONE };
+    static const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 0, EGL_NONE };
+    EGLConfig config;
+    EGLint configs = 0;
+    EGLContext context = EGL_NO_CONTEXT;
+    if (eglBindAPI(EGL_OPENGL_ES_API) && eglChooseConfig(display, configAttributes, &config, 1, &configs) && configs > 0)
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        printf("| ERROR::GAME: Failed to create a surfaceless GLES 3 context: 0x%x\n", eglGetError());
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+    this->display = display;
+    this->context = context;
+    return true;
+#endif
+}
+
 /**
  * @brief Constructor for the CFXGame object.
  *
@@ -111,6 +181,8 @@ static uint64_t GetTicks()
  * configures OpenGL context, and registers input callbacks for both keyboard and touch controls.
  * Also initializes various game state fields and random seed.
  *
+ * Setting the CFX_HEADLESS environment variable makes the game headless.
+ *
  * @param this         Pointer to the CFXGame object to initialize.
  * @param cstr         Title string for the game window.
  * @param width        Width of the game window.
@@ -120,6 +192,32 @@ static uint64_t GetTicks()
  * @return             Pointer to the initialized CFXGame object.
  */
 proc void* Ctor(CFXGameRef this, char* cstr, int width, int height, void* subclass, CFXGameVtblRef vptr)
+{
+    return Ctor(this, cstr, width, height, subclass, vptr, getenv("CFX_HEADLESS") != nullptr ? CFX_GAME_HEADLESS : 0);
+}
+
+/**
+ * @brief Constructor for the CFXGame object taking CFX_GAME_* flags.
+ *
+ * With CFX_GAME_HEADLESS no window is created: a surfaceless EGL context is
+ * made current and an offscreen render target of the game's size is bound
+ * as the default framebuffer. Render targets restore whatever framebuffer
+ * was bound before them, so they all return to it as they would to the
+ * window's.
+ *
+ * With CFX_GAME_LOADER_CONTEXT native builds also create a context sharing
+ * objects with the game's, driven by a loader thread; see CFXLoaderContext.
+ *
+ * @param this         Pointer to the CFXGame object to initialize.
+ * @param cstr         Title string for the game window.
+ * @param width        Width of the game window or offscreen target.
+ * @param height       Height of the game window or offscreen target.
+ * @param subclass     Pointer to a subclass or user data.
+ * @param vptr         Pointer to the virtual function table for the game.
+ * @param flags        CFX_GAME_* flags.
+ * @return             Pointer to the initialized CFXGame object.
+ */
+proc void* Ctor(CFXGameRef this, char* cstr, int width, int height, void* subclass, CFXGameVtblRef vptr, uint32_t flags)
 {
     this->subclass = subclass;
     this->virtual = vptr;
@@ -135,31 +233,71 @@ proc void* Ctor(CFXGameRef this, char* cstr, int width, int height, void* subcla
     this->isFixedTimeStep = true;
     this->shouldExit = false;
     this->suppressDraw = false;
+    this->frameGraph = nullptr;
+    this->drawing = false;
+    this->maxFramesInFlight = 0;
+    memset(this->fences, 0, sizeof(this->fences));
+    this->fenceIndex = 0;
+    this->cpuWaitTime = 0.0;
+    this->flags = flags;
+    this->window = nullptr;
+    this->display = nullptr;
+    this->context = nullptr;
+    this->target = nullptr;
+    this->frameLimit = 0;
+    this->frameCount = 0;
+    this->resourceManager = nullptr;
+    this->uploadBudget = 0.002;
+    this->loader = nullptr;
+    this->loading = false;
     this->maxElapsedTime = 500 * TicksPerMillisecond;
     this->targetElapsedTime = 166667;
     this->accumulatedElapsedTime = 0;
     this->currentTime = GetTicks();
 
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
-    // glfw window creation
-    // --------------------
-    this->window = glfwCreateWindow(this->width, this->height, "LearnOpenGL", nullptr, nullptr);
-    if (this->window == nullptr) {
-        printf("Failed to create GLFW window");
-        glfwTerminate();
-        exit(-1);
+    CFXGame_instance = this;
+    if (!(this->flags & CFX_GAME_HEADLESS)) {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+        // glfw window creation
+        // --------------------
+        this->window = glfwCreateWindow(this->width, this->height, "LearnOpenGL", nullptr, nullptr);
+        if (this->window == nullptr) {
+            printf("Failed to create GLFW window\n");
+            glfwTerminate();
+            exit(-1);
+        }
+    }
+    if (this->flags & CFX_GAME_HEADLESS) {
+        if (!CreateHeadlessContext(this))
+            exit(-1);
+        this->target = NewCFXRenderTarget(this->width, this->height, GL_RGBA8);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->target->FBO);
+    } else {
+        glfwMakeContextCurrent(this->window);
+        glfwSetFramebufferSizeCallback(this->window, CFXGame_framebuffer_size_callback);
+        glfwSetKeyCallback(this->window, CFXGame_key_callback);
+        glfwSwapInterval(1);
     }
-    glfwMakeContextCurrent(this->window);
-    glfwSetFramebufferSizeCallback(this->window, CFXGame_framebuffer_size_callback);
 
-    CFXGame_instance = this;
-    glfwSetKeyCallback(this->window, CFXGame_key_callback);
-    glfwSwapInterval(1);
+#if !__EMSCRIPTEN__
+    // The web build has one context per canvas and keeps loading on the render thread
+    if (this->flags & CFX_GAME_LOADER_CONTEXT) {
+        this->loader = this->window != nullptr
+            ? NewCFXLoaderContext(this->window)
+            : NewCFXLoaderContextEGL(this->display, this->context);
+        // Texture workers post from their own threads, so loading stays on
+        // the render thread without a loader thread to post to
+        if (!IsRunning(this->loader)) {
+            CFUnref(this->loader);
+            this->loader = nullptr;
+        }
+    }
+#endif
 
     glViewport(0, 0, this->width, this->height);
     glEnable(GL_CULL_FACE);
@@ -224,6 +362,8 @@ proc void Start(CFXGameRef const this)
  */
 proc void HandleEvents(CFXGameRef const this)
 {
+    if (this->window == nullptr)
+        return;
     if (glfwGetKey(this->window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(this->window, true);
         this->shouldExit = true;
@@ -231,6 +371,66 @@ proc void HandleEvents(CFXGameRef const this)
     }
 }
 
+/**
+ * @brief Inserts a fence marking the end of the frame just drawn.
+ *
+ * A fence still in the slot is from a frame that was never waited on, such as
+ * after maxFramesInFlight was lowered, and is dropped.
+ *
+ * @param this Pointer to the game object.
+ */
+static void SignalFrame(CFXGameRef const this)
+{
+    if (this->maxFramesInFlight <= 0)
+        return;
+    // Update may have raised it since WaitForFrame clamped it
+    if (this->maxFramesInFlight > CFX_MAX_FRAMES_IN_FLIGHT)
+        this->maxFramesInFlight = CFX_MAX_FRAMES_IN_FLIGHT;
+    int slot = this->fenceIndex % this->maxFramesInFlight;
+    if (this->fences[slot] != nullptr)
+        glDeleteSync(this->fences[slot]);
+    this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->fenceIndex = (slot + 1) % this->maxFramesInFlight;
+}
+
+/**
+ * @brief Waits until the GPU has finished the frame maxFramesInFlight frames back.
+ *
+ * The fence in the next slot of the ring is the oldest one. Blocking on it
+ * keeps the driver from queueing more frames, so input read right after is
+ * at most maxFramesInFlight frames old when displayed. WebGL cannot block on
+ * a fence, so there the fence is polled and the frame skipped until it has
+ * signaled; the browser calls back on the next animation frame.
+ *
+ * @param this Pointer to the game object.
+ * @return     false if the frame should be skipped.
+ */
+static bool WaitForFrame(CFXGameRef const this)
+{
+    this->cpuWaitTime = 0.0;
+    if (this->maxFramesInFlight <= 0)
+        return true;
+    if (this->maxFramesInFlight > CFX_MAX_FRAMES_IN_FLIGHT)
+        this->maxFramesInFlight = CFX_MAX_FRAMES_IN_FLIGHT;
+    int slot = this->fenceIndex % this->maxFramesInFlight;
+    GLsync fence = this->fences[slot];
+    if (fence == nullptr)
+        return true;
+
+    uint64_t start = GetTicks();
+#if __EMSCRIPTEN__
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+#else
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        continue;
+#endif
+    this->cpuWaitTime = (GetTicks() - start) * SecondsPerTick;
+    glDeleteSync(fence);
+    this->fences[slot] = nullptr;
+    return true;
+}
+
 /**
  * @brief Advances the game simulation by one tick, handling both fixed and variable timestep updates.
  *
@@ -239,6 +439,9 @@ proc void HandleEvents(CFXGameRef const this)
  * modes, ensuring consistent game logic updates and smooth rendering.
  *
  * The function performs the following tasks:
+ * - Publishes what the loader thread has finished, and uploads textures the
+ *   resource manager has decoded, within uploadBudget. Once LoadContent's
+ *   tasks have all been published, reports the shader program cache.
  * - Calculates the elapsed time since the last tick and accumulates it.
  * - In fixed timestep mode, sleeps if not enough time has passed to perform an update, to save CPU.
  * - Limits the maximum accumulated elapsed time to prevent spiral of death.
@@ -246,13 +449,26 @@ proc void HandleEvents(CFXGameRef const this)
  *   adjusting the isRunningSlowly flag if the game falls behind.
  * - In variable timestep mode, performs a single update with the accumulated elapsed time.
  * - Calls the Update() function to advance game logic.
- * - Calls the Draw() function unless drawing is suppressed.
+ * - Calls the Draw() function unless drawing is suppressed. When a frame graph is set,
+ *   Draw declares this frame's passes, and the graph is compiled, executed and presented
+ *   right after; Draw must not swap buffers itself, and Present within it does nothing.
+ * - Inserts a fence after drawing when maxFramesInFlight is set.
  * - Checks for exit conditions and updates the running state accordingly.
  *
  * @param this Pointer to the game object (CFXGameRef) whose state is to be updated.
  */
 proc void Tick(CFXGameRef const this)
 {
+    if (this->loader != nullptr) {
+        Publish(this->loader);
+        if (this->loading && Pending(this->loader) == 0) {
+            this->loading = false;
+            CFXShader_LogCacheStats();
+        }
+    }
+    if (this->resourceManager != nullptr)
+        Upload(this->resourceManager, this->uploadBudget);
+
     while (true) {
         // Advance the accumulated elapsed time.
         long currentTicks = (GetTicks() - this->currentTime); //*10;
@@ -332,10 +548,24 @@ proc void Tick(CFXGameRef const this)
     if (this->suppressDraw)
         this->suppressDraw = false;
     else {
+        if (this->frameGraph != nullptr)
+            Reset(this->frameGraph);
+        this->drawing = true;
         Draw(this);
+        this->drawing = false;
+        if (this->frameGraph != nullptr) {
+            Compile(this->frameGraph);
+            Execute(this->frameGraph);
+            Present(this);
+        }
+        SignalFrame(this);
+        CFXDeletionQueue_Retire();
+        this->frameCount++;
     }
 
-    if (this->shouldExit || glfwWindowShouldClose(this->window))
+    if (this->frameLimit > 0 && this->frameCount >= this->frameLimit)
+        this->shouldExit = true;
+    if (this->shouldExit || (this->window != nullptr && glfwWindowShouldClose(this->window)))
         this->isRunning = false;
     // Platform.Exit();
 }
@@ -343,7 +573,12 @@ proc void Tick(CFXGameRef const this)
 /**
  * @brief Runs the main game loop for the specified game instance.
  *
- * This function initializes the game, loads necessary content, and starts the game.
+ * This function initializes the game, hands the loader context to the
+ * resource manager if both are set, loads necessary content with shader
+ * status checks deferred to first use, so the driver compiles them while
+ * textures load, and starts the game. How many of its shaders came from the
+ * program binary cache is reported here, or by Tick once the loader thread
+ * has compiled them.
  * It then sets up the main loop using Emscripten, repeatedly calling the RunLoop
  * function with the game instance as its argument.
  *
@@ -352,7 +587,15 @@ proc void Tick(CFXGameRef const this)
 proc void Run(CFXGameRef const this)
 {
     Initialize(this);
+    if (this->loader != nullptr && this->resourceManager != nullptr)
+        SetLoaderContext(this->resourceManager, this->loader);
+    CFXShader_SetAsync(true);
     LoadContent(this);
+    CFXShader_SetAsync(false);
+    if (this->loader != nullptr)
+        this->loading = true;
+    else
+        CFXShader_LogCacheStats();
     Start(this);
 #if __EMSCRIPTEN__
     emscripten_set_main_loop_arg((em_arg_callback_func)RunLoop, (void*)this, -1, 1);
@@ -363,16 +606,39 @@ proc void Run(CFXGameRef const this)
 #endif
 }
 
+/**
+ * @brief Shows the frame: swaps the window's buffers, or flushes a headless game's commands.
+ *
+ * With a frame graph set, Tick presents once the graph has executed, and a
+ * call from Draw does nothing, as the graph's passes have not run yet.
+ *
+ * @param this A reference to the game instance.
+ */
+proc void Present(CFXGameRef const this)
+{
+    if (this->drawing && this->frameGraph != nullptr)
+        return;
+    if (this->window != nullptr)
+        glfwSwapBuffers(this->window);
+    else
+        glFlush();
+}
+
 /**
  * @brief Runs the main game loop for the specified game instance.
  *
  * This function processes input events and updates the game state
- * by calling HandleEvents() and Tick() in sequence.
+ * by calling HandleEvents() and Tick() in sequence, after waiting for the
+ * GPU when more than maxFramesInFlight frames are queued and deleting the
+ * GL objects released in frames the GPU has finished.
  *
  * @param this A constant reference to the game instance (CFXGameRef).
  */
 proc void RunLoop(CFXGameRef const this)
 {
+    if (!WaitForFrame(this))
+        return;
+    CFXDeletionQueue_Collect(false);
     HandleEvents(this);
     Tick(this);
 }
@@ -17,6 +17,26 @@ extern CFClassRef CFXGame;
 
 typedef struct __CFXGame* CFXGameRef;
 typedef struct __CFXGameVtbl* CFXGameVtblRef;
+typedef struct __CFXFrameGraph* CFXFrameGraphRef;
+typedef struct __CFXRenderTarget* CFXRenderTargetRef;
+typedef struct __CFXResourceManager* CFXResourceManagerRef;
+typedef struct __CFXLoaderContext* CFXLoaderContextRef;
+
+/**
+ * Upper bound for CFXGame::maxFramesInFlight.
+ */
+#define CFX_MAX_FRAMES_IN_FLIGHT 4
+
+/**
+ * CFXGame::flags bit: render without a window into CFXGame::target. Needs a
+ * build with the CFX_HEADLESS option, which links EGL.
+ */
+#define CFX_GAME_HEADLESS 0x1
+
+/**
+ * CFXGame::flags bit: create CFXGame::loader, a shared context on a loader thread.
+ */
+#define CFX_GAME_LOADER_CONTEXT 0x2
 
 extern CFXGameRef CFXGame_instance;
 
@@ -91,6 +111,20 @@ typedef struct __CFXGameVtbl {
  * - updateFrameLag: Number of frames the update is lagging behind.
  * - shouldExit: Flag to signal the game should exit.
  * - suppressDraw: Flag to suppress rendering for the current frame.
+ * - frameGraph: Optional frame graph; reset before Draw, then compiled, executed and presented after it.
+ * - drawing: Set while Tick runs Draw, so Present waits for the frame graph.
+ * - maxFramesInFlight: Frames the GPU may lag behind the CPU before RunLoop waits; 0 disables the limit.
+ * - fences: Ring of fences inserted after each Draw.
+ * - fenceIndex: Next slot of fences to fill.
+ * - cpuWaitTime: Seconds RunLoop spent waiting on the GPU before the last frame.
+ * - display, context: EGL display and context of a headless game.
+ * - target: Offscreen framebuffer standing in for the window of a headless game.
+ * - frameLimit: Frames after which the game stops; 0 runs until exit is requested.
+ * - frameCount: Frames drawn so far.
+ * - resourceManager: Optional resource manager whose async textures Tick uploads.
+ * - uploadBudget: Seconds per frame Tick may spend uploading textures.
+ * - loader: Shared context on a loader thread, with CFX_GAME_LOADER_CONTEXT; Tick publishes its results.
+ * - loading: Whether LoadContent's loader tasks are still outstanding; Tick reports the shader cache once they drain.
  */
 typedef struct __CFXGame {
     __CFObject obj;
@@ -129,6 +163,21 @@ typedef struct __CFXGame {
     int updateFrameLag;
     bool shouldExit;
     bool suppressDraw;
+    CFXFrameGraphRef frameGraph;
+    bool drawing;
+    int maxFramesInFlight;
+    GLsync fences[CFX_MAX_FRAMES_IN_FLIGHT];
+    int fenceIndex;
+    double cpuWaitTime;
+    void* display;
+    void* context;
+    CFXRenderTargetRef target;
+    int frameLimit;
+    int frameCount;
+    CFXResourceManagerRef resourceManager;
+    double uploadBudget;
+    CFXLoaderContextRef loader;
+    bool loading;
 } __CFXGame;
 
 
@@ -140,6 +189,15 @@ extern proc void* Ctor(
     void* subclass, 
     CFXGameVtblRef vptr);
 
+extern proc void* Ctor(
+    CFXGameRef this,
+    char* cstr,
+    int width,
+    int height,
+    void* subclass,
+    CFXGameVtblRef vptr,
+    uint32_t flags);
+
 extern proc void HandleEvents(
     CFXGameRef const this);
 
@@ -158,11 +216,26 @@ extern proc void RunLoop(
 extern proc void Run(
     CFXGameRef const this);
 
+extern proc void Present(
+    CFXGameRef const this);
+
 static inline CFXGameRef NewCFXGame(char* cstr, int width, int height, void* subclass, CFXGameVtblRef vptr)
 {
     return Ctor((CFXGameRef)CFCreate(CFXGame), cstr, width, height, subclass, vptr);
 }
 
+/**
+ * @brief Creates a game that renders offscreen, without a window or display.
+ *
+ * Drawing goes to an offscreen framebuffer of the given size, bound as the
+ * default target, so renderers, render targets and the resource manager
+ * work as they do with a window. Read the frame back from target.
+ */
+static inline CFXGameRef NewCFXHeadlessGame(char* cstr, int width, int height, void* subclass, CFXGameVtblRef vptr)
+{
+    return Ctor((CFXGameRef)CFCreate(CFXGame), cstr, width, height, subclass, vptr, CFX_GAME_HEADLESS);
+}
+
 /**
  * @brief Calls the virtual Draw method for the given game instance.
  *
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "gpuparticlesystem.h"
+
+class2(CFXGPUParticleSystem);
+
+/**
+ * Particle update pass. Particles with a negative age are still waiting for
+ * their first spawn; particles whose age reaches their life span respawn at
+ * the emitter with a hashed random velocity and life, unless emission is off.
+ */
+static const GLchar* UpdateVertexSource = CFX_GLSL_VERSION
+    "layout(location = 0) in vec4 inState;\n"
+    "layout(location = 1) in vec4 inLife;\n"
+    "out vec4 outState;\n"
+    "out vec4 outLife;\n"
+    "uniform float delta;\n"
+    "uniform float time;\n"
+    "uniform bool emitting;\n"
+    "uniform vec2 origin;\n"
+    "uniform vec2 gravity;\n"
+    "uniform vec2 minVelocity;\n"
+    "uniform vec2 maxVelocity;\n"
+    "uniform vec2 lifeRange;\n"
+    "float hash(float n) { return fract(sin(n) * 43758.5453123); }\n"
+    "void main() {\n"
+    "    float age = inLife.x + delta;\n"
+    "    if (age < 0.0) {\n"
+    "        outState = inState;\n"
+    "        outLife = vec4(age, inLife.yzw);\n"
+    "    } else if (age >= inLife.y && !emitting) {\n"
+    "        outState = inState;\n"
+    "        outLife = vec4(inLife.y, inLife.yzw);\n"
+    "    } else if (age >= inLife.y) {\n"
+    "        float seed = inLife.z + time;\n"
+    "        vec2 r = vec2(hash(seed * 12.9898), hash(seed * 78.233));\n"
+    "        outState = vec4(origin, mix(minVelocity, maxVelocity, r));\n"
+    "        outLife = vec4(0.0, mix(lifeRange.x, lifeRange.y, hash(seed * 3.7)), inLife.zw);\n"
+    "    } else {\n"
+    "        vec2 velocity = inState.zw + gravity * delta;\n"
+    "        outState = vec4(inState.xy + velocity * delta, velocity);\n"
+    "        outLife = vec4(age, inLife.yzw);\n"
+    "    }\n"
+    "}\n";
+
+/**
+ * GLSL ES requires a fragment shader to link, even though it never runs
+ * while GL_RASTERIZER_DISCARD is enabled.
+ */
+static const GLchar* UpdateFragmentSource = CFX_GLSL_VERSION
+    "out vec4 color;\n"
+    "void main() { color = vec4(0.0); }\n";
+
+static const GLchar* const UpdateVaryings[] = { "outState", "outLife" };
+
+/**
+ * @brief Constructor for the CFXGPUParticleSystem object.
+ *
+ * Compiles the transform feedback update program, seeds both state buffers
+ * and builds one vertex array per buffer. Every particle starts dead with a
+ * staggered negative age, so the first wave of spawns is spread over maxLife
+ * instead of bursting on the first frame.
+ *
+ * @param this      Pointer to the CFXGPUParticleSystem instance to initialize.
+ * @param shader    Reference to the point sprite shader used by Draw.
+ * @param capacity  Number of particles simulated.
+ * @return          Pointer to the initialized CFXGPUParticleSystem instance.
+ */
+proc void* Ctor(CFXGPUParticleSystemRef this, CFXShaderRef shader, int capacity)
+{
+    CFXGPUParticleSystem->dtor = dtor;
+    this->shader = shader;
+    this->capacity = capacity;
+    this->current = 0;
+    this->time = 0.0f;
+    this->emitting = true;
+    this->origin = (Vec2) { 0.0f, 0.0f };
+    this->gravity = (Vec2) { 0.0f, 0.0f };
+    this->minVelocity = (Vec2) { -50.0f, -50.0f };
+    this->maxVelocity = (Vec2) { 50.0f, 50.0f };
+    this->minLife = 0.5f;
+    this->maxLife = 1.0f;
+
+    this->update = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(this->update, UpdateVertexSource, UpdateFragmentSource, UpdateVaryings, 2);
+
+    Vec4* seed = calloc(capacity * 2, sizeof(Vec4));
+    for (int i = 0; i < capacity; i++) {
+        seed[i * 2 + 0] = (Vec4) { this->origin.x, this->origin.y, 0.0f, 0.0f };
+        seed[i * 2 + 1] = (Vec4) { -this->maxLife * (GLfloat)i / (GLfloat)capacity, 0.0f, (GLfloat)i * 0.618034f, 0.0f };
+    }
+
+    glGenBuffers(2, this->VBO);
+    glGenVertexArrays(2, this->VAO);
+    for (int i = 0; i < 2; i++) {
+        glBindVertexArray(this->VAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 2 * sizeof(Vec4), seed, GL_DYNAMIC_COPY);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(Vec4), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(Vec4), (GLvoid*)sizeof(Vec4));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    free(seed);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXGPUParticleSystem object.
+ *
+ * Releases the update program, the state buffers and their vertex arrays.
+ *
+ * @param self Pointer to the CFXGPUParticleSystem instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXGPUParticleSystemRef this = self;
+    CFUnref(this->update);
+    CFXDeletionQueue_VertexArrays(2, this->VAO);
+    CFXDeletionQueue_Buffers(2, this->VBO);
+}
+
+/**
+ * @brief Advances the simulation by one step on the GPU.
+ *
+ * Runs the update program over the current buffer as points and captures
+ * its outputs into the other buffer with rasterization disabled, then swaps.
+ *
+ * @param this   Reference to the particle system.
+ * @param delta  Elapsed time in seconds, as computed by Tick.
+ */
+proc void Update(CFXGPUParticleSystemRef this, GLfloat delta)
+{
+    int next = 1 - this->current;
+    this->time += delta;
+
+    Use(this->update);
+    SetFloat(this->update, "delta", delta, false);
+    SetFloat(this->update, "time", this->time, false);
+    SetInteger(this->update, "emitting", this->emitting, false);
+    SetVector2v(this->update, "origin", &this->origin, false);
+    SetVector2v(this->update, "gravity", &this->gravity, false);
+    SetVector2v(this->update, "minVelocity", &this->minVelocity, false);
+    SetVector2v(this->update, "maxVelocity", &this->maxVelocity, false);
+    SetVector2(this->update, "lifeRange", this->minLife, this->maxLife, false);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(this->VAO[this->current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->VBO[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, this->capacity);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    this->current = next;
+}
+
+/**
+ * @brief Draws every particle as a point sprite straight from the latest state buffer.
+ *
+ * The render shader is responsible for sizing the points with gl_PointSize and
+ * for culling dead particles (see the layout documented on __CFXGPUParticleSystem).
+ *
+ * @param this     Reference to the particle system.
+ * @param texture  Texture sampled with gl_PointCoord.
+ */
+proc void Draw(CFXGPUParticleSystemRef this, CFXTexture2DRef texture)
+{
+#ifndef __EMSCRIPTEN__
+    // Desktop GL only honors gl_PointSize when asked to; gl_PointCoord is always on.
+    glEnable(GL_PROGRAM_POINT_SIZE);
+#endif
+    Use(this->shader);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(texture);
+
+    glBindVertexArray(this->VAO[this->current]);
+    glDrawArrays(GL_POINTS, 0, this->capacity);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "texture2d.h"          // IWYU pragma: keep
+#include "shader.h"
+#include "tglm.h"
+
+extern CFClassRef CFXGPUParticleSystem;
+typedef struct __CFXGPUParticleSystem* CFXGPUParticleSystemRef;
+
+/**
+ * @struct __CFXGPUParticleSystem
+ * @brief A particle emitter simulated entirely on the GPU with transform feedback.
+ *
+ * Particle state lives in two vertex buffers that are ping-ponged each Update:
+ * a built-in vertex shader reads one buffer, integrates or respawns every
+ * particle and writes the result into the other with rasterization disabled.
+ * Draw then renders the freshly written buffer as points, so the state never
+ * leaves the GPU. Emission parameters are passed to the update shader as
+ * uniforms. All shaders are GLSL ES 3.00, which Mesa llvmpipe runs as well.
+ *
+ * Each particle is two interleaved vec4s, which the render shader reads as:
+ * - location 0: vec4 state (xy = position, zw = velocity)
+ * - location 1: vec4 life  (x = age, y = life span, z = seed); the particle
+ *   is alive while 0 <= age < life span.
+ *
+ * Members:
+ * - obj:           Base object information for the particle system.
+ * - shader:        Reference to the shader used to draw the particles as points.
+ * - update:        The transform feedback shader that advances the simulation.
+ * - VBO:           The two ping-ponged particle state buffers.
+ * - VAO:           Vertex arrays reading VBO[0] and VBO[1] respectively.
+ * - current:       Index of the buffer holding the latest state.
+ * - capacity:      Number of particles simulated.
+ * - time:          Simulation time in seconds, used to seed respawns.
+ * - emitting:      When false, dead particles are not respawned.
+ * - origin:        Emitter position.
+ * - gravity:       Constant acceleration applied to every particle.
+ * - minVelocity:   Lower bound of the random spawn velocity.
+ * - maxVelocity:   Upper bound of the random spawn velocity.
+ * - minLife:       Lower bound of the random particle life in seconds.
+ * - maxLife:       Upper bound of the random particle life in seconds.
+ */
+typedef struct __CFXGPUParticleSystem {
+    __CFObject obj;
+    CFXShaderRef shader;
+    CFXShaderRef update;
+    GLuint VBO[2];
+    GLuint VAO[2];
+    int current;
+    int capacity;
+    GLfloat time;
+    bool emitting;
+    Vec2 origin;
+    Vec2 gravity;
+    Vec2 minVelocity;
+    Vec2 maxVelocity;
+    GLfloat minLife;
+    GLfloat maxLife;
+} __CFXGPUParticleSystem;
+
+extern proc void* Ctor(
+    CFXGPUParticleSystemRef this,
+    CFXShaderRef shader,
+    int capacity);
+
+extern proc void Update(
+    CFXGPUParticleSystemRef this,
+    GLfloat delta);
+
+extern proc void Draw(
+    CFXGPUParticleSystemRef this,
+    CFXTexture2DRef texture);
+
+/**
+ * @brief Creates a new CFXGPUParticleSystem with the given render shader and particle count.
+ *
+ * @param shader    The point sprite shader used to draw the particles.
+ * @param capacity  Number of particles simulated.
+ * @return A reference to the newly created CFXGPUParticleSystem.
+ */
+static inline CFXGPUParticleSystemRef NewCFXGPUParticleSystem(CFXShaderRef shader, int capacity)
+{
+    return Ctor((CFXGPUParticleSystemRef)CFCreate(CFXGPUParticleSystem), shader, capacity);
+}
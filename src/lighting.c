@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "lighting.h"
+
+class2(CFXLighting);
+
+/**
+ * Each light is three vec4s: (position, radius, outerCone),
+ * (color * intensity, innerCone) and (direction, unused).
+ */
+constexpr int InstanceVec4s = 3;
+
+/**
+ * Light quads are expanded from a unit quad in world space and mapped to
+ * clip space through the camera rectangle, y pointing down as in the sprite
+ * renderers' orthographic projection.
+ */
+static const GLchar* LightVertexSource = CFX_GLSL_VERSION
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec4 shape;\n"
+    "layout(location = 2) in vec4 tint;\n"
+    "layout(location = 3) in vec4 aim;\n"
+    "uniform vec4 camera;\n"
+    "out vec2 local;\n"
+    "out vec3 color;\n"
+    "out vec4 spot;\n"
+    "void main() {\n"
+    "    local = corner;\n"
+    "    color = tint.rgb;\n"
+    "    spot = vec4(aim.xy, tint.w, shape.w);\n"
+    "    vec2 n = (shape.xy + corner * shape.z - camera.xy) / camera.zw;\n"
+    "    gl_Position = vec4(n.x * 2.0 - 1.0, 1.0 - n.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+/**
+ * Quadratic falloff to the radius, narrowed by the spot cone. Point lights
+ * carry outerCone = -1 and skip the cone test.
+ */
+static const GLchar* LightFragmentSource = CFX_GLSL_VERSION
+    "in vec2 local;\n"
+    "in vec3 color;\n"
+    "in vec4 spot;\n"
+    "out vec4 fragment;\n"
+    "void main() {\n"
+    "    float d = length(local);\n"
+    "    if (d >= 1.0) discard;\n"
+    "    float falloff = (1.0 - d) * (1.0 - d);\n"
+    "    if (spot.w > -1.0) {\n"
+    "        float c = dot(local / max(d, 1e-4), spot.xy);\n"
+    "        falloff *= smoothstep(spot.w, max(spot.z, spot.w + 1e-4), c);\n"
+    "    }\n"
+    "    fragment = vec4(color * falloff, 1.0);\n"
+    "}\n";
+
+static const GLchar* ModulateFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D light;\n"
+    "void main() { color = vec4(texture(light, uv).rgb, 1.0); }\n";
+
+/**
+ * @brief Constructor for the CFXLighting object.
+ *
+ * @param this    Pointer to the CFXLighting instance to initialize.
+ * @param width   Screen width in pixels.
+ * @param height  Screen height in pixels.
+ * @param scale   Divisor of the light buffer resolution.
+ * @return        Pointer to the initialized CFXLighting instance.
+ */
+proc void* Ctor(CFXLightingRef this, int width, int height, int scale)
+{
+    CFXLighting->dtor = dtor;
+    this->lights = nullptr;
+    this->count = 0;
+    this->capacity = 0;
+    this->instances = nullptr;
+    this->visibleCount = 0;
+    this->instanceCapacity = 0;
+    this->scale = Max(scale, 1);
+    this->ambient = (Vec3) { 0.1f, 0.1f, 0.15f };
+    this->target = NewCFXRenderTarget(Max(width / this->scale, 1), Max(height / this->scale, 1), GL_RGBA8);
+
+    this->lightShader = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(this->lightShader, LightVertexSource, LightFragmentSource);
+    this->modulate = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(this->modulate, CFX_FULLSCREEN_VERTEX_SOURCE, ModulateFragmentSource);
+
+    // Bottom row first: the shader's y flip then leaves the strip counter-clockwise for culling
+    static const GLfloat corners[] = { -1, 1, 1, 1, -1, -1, 1, -1 };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->quadVBO);
+    glGenBuffers(1, &this->instanceVBO);
+
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    for (int i = 0; i < InstanceVec4s; i++) {
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, InstanceVec4s * sizeof(Vec4), (void*)(i * sizeof(Vec4)));
+        glVertexAttribDivisor(1 + i, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXLighting object.
+ *
+ * @param self Pointer to the CFXLighting instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXLightingRef this = self;
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->quadVBO);
+    CFXDeletionQueue_Buffers(1, &this->instanceVBO);
+    CFUnref(this->lightShader);
+    CFUnref(this->modulate);
+    CFUnref(this->target);
+    free(this->lights);
+    free(this->instances);
+}
+
+/**
+ * @brief Resizes the light buffer to follow the screen.
+ *
+ * @param this    Reference to the lighting module.
+ * @param width   New screen width in pixels.
+ * @param height  New screen height in pixels.
+ */
+proc void Resize(CFXLightingRef this, int width, int height)
+{
+    width = Max(width / this->scale, 1);
+    height = Max(height / this->scale, 1);
+    if (width == this->target->width && height == this->target->height)
+        return;
+    CFUnref(this->target);
+    this->target = NewCFXRenderTarget(width, height, GL_RGBA8);
+}
+
+/**
+ * @brief Adds a light.
+ *
+ * @param this   Reference to the lighting module.
+ * @param light  The light; edit it afterwards through lights[index].
+ * @return       Index of the light.
+ */
+proc int AddLight(CFXLightingRef this, CFXLight light)
+{
+    if (this->count == this->capacity) {
+        this->capacity = this->capacity ? this->capacity * 2 : 64;
+        this->lights = realloc(this->lights, this->capacity * sizeof(CFXLight));
+    }
+    this->lights[this->count] = light;
+    return this->count++;
+}
+
+/**
+ * @brief Removes a light by moving the last light into its slot.
+ *
+ * @param this   Reference to the lighting module.
+ * @param index  Index of the light to remove; the last light takes this index.
+ */
+proc void RemoveLight(CFXLightingRef this, int index)
+{
+    if (index < 0 || index >= this->count)
+        return;
+    this->lights[index] = this->lights[--this->count];
+}
+
+/**
+ * @brief Culls the lights and renders the visible ones into the light buffer.
+ *
+ * A light is kept when its circle of influence overlaps the camera
+ * rectangle; the survivors are packed and drawn with one instanced call.
+ *
+ * @param this    Reference to the lighting module.
+ * @param camera  Visible region in world units.
+ */
+proc void Draw(CFXLightingRef this, CFXRect camera)
+{
+    if (this->count > this->instanceCapacity) {
+        this->instanceCapacity = this->capacity;
+        this->instances = realloc(this->instances, this->instanceCapacity * InstanceVec4s * sizeof(Vec4));
+    }
+
+    float left = camera.x, top = camera.y;
+    float right = camera.x + camera.w, bottom = camera.y + camera.h;
+    Vec4* out = this->instances;
+    for (int i = 0; i < this->count; i++) {
+        CFXLight* light = &this->lights[i];
+        float nx = light->position.x < left ? left : light->position.x > right ? right : light->position.x;
+        float ny = light->position.y < top ? top : light->position.y > bottom ? bottom : light->position.y;
+        float dx = light->position.x - nx, dy = light->position.y - ny;
+        if (dx * dx + dy * dy >= light->radius * light->radius)
+            continue;
+        *out++ = (Vec4) { light->position.x, light->position.y, light->radius, light->outerCone };
+        *out++ = (Vec4) { light->color.x * light->intensity, light->color.y * light->intensity,
+                          light->color.z * light->intensity, light->innerCone };
+        *out++ = (Vec4) { light->direction.x, light->direction.y, 0.0f, 0.0f };
+    }
+    this->visibleCount = (int)(out - this->instances) / InstanceVec4s;
+
+    Begin(this->target);
+    GLfloat clear[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear);
+    glClearColor(this->ambient.x, this->ambient.y, this->ambient.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clear[0], clear[1], clear[2], clear[3]);
+    if (this->visibleCount > 0) {
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        Use(this->lightShader);
+        SetVector4(this->lightShader, "camera", camera.x, camera.y, camera.w, camera.h);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, this->visibleCount * InstanceVec4s * sizeof(Vec4), this->instances, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(this->VAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, this->visibleCount);
+        glBindVertexArray(0);
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (!blend)
+            glDisable(GL_BLEND);
+    }
+    End(this->target);
+}
+
+/**
+ * @brief Multiplies the current framebuffer by the light buffer.
+ *
+ * Call after the scene has been drawn. Bilinear filtering of the light
+ * buffer hides its reduced resolution, since lighting is low frequency.
+ *
+ * @param this Reference to the lighting module.
+ */
+proc void Composite(CFXLightingRef this)
+{
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_DST_COLOR, GL_ZERO);
+    Use(this->modulate);
+    SetInteger(this->modulate, "light", 0);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(this->target->texture);
+    CFXRenderTarget_DrawFullscreen();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (!blend)
+        glDisable(GL_BLEND);
+}
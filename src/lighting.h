@@ -0,0 +1,134 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rect.h"
+#include "rendertarget.h"
+#include "shader.h"
+#include "tglm.h"
+
+extern CFClassRef CFXLighting;
+typedef struct __CFXLighting* CFXLightingRef;
+
+/**
+ * @struct CFXLight
+ * @brief A point or spot light in world space.
+ *
+ * A point light is a spot light whose cone covers every direction, which is
+ * what outerCone = -1 gives.
+ *
+ * Members:
+ * - position:   Center in world units.
+ * - radius:     Distance at which the light falls off to zero.
+ * - intensity:  Multiplier applied to color.
+ * - color:      Light color.
+ * - direction:  Unit vector the spot points along.
+ * - innerCone:  Cosine of the half angle inside which the spot is at full strength.
+ * - outerCone:  Cosine of the half angle outside which the spot is dark.
+ */
+typedef struct CFXLight {
+    Vec2 position;
+    GLfloat radius;
+    GLfloat intensity;
+    Vec3 color;
+    Vec2 direction;
+    GLfloat innerCone;
+    GLfloat outerCone;
+} CFXLight;
+
+/**
+ * @struct __CFXLighting
+ * @brief Accumulates 2D lights into a reduced resolution light buffer.
+ *
+ * Draw culls the lights against the camera on the CPU and renders the
+ * visible ones as one instanced draw of additive quads into a light target
+ * cleared to the ambient color. Composite then multiplies whatever has been
+ * drawn to the current framebuffer by the light buffer with a single
+ * fullscreen pass, so sprite renderers are unaware of lighting and the cost
+ * per light is paid at a fraction of the screen resolution.
+ *
+ * Members:
+ * - obj:           Base object information for the lighting module.
+ * - lights:        All lights; RemoveLight moves the last light into the freed slot.
+ * - count:         Number of lights.
+ * - capacity:      Allocated size of lights.
+ * - instances:     Per-instance data of the lights that survived culling.
+ * - visibleCount:  Number of lights drawn by the last Draw.
+ * - target:        Light buffer.
+ * - scale:         Divisor from screen to light buffer resolution.
+ * - ambient:       Light level where no light reaches.
+ * - lightShader:   Built-in shader drawing the light quads.
+ * - modulate:      Built-in fullscreen shader applying the light buffer.
+ * - VAO:           Vertex array of the instanced light quad.
+ * - quadVBO:       Unit quad corners.
+ * - instanceVBO:   Instance data, re-specified every Draw.
+ * - instanceCapacity: Size of instanceVBO in lights.
+ */
+typedef struct __CFXLighting {
+    __CFObject obj;
+    CFXLight* lights;
+    int count;
+    int capacity;
+    Vec4* instances;
+    int visibleCount;
+    CFXRenderTargetRef target;
+    int scale;
+    Vec3 ambient;
+    CFXShaderRef lightShader;
+    CFXShaderRef modulate;
+    GLuint VAO;
+    GLuint quadVBO;
+    GLuint instanceVBO;
+    int instanceCapacity;
+} __CFXLighting;
+
+extern proc void* Ctor(
+    CFXLightingRef this,
+    int width,
+    int height,
+    int scale);
+
+extern proc void Resize(
+    CFXLightingRef this,
+    int width,
+    int height);
+
+extern proc int AddLight(
+    CFXLightingRef this,
+    CFXLight light);
+
+extern proc void RemoveLight(
+    CFXLightingRef this,
+    int index);
+
+extern proc void Draw(
+    CFXLightingRef this,
+    CFXRect camera);
+
+extern proc void Composite(
+    CFXLightingRef this);
+
+/**
+ * @brief Creates a point light.
+ */
+static inline CFXLight CFXPointLight(Vec2 position, GLfloat radius, Vec3 color, GLfloat intensity)
+{
+    return (CFXLight) {
+        .position = position, .radius = radius, .intensity = intensity, .color = color,
+        .direction = { 1.0f, 0.0f }, .innerCone = -1.0f, .outerCone = -1.0f };
+}
+
+/**
+ * @brief Creates a new CFXLighting module.
+ *
+ * @param width   Screen width in pixels.
+ * @param height  Screen height in pixels.
+ * @param scale   Divisor of the light buffer resolution, 4 for quarter size.
+ * @return A reference to the newly created CFXLighting.
+ */
+static inline CFXLightingRef NewCFXLighting(int width, int height, int scale)
+{
+    return Ctor((CFXLightingRef)CFCreate(CFXLighting), width, height, scale);
+}
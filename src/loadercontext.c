@@ -0,0 +1,364 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#if CFX_HEADLESS && !__EMSCRIPTEN__
+#include <EGL/egl.h>
+#endif
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include "loadercontext.h"
+
+class2(CFXLoaderContext);
+
+static void Push(CFXLoaderQueue* queue, CFXLoaderTask* task)
+{
+    task->next = nullptr;
+    if (queue->tail != nullptr)
+        queue->tail->next = task;
+    else
+        queue->head = task;
+    queue->tail = task;
+}
+
+static CFXLoaderTask* Pop(CFXLoaderQueue* queue)
+{
+    CFXLoaderTask* task = queue->head;
+    if (task != nullptr) {
+        queue->head = task->next;
+        if (queue->head == nullptr)
+            queue->tail = nullptr;
+    }
+    return task;
+}
+
+#if !__EMSCRIPTEN__
+static void* Worker(void* self)
+{
+    CFXLoaderContextRef this = self;
+    if (this->window != nullptr)
+        glfwMakeContextCurrent(this->window);
+#if CFX_HEADLESS
+    else
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, this->context);
+#endif
+
+    pthread_mutex_lock(&this->lock);
+    while (true) {
+        while (this->queued.head == nullptr && !this->stopping)
+            pthread_cond_wait(&this->wake, &this->lock);
+        if (this->stopping)
+            break;
+        CFXLoaderTask* task = Pop(&this->queued);
+        this->current = task->context;
+        pthread_mutex_unlock(&this->lock);
+        task->run(task->context);
+        // The flush sends the fence on, or the render thread could wait on it forever
+        task->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        pthread_mutex_lock(&this->lock);
+        Push(&this->done, task);
+        this->current = nullptr;
+        pthread_cond_broadcast(&this->ran);
+    }
+    pthread_mutex_unlock(&this->lock);
+
+    if (this->window != nullptr)
+        glfwMakeContextCurrent(nullptr);
+#if CFX_HEADLESS
+    else
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+    return nullptr;
+}
+#endif
+
+/**
+ * @brief Destructor for the CFXLoaderContext object.
+ *
+ * Publishes every task still posted, then stops the thread and destroys
+ * its context. Call on the render thread, before the game's context goes.
+ *
+ * @param self Pointer to the CFXLoaderContext instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXLoaderContextRef this = self;
+    Finish(this);
+    if (this->running) {
+        pthread_mutex_lock(&this->lock);
+        this->stopping = true;
+        pthread_cond_broadcast(&this->wake);
+        pthread_mutex_unlock(&this->lock);
+        pthread_join(this->thread, nullptr);
+    }
+#if !__EMSCRIPTEN__
+    if (this->window != nullptr)
+        glfwDestroyWindow(this->window);
+#endif
+#if CFX_HEADLESS && !__EMSCRIPTEN__
+    if (this->context != nullptr)
+        eglDestroyContext(this->display, this->context);
+#endif
+    pthread_cond_destroy(&this->ran);
+    pthread_cond_destroy(&this->wake);
+    pthread_mutex_destroy(&this->lock);
+}
+
+static void Init(CFXLoaderContextRef this)
+{
+    CFXLoaderContext->dtor = dtor;
+    this->window = nullptr;
+    this->display = nullptr;
+    this->context = nullptr;
+    this->running = false;
+    this->current = nullptr;
+    pthread_mutex_init(&this->lock, nullptr);
+    pthread_cond_init(&this->wake, nullptr);
+    pthread_cond_init(&this->ran, nullptr);
+    this->queued = (CFXLoaderQueue) {};
+    this->done = (CFXLoaderQueue) {};
+    this->outstanding = 0;
+    this->stopping = false;
+}
+
+static void Start(CFXLoaderContextRef this)
+{
+#if !__EMSCRIPTEN__
+    this->running = pthread_create(&this->thread, nullptr, Worker, this) == 0;
+    if (!this->running)
+        printf("| ERROR::LOADERCONTEXT: Failed to start the loader thread\n");
+#endif
+}
+
+/**
+ * @brief Constructor for a loader context sharing with a GLFW window's context.
+ *
+ * The window's context must be current on the calling thread, which must
+ * be the main thread; it is current again on return.
+ *
+ * @param this   Pointer to the CFXLoaderContext instance to initialize.
+ * @param share  Window whose context shares objects with the loader's.
+ * @return       Pointer to the initialized CFXLoaderContext instance.
+ */
+proc void* Ctor(CFXLoaderContextRef this, GLFWwindow* share)
+{
+    Init(this);
+#if __EMSCRIPTEN__
+    (void)share;
+#else
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    this->window = glfwCreateWindow(1, 1, "", nullptr, share);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    glfwMakeContextCurrent(share);
+    if (this->window == nullptr)
+        printf("| ERROR::LOADERCONTEXT: Failed to create a shared context, loading on the render thread\n");
+    else
+        Start(this);
+#endif
+    return this;
+}
+
+/**
+ * @brief Constructor for a loader context sharing with a surfaceless EGL context.
+ *
+ * @param this     Pointer to the CFXLoaderContext instance to initialize.
+ * @param display  EGL display of the context.
+ * @param share    EGL context that shares objects with the loader's.
+ * @return         Pointer to the initialized CFXLoaderContext instance.
+ */
+proc void* Ctor(CFXLoaderContextRef this, void* display, void* share)
+{
+    Init(this);
+#if !CFX_HEADLESS || __EMSCRIPTEN__
+    (void)display;
+    (void)share;
+#else
+    // The shared context must use the same config as the one it shares with
+    EGLint id = 0, configs = 0;
+    EGLConfig config;
+    eglQueryContext(display, share, EGL_CONFIG_ID, &id);
+    const EGLint configAttributes[] = { EGL_CONFIG_ID, id, EGL_NONE };
+    static const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 0, EGL_NONE };
+    EGLContext context = EGL_NO_CONTEXT;
+    if (eglChooseConfig(display, configAttributes, &config, 1, &configs) && configs > 0)
+        context = eglCreateContext(display, config, share, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        printf("| ERROR::LOADERCONTEXT: Failed to create a shared context, loading on the render thread: 0x%x\n", eglGetError());
+        return this;
+    }
+    this->display = display;
+    this->context = context;
+    Start(this);
+#endif
+    return this;
+}
+
+/**
+ * @brief Queues GL work for the loader thread.
+ *
+ * Without a loader thread both steps run right away on the calling thread.
+ * Any thread may post.
+ *
+ * @param this     Reference to the loader context.
+ * @param run      Work to do with the loader's context current.
+ * @param publish  Called by Publish on the render thread once run's commands are done, or nullptr.
+ * @param context  Passed to run and publish.
+ */
+proc void Post(CFXLoaderContextRef this, CFXLoaderProc run, CFXLoaderProc publish, void* context)
+{
+    if (!this->running) {
+        run(context);
+        if (publish != nullptr)
+            publish(context);
+        return;
+    }
+    CFXLoaderTask* task = calloc(1, sizeof(CFXLoaderTask));
+    task->run = run;
+    task->publish = publish;
+    task->context = context;
+    pthread_mutex_lock(&this->lock);
+    Push(&this->queued, task);
+    this->outstanding++;
+    pthread_cond_signal(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+}
+
+static void Hand(CFXLoaderContextRef this, CFXLoaderTask* task)
+{
+    glDeleteSync(task->fence);
+    if (task->publish != nullptr)
+        task->publish(task->context);
+    free(task);
+    pthread_mutex_lock(&this->lock);
+    this->outstanding--;
+    pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * @brief Publishes the tasks whose commands the GPU has finished, oldest first.
+ *
+ * Call on the render thread; CFXGame::Tick does so every frame.
+ *
+ * @param this  Reference to the loader context.
+ * @return      Number of tasks published.
+ */
+proc int Publish(CFXLoaderContextRef this)
+{
+    int published = 0;
+    while (true) {
+        pthread_mutex_lock(&this->lock);
+        CFXLoaderTask* task = this->done.head;
+        if (task == nullptr || glClientWaitSync(task->fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            pthread_mutex_unlock(&this->lock);
+            return published;
+        }
+        Pop(&this->done);
+        pthread_mutex_unlock(&this->lock);
+        Hand(this, task);
+        published++;
+    }
+}
+
+/**
+ * @brief Waits for every posted task and publishes it.
+ *
+ * Call on the render thread when every result is needed now, such as
+ * before the objects the tasks point to go away.
+ *
+ * @param this  Reference to the loader context.
+ */
+proc void Finish(CFXLoaderContextRef this)
+{
+    pthread_mutex_lock(&this->lock);
+    while (this->outstanding > 0) {
+        while (this->done.head == nullptr)
+            pthread_cond_wait(&this->ran, &this->lock);
+        CFXLoaderTask* task = Pop(&this->done);
+        pthread_mutex_unlock(&this->lock);
+        while (glClientWaitSync(task->fence, 0, 1000000000) == GL_TIMEOUT_EXPIRED)
+            continue;
+        Hand(this, task);
+        pthread_mutex_lock(&this->lock);
+    }
+    pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * @brief Removes the task posted with context from a queue.
+ *
+ * @return The task, or nullptr if the queue does not hold it.
+ */
+static CFXLoaderTask* Remove(CFXLoaderQueue* queue, void* context)
+{
+    CFXLoaderTask* previous = nullptr;
+    for (CFXLoaderTask* task = queue->head; task != nullptr; previous = task, task = task->next) {
+        if (task->context != context)
+            continue;
+        if (previous != nullptr)
+            previous->next = task->next;
+        else
+            queue->head = task->next;
+        if (queue->tail == task)
+            queue->tail = previous;
+        return task;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Waits for one posted task and publishes it, leaving the others to Publish.
+ *
+ * Call on the render thread when that task's result is needed now, such as
+ * a program's first Use. Returns at once if the task was already published.
+ *
+ * @param this     Reference to the loader context.
+ * @param context  Context the task was posted with.
+ */
+proc void Finish(CFXLoaderContextRef this, void* context)
+{
+    pthread_mutex_lock(&this->lock);
+    CFXLoaderTask* task;
+    while ((task = Remove(&this->done, context)) == nullptr) {
+        bool waiting = this->current == context;
+        for (CFXLoaderTask* queued = this->queued.head; queued != nullptr && !waiting; queued = queued->next)
+            waiting = queued->context == context;
+        if (!waiting) {
+            pthread_mutex_unlock(&this->lock);
+            return;
+        }
+        pthread_cond_wait(&this->ran, &this->lock);
+    }
+    pthread_mutex_unlock(&this->lock);
+    while (glClientWaitSync(task->fence, 0, 1000000000) == GL_TIMEOUT_EXPIRED)
+        continue;
+    Hand(this, task);
+}
+
+/**
+ * @brief Returns the number of tasks posted but not yet published.
+ *
+ * @param this Reference to the loader context.
+ * @return     Tasks outstanding; 0 once everything posted has been published.
+ */
+proc int Pending(CFXLoaderContextRef this)
+{
+    pthread_mutex_lock(&this->lock);
+    int pending = this->outstanding;
+    pthread_mutex_unlock(&this->lock);
+    return pending;
+}
+
+/**
+ * @brief Reports whether the loader thread started.
+ *
+ * A context that is not running does its tasks on the posting thread, so
+ * only the render thread may post to it.
+ */
+proc bool IsRunning(CFXLoaderContextRef this)
+{
+    return this->running;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <pthread.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+
+extern CFClassRef CFXLoaderContext;
+typedef struct __CFXLoaderContext* CFXLoaderContextRef;
+
+/**
+ * @brief A step of a loader task; runs with the thread's context current.
+ */
+typedef void (*CFXLoaderProc)(void* context);
+
+/**
+ * @struct CFXLoaderTask
+ * @brief GL work for the loader thread and how to hand its result over.
+ *
+ * Members:
+ * - run:      Runs on the loader thread, e.g. uploading or compiling.
+ * - publish:  Runs on the render thread once the GPU has finished run's
+ *             commands, e.g. swapping the new object into place.
+ * - context:  Passed to both.
+ * - fence:    Fence placed after run's commands.
+ * - next:     Next task in the same queue.
+ */
+typedef struct CFXLoaderTask {
+    CFXLoaderProc run;
+    CFXLoaderProc publish;
+    void* context;
+    GLsync fence;
+    struct CFXLoaderTask* next;
+} CFXLoaderTask;
+
+/**
+ * @struct CFXLoaderQueue
+ * @brief First in, first out list of tasks.
+ */
+typedef struct CFXLoaderQueue {
+    CFXLoaderTask* head;
+    CFXLoaderTask* tail;
+} CFXLoaderQueue;
+
+/**
+ * @struct __CFXLoaderContext
+ * @brief A thread with its own GL context, sharing objects with the render thread's.
+ *
+ * Textures uploaded and programs linked on the loader thread never block
+ * a frame. Each task runs, then a fence is placed and flushed; Publish, on
+ * the render thread, hands over the results of the tasks whose fences have
+ * signaled, which is when the new objects are complete and safe to use
+ * from the render context.
+ *
+ * The context is a hidden 1 x 1 GLFW window sharing with the game's, or a
+ * surfaceless EGL context sharing with a headless game's. The Emscripten
+ * build has one context per canvas; there, and if the shared context
+ * cannot be created, Post runs and publishes each task on the spot.
+ *
+ * Members:
+ * - obj:      Base object information for the loader context.
+ * - window:   Hidden GLFW window owning the shared context, or nullptr.
+ * - display, context: EGL display and shared context, or nullptr.
+ * - thread:   The loader thread.
+ * - running:  Whether the loader thread was started.
+ * - lock:     Guards the queues, outstanding and stopping.
+ * - wake:     Signaled when a task is posted or the thread should stop.
+ * - ran:      Signaled when a task has run.
+ * - queued:   Tasks waiting to run.
+ * - current:  Context of the task the thread is running, or nullptr.
+ * - done:     Tasks run but not yet published.
+ * - outstanding: Tasks posted but not yet published.
+ * - stopping: Set by the destructor to end the thread.
+ */
+typedef struct __CFXLoaderContext {
+    __CFObject obj;
+    GLFWwindow* window;
+    void* display;
+    void* context;
+    pthread_t thread;
+    bool running;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t ran;
+    CFXLoaderQueue queued;
+    void* current;
+    CFXLoaderQueue done;
+    int outstanding;
+    bool stopping;
+} __CFXLoaderContext;
+
+extern proc void* Ctor(
+    CFXLoaderContextRef this,
+    GLFWwindow* share);
+
+extern proc void* Ctor(
+    CFXLoaderContextRef this,
+    void* display,
+    void* share);
+
+extern proc void Post(
+    CFXLoaderContextRef this,
+    CFXLoaderProc run,
+    CFXLoaderProc publish,
+    void* context);
+
+extern proc int Publish(
+    CFXLoaderContextRef this);
+
+extern proc void Finish(
+    CFXLoaderContextRef this);
+
+extern proc void Finish(
+    CFXLoaderContextRef this,
+    void* context);
+
+extern proc int Pending(
+    CFXLoaderContextRef this);
+
+extern proc bool IsRunning(
+    CFXLoaderContextRef this);
+
+/**
+ * @brief Creates a loader context sharing objects with a GLFW window's context.
+ *
+ * Call on the main thread, which GLFW requires for creating windows.
+ *
+ * @param share  Window whose context shares objects with the loader's.
+ * @return A reference to the newly created CFXLoaderContext.
+ */
+static inline CFXLoaderContextRef NewCFXLoaderContext(GLFWwindow* share)
+{
+    return Ctor((CFXLoaderContextRef)CFCreate(CFXLoaderContext), share);
+}
+
+/**
+ * @brief Creates a loader context sharing objects with an EGL context.
+ *
+ * @param display  EGL display of the context.
+ * @param share    EGL context that shares objects with the loader's.
+ * @return A reference to the newly created CFXLoaderContext.
+ */
+static inline CFXLoaderContextRef NewCFXLoaderContextEGL(void* display, void* share)
+{
+    return Ctor((CFXLoaderContextRef)CFCreate(CFXLoaderContext), display, share);
+}
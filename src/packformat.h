@@ -0,0 +1,127 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * On-disk layout of a CFX asset pack, shared by CFXAssetPack and the
+ * cfxpack tool that writes packs (tools/cfxpack).
+ *
+ * A pack is one file:
+ *
+ *     CFXPackHeader
+ *     uint32_t slots[slotCount]        hashed index
+ *     CFXPackEntry entries[entryCount] sorted by name
+ *     names                            NUL terminated
+ *     blobs                            each at a CFX_PACK_ALIGNMENT offset
+ *
+ * Fields are little-endian and every offset is from the start of the file,
+ * so a mapped pack is used in place. A name hashes with CFXPack_Hash to a
+ * slot; slots hold an entry index plus one, or 0 when empty, and collisions
+ * probe the next slot. slotCount is a power of two at least twice
+ * entryCount, so a lookup touches one or two slots. Each blob is followed
+ * by a NUL byte not counted in its size, as embedded files are, so text
+ * files can be used as C strings in place.
+ *
+ * An entry flagged CFX_PACK_IMAGE holds an image already decoded: width x
+ * height pixels of channels bytes, rows bottom to top as GL expects, so
+ * loading it skips the image decoder. Its contents are split into blocks
+ * of blockSize bytes, the last one shorter. With CFX_PACK_LZ4 each block
+ * is compressed on its own, so blocks decompress in parallel; the blob
+ * then starts with a uint32_t per block, the end of that block measured
+ * from the end of this table, followed by the compressed blocks.
+ *
+ * Names are paths relative to the packed directory with '/' separators.
+ */
+
+#define CFX_PACK_MAGIC "CFXPACK"
+#define CFX_PACK_VERSION 2
+#define CFX_PACK_ALIGNMENT 64
+#define CFX_PACK_BLOCK_SIZE (256 * 1024)
+
+/** CFXPackEntry::flags: the entry holds decoded pixels. */
+#define CFX_PACK_IMAGE 0x1
+/** CFXPackEntry::flags: the entry's blocks are LZ4 compressed. */
+#define CFX_PACK_LZ4 0x2
+
+/**
+ * @struct CFXPackHeader
+ * @brief The start of a pack file.
+ *
+ * Members:
+ * - magic:      CFX_PACK_MAGIC with its NUL.
+ * - version:    CFX_PACK_VERSION.
+ * - entryCount: Number of entries.
+ * - slotCount:  Number of index slots, a power of two.
+ * - size:       Length of the whole file, to catch truncation.
+ * - slots, entries, names: Offsets of the index, entry table and names.
+ */
+typedef struct CFXPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t slots;
+    uint64_t entries;
+    uint64_t names;
+} CFXPackHeader;
+
+/**
+ * @struct CFXPackEntry
+ * @brief One file in a pack.
+ *
+ * Members:
+ * - hash:       CFXPack_Hash of the name, compared before the name itself.
+ * - offset:     Offset of the contents.
+ * - size:       Length of the contents in bytes, once decompressed.
+ * - packedSize: Length of the contents as stored.
+ * - name:       Offset of the name.
+ * - nameLength: Length of the name, without its NUL.
+ * - flags:      CFX_PACK_IMAGE and CFX_PACK_LZ4 bits.
+ * - blockSize:  Bytes per block, or 0 for a single block.
+ * - width, height, channels: Size of the image, for CFX_PACK_IMAGE.
+ */
+typedef struct CFXPackEntry {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t packedSize;
+    uint32_t name;
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t blockSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t reserved;
+} CFXPackEntry;
+
+/**
+ * @brief FNV-1a hash of a name, as the index is built with.
+ */
+static inline uint64_t CFXPack_Hash(const char* name, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+/**
+ * @brief Number of blocks an entry's contents are split into.
+ */
+static inline uint32_t CFXPack_BlockCount(const CFXPackEntry* entry)
+{
+    if (entry->blockSize == 0 || entry->size == 0)
+        return 1;
+    return (uint32_t)((entry->size + entry->blockSize - 1) / entry->blockSize);
+}
+
+/**
+ * @brief Rounds an offset up to the next blob boundary.
+ */
+static inline uint64_t CFXPack_Align(uint64_t offset)
+{
+    return (offset + CFX_PACK_ALIGNMENT - 1) & ~(uint64_t)(CFX_PACK_ALIGNMENT - 1);
+}
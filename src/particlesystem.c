@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "particlesystem.h"
+
+class2(CFXParticleSystem);
+
+/**
+ * @brief Returns a uniformly distributed random number in [lo, hi].
+ */
+static inline float RandomRange(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+/**
+ * @brief Allocates a 16 byte aligned, zeroed pool of capacity elements.
+ */
+static void* NewPool(int capacity, size_t size)
+{
+    void* pool = aligned_alloc(16, capacity * size);
+    memset(pool, 0, capacity * size);
+    return pool;
+}
+
+/**
+ * @brief Constructor for the CFXParticleSystem object.
+ *
+ * Allocates the particle pools, sets emitter defaults and configures a VAO
+ * with a static unit quad plus two per-instance streams (position and color)
+ * that are refilled straight from the pools on every Draw.
+ *
+ * @param this      Pointer to the CFXParticleSystem instance to initialize.
+ * @param shader    Reference to the instancing shader.
+ * @param capacity  Maximum number of live particles; rounded up to a multiple of 4,
+ *                  and at least 4.
+ * @return          Pointer to the initialized CFXParticleSystem instance.
+ */
+proc void* Ctor(CFXParticleSystemRef this, CFXShaderRef shader, int capacity)
+{
+    CFXParticleSystem->dtor = dtor;
+    this->shader = shader;
+    // aligned_alloc may return nullptr for a size of 0
+    this->capacity = (Max(capacity, 1) + 3) & ~3;
+    this->count = 0;
+
+    this->position = NewPool(this->capacity, sizeof(Vec2));
+    this->velocity = NewPool(this->capacity, sizeof(Vec2));
+    this->color = NewPool(this->capacity, sizeof(Vec4));
+    this->colorDelta = NewPool(this->capacity, sizeof(Vec4));
+    this->life = NewPool(this->capacity, sizeof(float));
+
+    this->origin = (Vec2) { 0.0f, 0.0f };
+    this->gravity = (Vec2) { 0.0f, 0.0f };
+    this->minVelocity = (Vec2) { -50.0f, -50.0f };
+    this->maxVelocity = (Vec2) { 50.0f, 50.0f };
+    this->startColor = (Vec4) { 1.0f, 1.0f, 1.0f, 1.0f };
+    this->endColor = (Vec4) { 1.0f, 1.0f, 1.0f, 0.0f };
+    this->minLife = 0.5f;
+    this->maxLife = 1.0f;
+    this->size = 4.0f;
+
+    GLfloat vertices[] = {
+        // Pos        // Tex
+        -0.5f, 0.5f, 0.0f, 1.0f,
+        0.5f, -0.5f, 1.0f, 0.0f,
+        -0.5f, -0.5f, 0.0f, 0.0f,
+
+        -0.5f, 0.5f, 0.0f, 1.0f,
+        0.5f, 0.5f, 1.0f, 1.0f,
+        0.5f, -0.5f, 1.0f, 0.0f
+    };
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->positionVBO);
+    glGenBuffers(1, &this->colorVBO);
+
+    glBindVertexArray(this->VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(Vec2), nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid*)0);
+    glVertexAttribDivisor(1, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->colorVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(Vec4), nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vec4), (GLvoid*)0);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXParticleSystem object.
+ *
+ * Releases the particle pools and the OpenGL buffers and vertex array.
+ *
+ * @param self Pointer to the CFXParticleSystem instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXParticleSystemRef this = self;
+    free(this->position);
+    free(this->velocity);
+    free(this->color);
+    free(this->colorDelta);
+    free(this->life);
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
+    CFXDeletionQueue_Buffers(1, &this->positionVBO);
+    CFXDeletionQueue_Buffers(1, &this->colorVBO);
+}
+
+/**
+ * @brief Spawns new particles at the emitter origin.
+ *
+ * Each particle gets a random velocity and life within the emitter ranges and
+ * a per-second color delta that takes it from startColor to endColor over its
+ * life. Emission stops silently when the pool is full.
+ *
+ * @param this   Reference to the particle system.
+ * @param count  Number of particles to spawn.
+ * @return       Number of particles actually spawned.
+ */
+proc int Emit(CFXParticleSystemRef this, int count)
+{
+    int room = this->capacity - this->count;
+    int spawn = count < room ? count : room;
+    for (int i = this->count; i < this->count + spawn; i++) {
+        float life = RandomRange(this->minLife, this->maxLife);
+        this->position[i] = this->origin;
+        this->velocity[i] = (Vec2) {
+            RandomRange(this->minVelocity.x, this->maxVelocity.x),
+            RandomRange(this->minVelocity.y, this->maxVelocity.y)
+        };
+        this->color[i] = this->startColor;
+        this->colorDelta[i] = (this->endColor - this->startColor) / life;
+        this->life[i] = life;
+    }
+    this->count += spawn;
+    return spawn;
+}
+
+/**
+ * @brief Advances every live particle and removes the dead ones.
+ *
+ * The integration runs over the pools as 4-wide vectors: the Vec2 pools are
+ * viewed as Vec4 so two particles are integrated per iteration, and the life
+ * pool is viewed as Vec4 so four particles age per iteration. The padding at
+ * the end of each pool makes the overrun on the last iteration harmless.
+ * Dead particles are then compacted by swapping in the last live particle,
+ * which keeps the live range dense without any allocation.
+ *
+ * @param this   Reference to the particle system.
+ * @param delta  Elapsed time in seconds, as computed by Tick.
+ */
+proc void Update(CFXParticleSystemRef this, GLfloat delta)
+{
+    int pairs = (this->count + 1) >> 1;
+    int quads = (this->count + 3) >> 2;
+    Vec4* restrict position = (Vec4*)this->position;
+    Vec4* restrict velocity = (Vec4*)this->velocity;
+    Vec4* restrict life = (Vec4*)this->life;
+    Vec4 gravity = (Vec4) { this->gravity.x, this->gravity.y, this->gravity.x, this->gravity.y } * delta;
+
+    for (int i = 0; i < pairs; i++) {
+        velocity[i] += gravity;
+        position[i] += velocity[i] * delta;
+    }
+    for (int i = 0; i < this->count; i++)
+        this->color[i] += this->colorDelta[i] * delta;
+    for (int i = 0; i < quads; i++)
+        life[i] -= delta;
+
+    int i = 0;
+    while (i < this->count) {
+        if (this->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        int last = --this->count;
+        this->position[i] = this->position[last];
+        this->velocity[i] = this->velocity[last];
+        this->color[i] = this->color[last];
+        this->colorDelta[i] = this->colorDelta[last];
+        this->life[i] = this->life[last];
+    }
+}
+
+/**
+ * @brief Draws every live particle with a single instanced draw call.
+ *
+ * The position and color pools are streamed to the GPU as-is; the buffers are
+ * orphaned first so the driver never has to wait on the previous frame.
+ *
+ * @param this     Reference to the particle system.
+ * @param texture  Texture applied to every particle quad.
+ */
+proc void Draw(CFXParticleSystemRef this, CFXTexture2DRef texture)
+{
+    if (this->count == 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(Vec2), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, this->count * sizeof(Vec2), this->position);
+    glBindBuffer(GL_ARRAY_BUFFER, this->colorVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(Vec4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, this->count * sizeof(Vec4), this->color);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Use(this->shader);
+    SetFloat(this->shader, "size", this->size, false);
+
+    glActiveTexture(GL_TEXTURE0);
+    Bind(texture);
+
+    glBindVertexArray(this->VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, this->count);
+    glBindVertexArray(0);
+}
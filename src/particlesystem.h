@@ -0,0 +1,106 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "texture2d.h"          // IWYU pragma: keep
+#include "shader.h"
+#include "tglm.h"
+
+extern CFClassRef CFXParticleSystem;
+typedef struct __CFXParticleSystem* CFXParticleSystemRef;
+
+/**
+ * @struct __CFXParticleSystem
+ * @brief A data-oriented CPU particle emitter rendered with one instanced draw.
+ *
+ * Particles are kept in structure-of-arrays pools so the update loop can run
+ * over contiguous Vec2/Vec4 lanes. Pools are allocated once, 16 byte aligned
+ * and padded to a multiple of 4 entries, so the update may safely process
+ * pairs (Vec2 pools) or quads (life pool) of particles per iteration. Dead
+ * particles are removed by swapping the last live particle into their slot.
+ *
+ * The shader is expected to read:
+ * - location 0: vec4 vertex (xy = unit quad corner centered on 0, zw = uv)
+ * - location 1: vec2 per-instance particle position
+ * - location 2: vec4 per-instance particle color
+ * - uniform float size: particle size in world units
+ *
+ * Members:
+ * - obj:           Base object information for the particle system.
+ * - shader:        Reference to the shader used to draw the particles.
+ * - VAO:           OpenGL Vertex Array Object identifier.
+ * - VBO:           OpenGL Vertex Buffer Object holding the unit quad.
+ * - positionVBO:   Per-instance position stream.
+ * - colorVBO:      Per-instance color stream.
+ * - position:      Particle positions.
+ * - velocity:      Particle velocities in units per second.
+ * - color:         Particle colors (RGBA).
+ * - colorDelta:    Color change per second, so particles fade toward endColor.
+ * - life:          Remaining life of each particle in seconds.
+ * - count:         Number of live particles.
+ * - capacity:      Size of each pool.
+ * - origin:        Emitter position.
+ * - gravity:       Constant acceleration applied to every particle.
+ * - minVelocity:   Lower bound of the random spawn velocity.
+ * - maxVelocity:   Upper bound of the random spawn velocity.
+ * - startColor:    Color of a newly spawned particle.
+ * - endColor:      Color a particle reaches at the end of its life.
+ * - minLife:       Lower bound of the random particle life in seconds.
+ * - maxLife:       Upper bound of the random particle life in seconds.
+ * - size:          Particle size passed to the shader.
+ */
+typedef struct __CFXParticleSystem {
+    __CFObject obj;
+    CFXShaderRef shader;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint positionVBO;
+    GLuint colorVBO;
+    Vec2* position;
+    Vec2* velocity;
+    Vec4* color;
+    Vec4* colorDelta;
+    float* life;
+    int count;
+    int capacity;
+    Vec2 origin;
+    Vec2 gravity;
+    Vec2 minVelocity;
+    Vec2 maxVelocity;
+    Vec4 startColor;
+    Vec4 endColor;
+    GLfloat minLife;
+    GLfloat maxLife;
+    GLfloat size;
+} __CFXParticleSystem;
+
+extern proc void* Ctor(
+    CFXParticleSystemRef this,
+    CFXShaderRef shader,
+    int capacity);
+
+extern proc int Emit(
+    CFXParticleSystemRef this,
+    int count);
+
+extern proc void Update(
+    CFXParticleSystemRef this,
+    GLfloat delta);
+
+extern proc void Draw(
+    CFXParticleSystemRef this,
+    CFXTexture2DRef texture);
+
+/**
+ * @brief Creates a new CFXParticleSystem with the given shader and pool size.
+ *
+ * @param shader    The instancing shader used to draw the particles.
+ * @param capacity  Maximum number of live particles.
+ * @return A reference to the newly created CFXParticleSystem.
+ */
+static inline CFXParticleSystemRef NewCFXParticleSystem(CFXShaderRef shader, int capacity)
+{
+    return Ctor((CFXParticleSystemRef)CFCreate(CFXParticleSystem), shader, capacity);
+}
@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "path.h"
+
+class2(CFXPath);
+
+static unsigned NextPathId = 1;
+
+/**
+ * @brief Constructor for the CFXPath object.
+ *
+ * @param this Pointer to the CFXPath instance to initialize.
+ * @return     Pointer to the initialized CFXPath instance.
+ */
+proc void* Ctor(CFXPathRef this)
+{
+    CFXPath->dtor = dtor;
+    this->commands = nullptr;
+    this->count = 0;
+    this->capacity = 0;
+    this->id = NextPathId++;
+    this->version = 0;
+    this->cacheSlot = -1;
+    this->color = (Vec4) { 1.0f, 1.0f, 1.0f, 1.0f };
+    this->gradient = false;
+    this->gradientStart = (Vec2) { 0.0f, 0.0f };
+    this->gradientEnd = (Vec2) { 0.0f, 0.0f };
+    this->gradientColor = this->color;
+    this->strokeWidth = 0.0f;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXPath object.
+ *
+ * @param self Pointer to the CFXPath instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXPathRef this = self;
+    free(this->commands);
+}
+
+static void Push(CFXPathRef this, CFXPathCommand command)
+{
+    if (this->count == this->capacity) {
+        this->capacity = this->capacity ? this->capacity * 2 : 16;
+        this->commands = realloc(this->commands, this->capacity * sizeof(CFXPathCommand));
+    }
+    this->commands[this->count++] = command;
+    this->version++;
+}
+
+/**
+ * @brief Removes every command, keeping the paint.
+ */
+proc void Clear(CFXPathRef this)
+{
+    this->count = 0;
+    this->version++;
+}
+
+/**
+ * @brief Starts a new subpath.
+ */
+proc void MoveTo(CFXPathRef this, GLfloat x, GLfloat y)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_MOVE, { { x, y } } });
+}
+
+/**
+ * @brief Adds a straight segment.
+ */
+proc void LineTo(CFXPathRef this, GLfloat x, GLfloat y)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_LINE, { { x, y } } });
+}
+
+/**
+ * @brief Adds a quadratic Bézier segment.
+ */
+proc void QuadTo(CFXPathRef this, GLfloat cx, GLfloat cy, GLfloat x, GLfloat y)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_QUAD, { { cx, cy }, { x, y } } });
+}
+
+/**
+ * @brief Adds a cubic Bézier segment.
+ */
+proc void CubicTo(CFXPathRef this, GLfloat c1x, GLfloat c1y, GLfloat c2x, GLfloat c2y, GLfloat x, GLfloat y)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_CUBIC, { { c1x, c1y }, { c2x, c2y }, { x, y } } });
+}
+
+/**
+ * @brief Adds a circular arc, joined to the current point by a straight segment.
+ *
+ * Angles are in radians and the arc sweeps from startAngle to endAngle;
+ * with y pointing down, increasing angles turn clockwise on screen.
+ */
+proc void Arc(CFXPathRef this, GLfloat cx, GLfloat cy, GLfloat radius, GLfloat startAngle, GLfloat endAngle)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_ARC, { { cx, cy }, { radius, 0.0f }, { startAngle, endAngle } } });
+}
+
+/**
+ * @brief Closes the current subpath.
+ */
+proc void Close(CFXPathRef this)
+{
+    Push(this, (CFXPathCommand) { CFX_PATH_CLOSE });
+}
+
+/**
+ * @brief Paints the path with a flat color.
+ */
+proc void SetFill(CFXPathRef this, Vec4 color)
+{
+    this->color = color;
+    this->gradient = false;
+    this->version++;
+}
+
+/**
+ * @brief Paints the path with a linear gradient, clamped beyond its ends.
+ *
+ * The gradient is evaluated at the tessellated vertices and interpolated
+ * across triangles, which is exact for a linear ramp.
+ */
+proc void SetLinearGradient(CFXPathRef this, Vec2 start, Vec2 end, Vec4 startColor, Vec4 endColor)
+{
+    this->gradient = true;
+    this->gradientStart = start;
+    this->gradientEnd = end;
+    this->color = startColor;
+    this->gradientColor = endColor;
+    this->version++;
+}
+
+/**
+ * @brief Outlines the path instead of filling it.
+ *
+ * @param this   Reference to the path.
+ * @param width  Outline width in path units; 0 goes back to filling.
+ */
+proc void SetStroke(CFXPathRef this, GLfloat width)
+{
+    this->strokeWidth = width;
+    this->version++;
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "tglm.h"
+
+extern CFClassRef CFXPath;
+typedef struct __CFXPath* CFXPathRef;
+
+/**
+ * @enum CFXPathVerb
+ * @brief Kinds of path commands.
+ */
+typedef enum CFXPathVerb {
+    CFX_PATH_MOVE,
+    CFX_PATH_LINE,
+    CFX_PATH_QUAD,
+    CFX_PATH_CUBIC,
+    CFX_PATH_ARC,
+    CFX_PATH_CLOSE,
+} CFXPathVerb;
+
+/**
+ * @struct CFXPathCommand
+ * @brief One path command and its points.
+ *
+ * Lines use p[0], quadratic curves p[0..1] and cubic curves p[0..2], with
+ * the end point last. Arcs store the center in p[0], the radius in p[1].x
+ * and the start and end angles in p[2].
+ */
+typedef struct CFXPathCommand {
+    CFXPathVerb verb;
+    Vec2 p[3];
+} CFXPathCommand;
+
+/**
+ * @struct __CFXPath
+ * @brief A vector shape and its paint, tessellated on demand by CFXPathRenderer.
+ *
+ * Every edit bumps version, which is how the renderer's tessellation cache
+ * knows a cached mesh is stale. id identifies the path in that cache; unlike
+ * the object's address it is never reused.
+ *
+ * Each subpath is filled on its own, so holes need to be drawn as separate
+ * paths on top. A stroked path is outlined instead of filled.
+ *
+ * Members:
+ * - obj:            Base object information for the path.
+ * - commands:       Path commands in order.
+ * - count:          Number of commands.
+ * - capacity:       Allocated size of commands.
+ * - id:             Unique identity of the path.
+ * - version:        Incremented on every change to the geometry or paint.
+ * - cacheSlot:      Hint to the renderer's cache entry for the path.
+ * - color:          Fill color, or the gradient's start color.
+ * - gradient:       Whether the paint is a linear gradient.
+ * - gradientStart:  Point where the gradient has color.
+ * - gradientEnd:    Point where the gradient has gradientColor.
+ * - gradientColor:  End color of the gradient.
+ * - strokeWidth:    Outline width in path units; 0 fills the path.
+ */
+typedef struct __CFXPath {
+    __CFObject obj;
+    CFXPathCommand* commands;
+    int count;
+    int capacity;
+    unsigned id;
+    unsigned version;
+    int cacheSlot;
+    Vec4 color;
+    bool gradient;
+    Vec2 gradientStart;
+    Vec2 gradientEnd;
+    Vec4 gradientColor;
+    GLfloat strokeWidth;
+} __CFXPath;
+
+extern proc void* Ctor(
+    CFXPathRef this);
+
+extern proc void Clear(
+    CFXPathRef this);
+
+extern proc void MoveTo(
+    CFXPathRef this,
+    GLfloat x,
+    GLfloat y);
+
+extern proc void LineTo(
+    CFXPathRef this,
+    GLfloat x,
+    GLfloat y);
+
+extern proc void QuadTo(
+    CFXPathRef this,
+    GLfloat cx,
+    GLfloat cy,
+    GLfloat x,
+    GLfloat y);
+
+extern proc void CubicTo(
+    CFXPathRef this,
+    GLfloat c1x,
+    GLfloat c1y,
+    GLfloat c2x,
+    GLfloat c2y,
+    GLfloat x,
+    GLfloat y);
+
+extern proc void Arc(
+    CFXPathRef this,
+    GLfloat cx,
+    GLfloat cy,
+    GLfloat radius,
+    GLfloat startAngle,
+    GLfloat endAngle);
+
+extern proc void Close(
+    CFXPathRef this);
+
+extern proc void SetFill(
+    CFXPathRef this,
+    Vec4 color);
+
+extern proc void SetLinearGradient(
+    CFXPathRef this,
+    Vec2 start,
+    Vec2 end,
+    Vec4 startColor,
+    Vec4 endColor);
+
+extern proc void SetStroke(
+    CFXPathRef this,
+    GLfloat width);
+
+/**
+ * @brief Creates a new, empty CFXPath filled with opaque white.
+ *
+ * @return A reference to the newly created CFXPath.
+ */
+static inline CFXPathRef NewCFXPath()
+{
+    return Ctor((CFXPathRef)CFCreate(CFXPath));
+}
@@ -0,0 +1,578 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "pathrenderer.h"
+
+class2(CFXPathRenderer);
+
+/**
+ * Frames a mesh may go undrawn before it is evicted.
+ */
+constexpr int EvictAfterFrames = 120;
+
+/**
+ * Largest distance, in pixels, between a curve and its flattened polyline.
+ */
+constexpr float Tolerance = 0.25f;
+
+/**
+ * Upper bound on the segments a single curve or arc is flattened into.
+ */
+constexpr int MaxSegments = 256;
+
+/**
+ * Vertices are in pixels of the view, y pointing down.
+ */
+static const GLchar* PathVertexSource = CFX_GLSL_VERSION
+    "layout(location = 0) in vec2 position;\n"
+    "layout(location = 1) in vec4 color;\n"
+    "uniform vec4 view;\n"
+    "out vec4 paint;\n"
+    "void main() {\n"
+    "    paint = color;\n"
+    "    vec2 n = (position - view.xy) / view.zw;\n"
+    "    gl_Position = vec4(n.x * 2.0 - 1.0, 1.0 - n.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const GLchar* PathFragmentSource = CFX_GLSL_VERSION
+    "in vec4 paint;\n"
+    "out vec4 color;\n"
+    "void main() { color = paint; }\n";
+
+/**
+ * @brief Constructor for the CFXPathRenderer object.
+ *
+ * @param this Pointer to the CFXPathRenderer instance to initialize.
+ * @return     Pointer to the initialized CFXPathRenderer instance.
+ */
+proc void* Ctor(CFXPathRendererRef this)
+{
+    CFXPathRenderer->dtor = dtor;
+    this->view = (CFXRect) { 0, 0, 1, 1 };
+    this->frame = 0;
+    this->cache = nullptr;
+    this->cacheCount = 0;
+    this->cacheCapacity = 0;
+    this->batch = nullptr;
+    this->batchCount = 0;
+    this->batchCapacity = 0;
+    this->points = nullptr;
+    this->pointCount = 0;
+    this->pointCapacity = 0;
+    this->contours = nullptr;
+    this->contourCount = 0;
+    this->contourCapacity = 0;
+    this->scratch = nullptr;
+    this->scratchCapacity = 0;
+    this->miters = nullptr;
+    this->miterCapacity = 0;
+    this->tessellations = 0;
+
+    this->shader = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(this->shader, PathVertexSource, PathFragmentSource);
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CFXPathVertex), (void*)offsetof(CFXPathVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(CFXPathVertex), (void*)offsetof(CFXPathVertex, color));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXPathRenderer object.
+ *
+ * @param self Pointer to the CFXPathRenderer instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXPathRendererRef this = self;
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
+    CFUnref(this->shader);
+    for (int i = 0; i < this->cacheCount; i++)
+        free(this->cache[i].vertices);
+    free(this->cache);
+    free(this->batch);
+    free(this->points);
+    free(this->contours);
+    free(this->scratch);
+    free(this->miters);
+}
+
+/**
+ * @brief Grows an array to hold at least needed elements, doubling its capacity.
+ */
+static void* Grow(void* array, int* capacity, int needed, size_t size)
+{
+    if (needed <= *capacity)
+        return array;
+    int grown = *capacity ? *capacity : 64;
+    while (grown < needed)
+        grown *= 2;
+    *capacity = grown;
+    return realloc(array, grown * size);
+}
+
+static bool Near(Vec2 a, Vec2 b, float epsilon)
+{
+    float dx = b.x - a.x, dy = b.y - a.y;
+    return dx * dx + dy * dy <= epsilon * epsilon;
+}
+
+/**
+ * @brief Appends a point to the last contour, dropping it when it repeats the previous one.
+ */
+static void AddPoint(CFXPathRendererRef this, Vec2 p, float epsilon)
+{
+    CFXPathContour* contour = &this->contours[this->contourCount - 1];
+    if (contour->count > 0 && Near(this->points[this->pointCount - 1], p, epsilon))
+        return;
+    this->points = Grow(this->points, &this->pointCapacity, this->pointCount + 1, sizeof(Vec2));
+    this->points[this->pointCount++] = p;
+    contour->count++;
+}
+
+static void BeginContour(CFXPathRendererRef this, Vec2 p, float epsilon)
+{
+    this->contours = Grow(this->contours, &this->contourCapacity, this->contourCount + 1, sizeof(CFXPathContour));
+    this->contours[this->contourCount++] = (CFXPathContour) { this->pointCount, 0, false };
+    AddPoint(this, p, epsilon);
+}
+
+static int ClampSegments(float n)
+{
+    return n < 1.0f ? 1 : n > MaxSegments ? MaxSegments : (int)ceilf(n);
+}
+
+/**
+ * @brief Flattens the path into polylines within tolerance, one contour per subpath.
+ *
+ * Bézier segment counts come from Wang's formula, which bounds the distance
+ * between a curve and its uniform subdivision by its second differences.
+ */
+static void Flatten(CFXPathRendererRef this, CFXPathRef path, float tolerance)
+{
+    float epsilon = tolerance * 0.1f;
+    Vec2 current = { 0.0f, 0.0f }, start = { 0.0f, 0.0f };
+    bool open = false;
+
+    this->pointCount = 0;
+    this->contourCount = 0;
+    for (int i = 0; i < path->count; i++) {
+        CFXPathCommand* command = &path->commands[i];
+        if (command->verb == CFX_PATH_MOVE) {
+            start = current = command->p[0];
+            open = false;
+            continue;
+        }
+        if (command->verb == CFX_PATH_CLOSE) {
+            if (open)
+                this->contours[this->contourCount - 1].closed = true;
+            current = start;
+            open = false;
+            continue;
+        }
+        if (!open) {
+            BeginContour(this, current, epsilon);
+            open = true;
+        }
+
+        Vec2* p = command->p;
+        switch (command->verb) {
+        case CFX_PATH_LINE:
+            AddPoint(this, p[0], epsilon);
+            current = p[0];
+            break;
+        case CFX_PATH_QUAD: {
+            float dx = current.x - 2.0f * p[0].x + p[1].x;
+            float dy = current.y - 2.0f * p[0].y + p[1].y;
+            int n = ClampSegments(sqrtf(sqrtf(dx * dx + dy * dy) / (4.0f * tolerance)));
+            for (int k = 1; k <= n; k++) {
+                float t = (float)k / n, u = 1.0f - t;
+                AddPoint(this, (Vec2) { u * u * current.x + 2.0f * u * t * p[0].x + t * t * p[1].x, u * u * current.y + 2.0f * u * t * p[0].y + t * t * p[1].y }, epsilon);
+            }
+            current = p[1];
+            break;
+        }
+        case CFX_PATH_CUBIC: {
+            float ax = current.x - 2.0f * p[0].x + p[1].x, ay = current.y - 2.0f * p[0].y + p[1].y;
+            float bx = p[0].x - 2.0f * p[1].x + p[2].x, by = p[0].y - 2.0f * p[1].y + p[2].y;
+            float m = fmaxf(sqrtf(ax * ax + ay * ay), sqrtf(bx * bx + by * by));
+            int n = ClampSegments(sqrtf(0.75f * m / tolerance));
+            for (int k = 1; k <= n; k++) {
+                float t = (float)k / n, u = 1.0f - t;
+                float w0 = u * u * u, w1 = 3.0f * u * u * t, w2 = 3.0f * u * t * t, w3 = t * t * t;
+                AddPoint(this, (Vec2) { w0 * current.x + w1 * p[0].x + w2 * p[1].x + w3 * p[2].x, w0 * current.y + w1 * p[0].y + w2 * p[1].y + w3 * p[2].y }, epsilon);
+            }
+            current = p[2];
+            break;
+        }
+        case CFX_PATH_ARC: {
+            float radius = fabsf(p[1].x), sweep = p[2].y - p[2].x;
+            float step = radius > tolerance ? 2.0f * acosf(1.0f - tolerance / radius) : (float)M_PI;
+            int n = ClampSegments(fabsf(sweep) / step);
+            for (int k = 0; k <= n; k++) {
+                float angle = p[2].x + sweep * k / n;
+                current = (Vec2) { p[0].x + radius * cosf(angle), p[0].y + radius * sinf(angle) };
+                AddPoint(this, current, epsilon);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Evaluates the paint of the path at a point.
+ */
+static Vec4 Paint(CFXPathRef path, Vec2 p)
+{
+    if (!path->gradient)
+        return path->color;
+    float dx = path->gradientEnd.x - path->gradientStart.x;
+    float dy = path->gradientEnd.y - path->gradientStart.y;
+    float length2 = dx * dx + dy * dy;
+    float t = length2 > 0.0f ? ((p.x - path->gradientStart.x) * dx + (p.y - path->gradientStart.y) * dy) / length2 : 0.0f;
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+    Vec4 a = path->color, b = path->gradientColor;
+    return (Vec4) { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+}
+
+static void Emit(CFXPathMesh* mesh, CFXPathRef path, Vec2 p, float alpha)
+{
+    mesh->vertices = Grow(mesh->vertices, &mesh->capacity, mesh->count + 1, sizeof(CFXPathVertex));
+    Vec4 color = Paint(path, p);
+    color.w *= alpha;
+    mesh->vertices[mesh->count++] = (CFXPathVertex) { p, color };
+}
+
+/**
+ * @brief Emits the quad a-b-c-d, in order around its edge, as two triangles.
+ */
+static void EmitQuad(CFXPathMesh* mesh, CFXPathRef path, Vec2 a, float aa, Vec2 b, float ba, Vec2 c, float ca, Vec2 d, float da)
+{
+    Emit(mesh, path, a, aa);
+    Emit(mesh, path, b, ba);
+    Emit(mesh, path, c, ca);
+    Emit(mesh, path, a, aa);
+    Emit(mesh, path, c, ca);
+    Emit(mesh, path, d, da);
+}
+
+static float Cross(Vec2 a, Vec2 b, Vec2 c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/**
+ * @brief Whether v[u], v[v], v[w] is a convex corner with no other remaining point inside.
+ */
+static bool IsEar(const Vec2* points, const int* v, int count, int u, int m, int w, float sign)
+{
+    Vec2 a = points[v[u]], b = points[v[m]], c = points[v[w]];
+    if (Cross(a, b, c) * sign <= 1e-10f)
+        return false;
+    for (int k = 0; k < count; k++) {
+        if (k == u || k == m || k == w)
+            continue;
+        Vec2 p = points[v[k]];
+        if (Cross(a, b, p) * sign >= 0.0f && Cross(b, c, p) * sign >= 0.0f && Cross(c, a, p) * sign >= 0.0f)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Fills a simple polygon by ear clipping.
+ *
+ * Self-intersecting contours run out of ears; whatever was clipped by then
+ * is kept.
+ *
+ * @return The orientation of the polygon, 1 or -1.
+ */
+static float Triangulate(CFXPathRendererRef this, CFXPathRef path, CFXPathMesh* mesh, const Vec2* points, int n)
+{
+    float area = 0.0f;
+    for (int i = 0, j = n - 1; i < n; j = i++)
+        area += points[j].x * points[i].y - points[i].x * points[j].y;
+    float sign = area >= 0.0f ? 1.0f : -1.0f;
+
+    this->scratch = Grow(this->scratch, &this->scratchCapacity, n, sizeof(int));
+    int* v = this->scratch;
+    for (int i = 0; i < n; i++)
+        v[i] = i;
+
+    int count = n, attempts = 2 * count;
+    for (int m = count - 1; count > 2;) {
+        if (attempts-- <= 0)
+            break;
+        int u = m < count ? m : 0;
+        m = u + 1 < count ? u + 1 : 0;
+        int w = m + 1 < count ? m + 1 : 0;
+        if (!IsEar(points, v, count, u, m, w, sign))
+            continue;
+        Emit(mesh, path, points[v[u]], 1.0f);
+        Emit(mesh, path, points[v[m]], 1.0f);
+        Emit(mesh, path, points[v[w]], 1.0f);
+        for (int k = m; k + 1 < count; k++)
+            v[k] = v[k + 1];
+        count--;
+        attempts = 2 * count;
+    }
+    return sign;
+}
+
+static Vec2 Normal(Vec2 a, Vec2 b, float sign)
+{
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length < 1e-12f)
+        return (Vec2) { 0.0f, 0.0f };
+    return (Vec2) { sign * dy / length, -sign * dx / length };
+}
+
+/**
+ * @brief Offset that moves both adjoining edges outward by one unit, capped at four.
+ */
+static Vec2 Miter(Vec2 n0, Vec2 n1)
+{
+    Vec2 s = { n0.x + n1.x, n0.y + n1.y };
+    float length2 = s.x * s.x + s.y * s.y;
+    if (length2 < 1e-6f)
+        return n1;
+    float k = length2 < 0.25f ? 4.0f / sqrtf(length2) : 2.0f / length2;
+    return (Vec2) { s.x * k, s.y * k };
+}
+
+/**
+ * @brief Computes the outward miter of every point of a contour into miters.
+ *
+ * Open contours use the normal of their first and last segments at the ends.
+ */
+static void Miters(CFXPathRendererRef this, const Vec2* points, int n, bool closed, float sign)
+{
+    this->miters = Grow(this->miters, &this->miterCapacity, n, sizeof(Vec2));
+    for (int i = 0; i < n; i++) {
+        bool first = i == 0 && !closed, last = i == n - 1 && !closed;
+        Vec2 prev = points[i == 0 ? n - 1 : i - 1], next = points[i == n - 1 ? 0 : i + 1];
+        Vec2 n0 = first ? Normal(points[i], next, sign) : Normal(prev, points[i], sign);
+        Vec2 n1 = last ? n0 : Normal(points[i], next, sign);
+        this->miters[i] = Miter(n0, n1);
+    }
+}
+
+static Vec2 Offset(Vec2 p, Vec2 m, float distance)
+{
+    return (Vec2) { p.x + m.x * distance, p.y + m.y * distance };
+}
+
+/**
+ * @brief Surrounds a filled contour with a fringe fading from opaque to clear.
+ */
+static void Fringe(CFXPathRendererRef this, CFXPathRef path, CFXPathMesh* mesh, const Vec2* points, int n, float sign, float width)
+{
+    Miters(this, points, n, true, sign);
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        Vec2 a = points[j], b = points[i];
+        EmitQuad(mesh, path, a, 1.0f, b, 1.0f, Offset(b, this->miters[i], width), 0.0f, Offset(a, this->miters[j], width), 0.0f);
+    }
+}
+
+/**
+ * @brief Extrudes a contour into an outline with butt ends and fringes on every side.
+ *
+ * Strokes thinner than a pixel are drawn a pixel wide with their coverage
+ * moved into alpha, which keeps hairlines from breaking up.
+ */
+static void Stroke(CFXPathRendererRef this, CFXPathRef path, CFXPathMesh* mesh, const Vec2* points, int n, bool closed, float scale)
+{
+    if (n < 2)
+        return;
+    float half = path->strokeWidth * 0.5f, width = 1.0f / scale, alpha = 1.0f;
+    if (half * scale < 0.5f) {
+        alpha = path->strokeWidth * scale;
+        half = 0.5f / scale;
+    }
+
+    Miters(this, points, n, closed, 1.0f);
+    Vec2* m = this->miters;
+    int segments = closed ? n : n - 1;
+    for (int s = 0; s < segments; s++) {
+        int i = s, j = s + 1 < n ? s + 1 : 0;
+        Vec2 li = Offset(points[i], m[i], half), lj = Offset(points[j], m[j], half);
+        Vec2 ri = Offset(points[i], m[i], -half), rj = Offset(points[j], m[j], -half);
+        EmitQuad(mesh, path, ri, alpha, li, alpha, lj, alpha, rj, alpha);
+        EmitQuad(mesh, path, li, alpha, Offset(points[i], m[i], half + width), 0.0f, Offset(points[j], m[j], half + width), 0.0f, lj, alpha);
+        EmitQuad(mesh, path, rj, alpha, Offset(points[j], m[j], -half - width), 0.0f, Offset(points[i], m[i], -half - width), 0.0f, ri, alpha);
+    }
+    if (closed)
+        return;
+
+    for (int end = 0; end < 2; end++) {
+        int i = end ? n - 1 : 0, j = end ? n - 2 : 1;
+        Vec2 t = Normal(points[j], points[i], 1.0f);
+        t = (Vec2) { -t.y * width, t.x * width };
+        Vec2 l = Offset(points[i], m[i], half), r = Offset(points[i], m[i], -half);
+        EmitQuad(mesh, path, l, alpha, r, alpha, (Vec2) { r.x + t.x, r.y + t.y }, 0.0f, (Vec2) { l.x + t.x, l.y + t.y }, 0.0f);
+    }
+}
+
+/**
+ * @brief Rebuilds a mesh from the path for drawing at the given scale.
+ */
+static void Tessellate(CFXPathRendererRef this, CFXPathRef path, CFXPathMesh* mesh, float scale)
+{
+    float tolerance = Tolerance / scale;
+    Flatten(this, path, tolerance);
+    mesh->count = 0;
+    for (int c = 0; c < this->contourCount; c++) {
+        CFXPathContour* contour = &this->contours[c];
+        const Vec2* points = &this->points[contour->first];
+        int n = contour->count;
+        bool closed = contour->closed || path->strokeWidth <= 0.0f;
+        if (closed && n > 1 && Near(points[0], points[n - 1], tolerance * 0.1f))
+            n--;
+        if (path->strokeWidth > 0.0f) {
+            Stroke(this, path, mesh, points, n, closed, scale);
+        } else if (n >= 3) {
+            float sign = Triangulate(this, path, mesh, points, n);
+            Fringe(this, path, mesh, points, n, sign, 1.0f / scale);
+        }
+    }
+    this->tessellations++;
+}
+
+/**
+ * @brief Finds the cache entry of a path at a scale bucket, creating one if needed.
+ *
+ * The path's cacheSlot is tried first. A new bucket for a path that was not
+ * drawn this frame takes over its old entry, so zooming does not pile up
+ * meshes. New entries carry a version that never matches, forcing a build.
+ */
+static CFXPathMesh* Lookup(CFXPathRendererRef this, CFXPathRef path, int bucket)
+{
+    int slot = path->cacheSlot;
+    if (slot >= 0 && slot < this->cacheCount && this->cache[slot].pathId == path->id && this->cache[slot].bucket == bucket)
+        return &this->cache[slot];
+
+    int reuse = -1;
+    for (int i = 0; i < this->cacheCount; i++) {
+        CFXPathMesh* mesh = &this->cache[i];
+        if (mesh->pathId != path->id)
+            continue;
+        if (mesh->bucket == bucket) {
+            path->cacheSlot = i;
+            return mesh;
+        }
+        if (mesh->lastFrame != this->frame)
+            reuse = i;
+    }
+    if (reuse < 0) {
+        this->cache = Grow(this->cache, &this->cacheCapacity, this->cacheCount + 1, sizeof(CFXPathMesh));
+        reuse = this->cacheCount++;
+        this->cache[reuse] = (CFXPathMesh) { 0 };
+    }
+    CFXPathMesh* mesh = &this->cache[reuse];
+    mesh->pathId = path->id;
+    mesh->bucket = bucket;
+    mesh->version = path->version - 1;
+    path->cacheSlot = reuse;
+    return mesh;
+}
+
+/**
+ * @brief Starts a batch of paths.
+ *
+ * @param this  Reference to the path renderer.
+ * @param view  Region of the current render target to draw in, in pixels.
+ */
+proc void Begin(CFXPathRendererRef this, CFXRect view)
+{
+    this->view = view;
+    this->frame++;
+    this->batchCount = 0;
+    this->tessellations = 0;
+}
+
+/**
+ * @brief Adds a path to the batch.
+ *
+ * @param this      Reference to the path renderer.
+ * @param path      Path to draw.
+ * @param position  Pixel position of the path's origin.
+ * @param scale     Pixels per path unit.
+ */
+proc void Draw(CFXPathRendererRef this, CFXPathRef path, Vec2 position, GLfloat scale)
+{
+    if (path->count == 0 || scale <= 0.0f)
+        return;
+    int bucket = (int)floorf(log2f(scale) * 2.0f + 0.5f);
+    CFXPathMesh* mesh = Lookup(this, path, bucket);
+    if (mesh->version != path->version) {
+        Tessellate(this, path, mesh, exp2f(bucket * 0.5f));
+        mesh->version = path->version;
+    }
+    mesh->lastFrame = this->frame;
+
+    this->batch = Grow(this->batch, &this->batchCapacity, this->batchCount + mesh->count, sizeof(CFXPathVertex));
+    CFXPathVertex* out = &this->batch[this->batchCount];
+    for (int i = 0; i < mesh->count; i++) {
+        CFXPathVertex* v = &mesh->vertices[i];
+        out[i] = (CFXPathVertex) { { position.x + v->position.x * scale, position.y + v->position.y * scale }, v->color };
+    }
+    this->batchCount += mesh->count;
+}
+
+/**
+ * @brief Draws the batch with one call and evicts meshes that went unused.
+ *
+ * @param this Reference to the path renderer.
+ */
+proc void End(CFXPathRendererRef this)
+{
+    if (this->batchCount > 0) {
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        // Tessellated triangles come in either winding, so none may be culled
+        GLboolean cull = glIsEnabled(GL_CULL_FACE);
+        glDisable(GL_CULL_FACE);
+
+        Use(this->shader);
+        SetVector4(this->shader, "view", this->view.x, this->view.y, this->view.w, this->view.h);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBufferData(GL_ARRAY_BUFFER, this->batchCount * sizeof(CFXPathVertex), this->batch, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(this->VAO);
+        glDrawArrays(GL_TRIANGLES, 0, this->batchCount);
+        glBindVertexArray(0);
+
+        if (!blend)
+            glDisable(GL_BLEND);
+        if (cull)
+            glEnable(GL_CULL_FACE);
+    }
+
+    for (int i = 0; i < this->cacheCount;) {
+        if (this->frame - this->cache[i].lastFrame > EvictAfterFrames) {
+            free(this->cache[i].vertices);
+            this->cache[i] = this->cache[--this->cacheCount];
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "path.h"
+#include "rect.h"
+#include "shader.h"
+#include "tglm.h"
+
+extern CFClassRef CFXPathRenderer;
+typedef struct __CFXPathRenderer* CFXPathRendererRef;
+
+/**
+ * @struct CFXPathVertex
+ * @brief A tessellated path vertex with its paint color and coverage folded into alpha.
+ */
+typedef struct CFXPathVertex {
+    Vec2 position;
+    Vec4 color;
+} CFXPathVertex;
+
+/**
+ * @struct CFXPathMesh
+ * @brief A cached tessellation of one path at one scale bucket.
+ *
+ * Members:
+ * - pathId:     CFXPath::id of the path.
+ * - version:    CFXPath::version the mesh was built from.
+ * - bucket:     Scale bucket the mesh was built for.
+ * - vertices:   Triangles in path units.
+ * - count:      Number of vertices.
+ * - capacity:   Allocated size of vertices.
+ * - lastFrame:  Frame the mesh was last drawn in.
+ */
+typedef struct CFXPathMesh {
+    unsigned pathId;
+    unsigned version;
+    int bucket;
+    CFXPathVertex* vertices;
+    int count;
+    int capacity;
+    int lastFrame;
+} CFXPathMesh;
+
+/**
+ * @struct CFXPathContour
+ * @brief A flattened subpath in the renderer's point scratch buffer.
+ */
+typedef struct CFXPathContour {
+    int first;
+    int count;
+    bool closed;
+} CFXPathContour;
+
+/**
+ * @struct __CFXPathRenderer
+ * @brief Draws CFXPaths from a cache of tessellated meshes in one batch.
+ *
+ * Draw looks up the mesh for the path and a scale bucket of half an octave,
+ * and only tessellates when there is none or the path's version changed.
+ * Curves are flattened to a quarter pixel at the bucket's scale; fills are
+ * ear clipped per subpath and strokes extruded along miters. Anti-aliasing
+ * comes from a one pixel fringe of triangles around every edge whose alpha
+ * falls to zero, so no multisampling is needed. Paint is evaluated per
+ * vertex, which makes flat colors and linear gradients the same shader.
+ *
+ * Meshes are appended, scaled and offset, to a vertex array that End
+ * uploads and draws with a single call. Meshes not drawn for a couple of
+ * seconds are evicted.
+ *
+ * Members:
+ * - obj:            Base object information for the path renderer.
+ * - shader:         Built-in shader.
+ * - VAO:            OpenGL Vertex Array Object identifier.
+ * - VBO:            OpenGL Vertex Buffer Object identifier.
+ * - view:           Region of the target the batch is drawn in, in pixels.
+ * - frame:          Number of Begin calls, used for eviction.
+ * - cache:          Cached meshes.
+ * - cacheCount:     Number of cached meshes.
+ * - cacheCapacity:  Allocated size of cache.
+ * - batch:          Vertices of the current batch, in pixels.
+ * - batchCount:     Number of batch vertices.
+ * - batchCapacity:  Allocated size of batch.
+ * - points:         Scratch: flattened points of the path being tessellated.
+ * - pointCount:     Number of points.
+ * - pointCapacity:  Allocated size of points.
+ * - contours:       Scratch: subpaths of points.
+ * - contourCount:   Number of contours.
+ * - contourCapacity: Allocated size of contours.
+ * - scratch:        Scratch: ear clipping index list.
+ * - scratchCapacity: Allocated size of scratch.
+ * - miters:         Scratch: miter offsets of the contour being extruded.
+ * - miterCapacity:  Allocated size of miters.
+ * - tessellations:  Meshes built since Begin.
+ */
+typedef struct __CFXPathRenderer {
+    __CFObject obj;
+    CFXShaderRef shader;
+    GLuint VAO;
+    GLuint VBO;
+    CFXRect view;
+    int frame;
+    CFXPathMesh* cache;
+    int cacheCount;
+    int cacheCapacity;
+    CFXPathVertex* batch;
+    int batchCount;
+    int batchCapacity;
+    Vec2* points;
+    int pointCount;
+    int pointCapacity;
+    CFXPathContour* contours;
+    int contourCount;
+    int contourCapacity;
+    int* scratch;
+    int scratchCapacity;
+    Vec2* miters;
+    int miterCapacity;
+    int tessellations;
+} __CFXPathRenderer;
+
+extern proc void* Ctor(
+    CFXPathRendererRef this);
+
+extern proc void Begin(
+    CFXPathRendererRef this,
+    CFXRect view);
+
+extern proc void Draw(
+    CFXPathRendererRef this,
+    CFXPathRef path,
+    Vec2 position,
+    GLfloat scale);
+
+extern proc void End(
+    CFXPathRendererRef this);
+
+/**
+ * @brief Creates a new CFXPathRenderer.
+ *
+ * @return A reference to the newly created CFXPathRenderer.
+ */
+static inline CFXPathRendererRef NewCFXPathRenderer()
+{
+    return Ctor((CFXPathRendererRef)CFCreate(CFXPathRenderer));
+}
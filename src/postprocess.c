@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "postprocess.h"
+
+class2(CFXPostProcess);
+
+/**
+ * Averages a 4x4 texel block with four bilinear taps, one per 2x2 quad.
+ */
+static const GLchar* DownsampleFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 texelSize;\n"
+    "void main() {\n"
+    "    vec2 d = texelSize;\n"
+    "    color = 0.25 * (texture(source, uv + vec2(-d.x, -d.y))\n"
+    "                  + texture(source, uv + vec2( d.x, -d.y))\n"
+    "                  + texture(source, uv + vec2(-d.x,  d.y))\n"
+    "                  + texture(source, uv + vec2( d.x,  d.y)));\n"
+    "}\n";
+
+static const GLchar* CopyFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D source;\n"
+    "void main() { color = texture(source, uv); }\n";
+
+/**
+ * 9-tap Gaussian folded into 5 bilinear fetches along direction.
+ */
+static const GLchar* BlurFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 direction;\n"
+    "void main() {\n"
+    "    vec2 o1 = direction * 1.3846153846;\n"
+    "    vec2 o2 = direction * 3.2307692308;\n"
+    "    color = texture(source, uv) * 0.2270270270\n"
+    "          + (texture(source, uv + o1) + texture(source, uv - o1)) * 0.3162162162\n"
+    "          + (texture(source, uv + o2) + texture(source, uv - o2)) * 0.0702702703;\n"
+    "}\n";
+
+static const GLchar* CompositeFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D scene;\n"
+    "uniform sampler2D effect;\n"
+    "uniform float intensity;\n"
+    "void main() {\n"
+    "    vec4 base = texture(scene, uv);\n"
+    "    color = vec4(base.rgb + texture(effect, uv).rgb * intensity, base.a);\n"
+    "}\n";
+
+static CFXShaderRef BuiltIn(const GLchar* fragmentSource)
+{
+    CFXShaderRef shader = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(shader, CFX_FULLSCREEN_VERTEX_SOURCE, fragmentSource);
+    return shader;
+}
+
+/**
+ * @brief Releases every render target; they are recreated on demand.
+ */
+static void ReleaseTargets(CFXPostProcessRef this)
+{
+    for (int level = 0; level < CFX_POSTPROCESS_LEVELS; level++) {
+        if (this->mips[level] != nullptr)
+            CFUnref(this->mips[level]);
+        this->mips[level] = nullptr;
+        for (int i = 0; i < 2; i++) {
+            if (this->ping[level][i] != nullptr)
+                CFUnref(this->ping[level][i]);
+            this->ping[level][i] = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Size of a level, never smaller than one pixel.
+ */
+static int LevelSize(int size, int level)
+{
+    return Max(size >> level, 1);
+}
+
+/**
+ * @brief Creates the downsample and pass targets of a level on first use.
+ */
+static void EnsureLevel(CFXPostProcessRef this, int level)
+{
+    int width = LevelSize(this->scene->width, level);
+    int height = LevelSize(this->scene->height, level);
+    if (level > 0 && this->mips[level] == nullptr)
+        this->mips[level] = NewCFXRenderTarget(width, height, GL_RGBA8);
+    for (int i = 0; i < 2; i++)
+        if (this->ping[level][i] == nullptr)
+            this->ping[level][i] = NewCFXRenderTarget(width, height, GL_RGBA8);
+}
+
+/**
+ * @brief Resolves a shader name, falling back to the built-in blur and composite.
+ */
+static CFXShaderRef FindShader(CFXPostProcessRef this, const char* name)
+{
+    CFXShaderRef shader = GetShader(this->resources, name);
+    if (shader != nullptr)
+        return shader;
+    if (strcmp(name, "blur") == 0)
+        return this->blur;
+    if (strcmp(name, "composite") == 0)
+        return this->defaultComposite;
+    return nullptr;
+}
+
+/**
+ * @brief Constructor for the CFXPostProcess object.
+ *
+ * Creates the scene target and compiles the built-in shaders. Reduced
+ * resolution targets are only created once a pass needs them.
+ *
+ * @param this       Pointer to the CFXPostProcess instance to initialize.
+ * @param resources  Resource manager the pass shaders are looked up in.
+ * @param width      Scene width in pixels.
+ * @param height     Scene height in pixels.
+ * @return           Pointer to the initialized CFXPostProcess instance.
+ */
+proc void* Ctor(CFXPostProcessRef this, CFXResourceManagerRef resources, int width, int height)
+{
+    CFXPostProcess->dtor = dtor;
+    this->resources = resources;
+    this->scene = NewCFXRenderTarget(width, height, GL_RGBA8);
+    memset(this->mips, 0, sizeof(this->mips));
+    memset(this->ping, 0, sizeof(this->ping));
+    this->passes = nullptr;
+    this->passCount = 0;
+    this->passCapacity = 0;
+    this->downsample = BuiltIn(DownsampleFragmentSource);
+    this->copy = BuiltIn(CopyFragmentSource);
+    this->blur = BuiltIn(BlurFragmentSource);
+    this->defaultComposite = BuiltIn(CompositeFragmentSource);
+    this->composite = this->defaultComposite;
+    this->intensity = 1.0f;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXPostProcess object.
+ *
+ * Releases the render targets, the built-in shaders and the pass list.
+ * Shaders owned by the resource manager are left alone.
+ *
+ * @param self Pointer to the CFXPostProcess instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXPostProcessRef this = self;
+    ReleaseTargets(this);
+    CFUnref(this->scene);
+    CFUnref(this->downsample);
+    CFUnref(this->copy);
+    CFUnref(this->blur);
+    CFUnref(this->defaultComposite);
+    for (int i = 0; i < this->passCount; i++)
+        free(this->passes[i].name);
+    free(this->passes);
+}
+
+/**
+ * @brief Changes the scene size, typically from the framebuffer size callback.
+ *
+ * @param this    Reference to the post-process chain.
+ * @param width   New scene width in pixels.
+ * @param height  New scene height in pixels.
+ */
+proc void Resize(CFXPostProcessRef this, int width, int height)
+{
+    if (width == this->scene->width && height == this->scene->height)
+        return;
+    ReleaseTargets(this);
+    CFUnref(this->scene);
+    this->scene = NewCFXRenderTarget(width, height, GL_RGBA8);
+}
+
+/**
+ * @brief Appends a pass to the end of the chain.
+ *
+ * @param this       Reference to the post-process chain.
+ * @param name       Name of a shader in the resource manager, or "blur".
+ * @param level      Resolution level: 1 for half, 2 for quarter, 3 for eighth size.
+ * @param separable  Run the shader horizontally then vertically.
+ * @return           false if no shader with that name exists.
+ */
+proc bool AddPass(CFXPostProcessRef this, const char* name, int level, bool separable)
+{
+    CFXShaderRef shader = FindShader(this, name);
+    if (shader == nullptr) {
+        printf("| ERROR::POSTPROCESS: Unknown shader %s\n", name);
+        return false;
+    }
+    if (this->passCount == this->passCapacity) {
+        this->passCapacity = this->passCapacity ? this->passCapacity * 2 : 8;
+        this->passes = realloc(this->passes, this->passCapacity * sizeof(CFXPostPass));
+    }
+    level = level < 0 ? 0 : level >= CFX_POSTPROCESS_LEVELS ? CFX_POSTPROCESS_LEVELS - 1 : level;
+    this->passes[this->passCount++] = (CFXPostPass) {
+        .name = CFStrDup((char*)name), .shader = shader,
+        .level = level, .separable = separable, .enabled = true };
+    return true;
+}
+
+/**
+ * @brief Enables or disables every pass using the named shader.
+ *
+ * Meant for device tiers: the chain is built once and trimmed on slow devices.
+ *
+ * @param this     Reference to the post-process chain.
+ * @param name     Shader name the passes were added with.
+ * @param enabled  Whether the passes run.
+ */
+proc void SetEnabled(CFXPostProcessRef this, const char* name, bool enabled)
+{
+    for (int i = 0; i < this->passCount; i++)
+        if (strcmp(this->passes[i].name, name) == 0)
+            this->passes[i].enabled = enabled;
+}
+
+/**
+ * @brief Replaces the shader combining the chain's output with the scene.
+ *
+ * @param this  Reference to the post-process chain.
+ * @param name  Name of a shader in the resource manager, or "composite".
+ * @return      false if no shader with that name exists.
+ */
+proc bool SetComposite(CFXPostProcessRef this, const char* name)
+{
+    CFXShaderRef shader = FindShader(this, name);
+    if (shader == nullptr) {
+        printf("| ERROR::POSTPROCESS: Unknown shader %s\n", name);
+        return false;
+    }
+    this->composite = shader;
+    return true;
+}
+
+/**
+ * @brief Redirects rendering of the scene into the offscreen target.
+ *
+ * @param this Reference to the post-process chain.
+ */
+proc void Begin(CFXPostProcessRef this)
+{
+    Begin(this->scene);
+}
+
+/**
+ * @brief Runs a shader over a full target, reading source on unit 0.
+ */
+static void Apply(
+    CFXPostProcessRef this,
+    CFXShaderRef shader,
+    CFXTexture2DRef source,
+    CFXRenderTargetRef target,
+    GLfloat dx,
+    GLfloat dy)
+{
+    Begin(target);
+    Use(shader);
+    SetInteger(shader, "source", 0);
+    SetInteger(shader, "scene", 1);
+    SetVector2(shader, "texelSize", 1.0f / source->Width, 1.0f / source->Height);
+    SetVector2(shader, "direction", dx, dy);
+    glActiveTexture(GL_TEXTURE1);
+    Bind(this->scene->texture);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(source);
+    CFXRenderTarget_DrawFullscreen();
+    End(target);
+}
+
+/**
+ * @brief Filters the scene and composites it into the previous framebuffer.
+ *
+ * Only the levels down to the deepest enabled pass are downsampled, so a
+ * chain trimmed to half resolution passes never touches the smaller targets.
+ *
+ * @param this Reference to the post-process chain.
+ */
+proc void End(CFXPostProcessRef this)
+{
+    End(this->scene);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+
+    int deepest = -1;
+    for (int i = 0; i < this->passCount; i++)
+        if (this->passes[i].enabled)
+            deepest = Max(deepest, this->passes[i].level);
+
+    CFXTexture2DRef source = this->scene->texture;
+    for (int level = 1; level <= deepest; level++) {
+        EnsureLevel(this, level);
+        Apply(this, this->downsample, source, this->mips[level], 0.0f, 0.0f);
+        source = this->mips[level]->texture;
+    }
+
+    CFXTexture2DRef effect = nullptr;
+    for (int i = 0; i < this->passCount; i++) {
+        CFXPostPass* pass = &this->passes[i];
+        if (!pass->enabled)
+            continue;
+        EnsureLevel(this, pass->level);
+        CFXRenderTargetRef* ping = this->ping[pass->level];
+        CFXTexture2DRef input = effect != nullptr ? effect
+            : pass->level == 0 ? this->scene->texture
+            : this->mips[pass->level]->texture;
+        int first = input == ping[0]->texture ? 1 : 0;
+        if (pass->separable) {
+            Apply(this, pass->shader, input, ping[first], 1.0f / input->Width, 0.0f);
+            input = ping[first]->texture;
+            Apply(this, pass->shader, input, ping[1 - first], 0.0f, 1.0f / input->Height);
+            effect = ping[1 - first]->texture;
+        } else {
+            Apply(this, pass->shader, input, ping[first], 0.0f, 0.0f);
+            effect = ping[first]->texture;
+        }
+    }
+
+    if (effect == nullptr) {
+        Use(this->copy);
+        SetInteger(this->copy, "source", 0);
+        glActiveTexture(GL_TEXTURE0);
+        Bind(this->scene->texture);
+    } else {
+        Use(this->composite);
+        SetInteger(this->composite, "scene", 0);
+        SetInteger(this->composite, "effect", 1);
+        SetFloat(this->composite, "intensity", this->intensity, false);
+        glActiveTexture(GL_TEXTURE1);
+        Bind(effect);
+        glActiveTexture(GL_TEXTURE0);
+        Bind(this->scene->texture);
+    }
+    CFXRenderTarget_DrawFullscreen();
+
+    if (blend)
+        glEnable(GL_BLEND);
+}
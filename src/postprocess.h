@@ -0,0 +1,137 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rendertarget.h"
+#include "resourcemanager.h"
+
+extern CFClassRef CFXPostProcess;
+typedef struct __CFXPostProcess* CFXPostProcessRef;
+
+/**
+ * Number of resolution levels: full, 1/2, 1/4 and 1/8 of the scene size.
+ */
+#define CFX_POSTPROCESS_LEVELS 4
+
+/**
+ * @struct CFXPostPass
+ * @brief One effect in the post-processing chain.
+ *
+ * Members:
+ * - name:       Shader name, looked up in the resource manager.
+ * - shader:     The resolved shader.
+ * - level:      Resolution level the pass runs at, 0 (full) to CFX_POSTPROCESS_LEVELS - 1.
+ * - separable:  Run twice, horizontally then vertically, through the "direction" uniform.
+ * - enabled:    Disabled passes are skipped, as are the downsamples only they needed.
+ */
+typedef struct CFXPostPass {
+    char* name;
+    CFXShaderRef shader;
+    int level;
+    bool separable;
+    bool enabled;
+} CFXPostPass;
+
+/**
+ * @struct __CFXPostProcess
+ * @brief Renders the scene offscreen and filters it at reduced resolution.
+ *
+ * The scene is drawn between Begin and End into a full size target. End
+ * downsamples it through a chain of half size targets as deep as the enabled
+ * passes require, runs the passes in order and composites the result back
+ * over the scene into whatever was bound before Begin.
+ *
+ * The first enabled pass reads the downsampled scene at its level; each later
+ * pass reads the previous pass's output, rescaled by bilinear sampling when
+ * levels differ. Pass shaders come from the resource manager and must use a
+ * vertex shader like CFX_FULLSCREEN_VERTEX_SOURCE. They receive:
+ * - source:     Input texture, unit 0.
+ * - scene:      Full resolution scene, unit 1.
+ * - texelSize:  1 / size of the input texture.
+ * - direction:  Texel step along the current axis for separable passes, else zero.
+ *
+ * The names "blur" and "composite" fall back to built-in shaders when the
+ * resource manager has none: a 9-tap separable Gaussian and an additive
+ * composite of the chain's output scaled by intensity. A composite shader
+ * receives the scene on unit 0 as "scene", the chain's output on unit 1 as
+ * "effect", and "intensity".
+ *
+ * Members:
+ * - obj:           Base object information for the post-process chain.
+ * - resources:     Resource manager the pass shaders are looked up in.
+ * - scene:         Full resolution target the scene is drawn into.
+ * - mips:          Downsampled copies of the scene; mips[0] is unused.
+ * - ping:          Two targets per level that passes render into alternately.
+ * - passes:        The chain, in execution order.
+ * - passCount:     Number of passes.
+ * - passCapacity:  Allocated size of passes.
+ * - downsample:    Built-in 4-tap box downsample shader.
+ * - copy:          Built-in copy shader, used when every pass is disabled.
+ * - blur:          Built-in separable Gaussian blur.
+ * - composite:     Composite shader in use.
+ * - defaultComposite: Built-in additive composite.
+ * - intensity:     Weight of the chain's output in the composite.
+ */
+typedef struct __CFXPostProcess {
+    __CFObject obj;
+    CFXResourceManagerRef resources;
+    CFXRenderTargetRef scene;
+    CFXRenderTargetRef mips[CFX_POSTPROCESS_LEVELS];
+    CFXRenderTargetRef ping[CFX_POSTPROCESS_LEVELS][2];
+    CFXPostPass* passes;
+    int passCount;
+    int passCapacity;
+    CFXShaderRef downsample;
+    CFXShaderRef copy;
+    CFXShaderRef blur;
+    CFXShaderRef composite;
+    CFXShaderRef defaultComposite;
+    GLfloat intensity;
+} __CFXPostProcess;
+
+extern proc void* Ctor(
+    CFXPostProcessRef this,
+    CFXResourceManagerRef resources,
+    int width,
+    int height);
+
+extern proc void Resize(
+    CFXPostProcessRef this,
+    int width,
+    int height);
+
+extern proc bool AddPass(
+    CFXPostProcessRef this,
+    const char* name,
+    int level,
+    bool separable);
+
+extern proc void SetEnabled(
+    CFXPostProcessRef this,
+    const char* name,
+    bool enabled);
+
+extern proc bool SetComposite(
+    CFXPostProcessRef this,
+    const char* name);
+
+extern proc void Begin(
+    CFXPostProcessRef this);
+
+extern proc void End(
+    CFXPostProcessRef this);
+
+/**
+ * @brief Creates a new CFXPostProcess with an empty chain.
+ *
+ * @param resources  Resource manager the pass shaders are looked up in.
+ * @param width      Scene width in pixels, normally the framebuffer width.
+ * @param height     Scene height in pixels.
+ * @return A reference to the newly created CFXPostProcess.
+ */
+static inline CFXPostProcessRef NewCFXPostProcess(CFXResourceManagerRef resources, int width, int height)
+{
+    return Ctor((CFXPostProcessRef)CFCreate(CFXPostProcess), resources, width, height);
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "rendertarget.h"
+
+class2(CFXRenderTarget);
+
+/**
+ * @brief Constructor for the CFXRenderTarget object.
+ *
+ * Allocates an uninitialized, linearly filtered and edge clamped color
+ * texture and attaches it to a new framebuffer.
+ *
+ * @param this            Pointer to the CFXRenderTarget instance to initialize.
+ * @param width           Width in pixels.
+ * @param height          Height in pixels.
+ * @param internalFormat  Sized internal format: GL_RGBA8, GL_RGBA16F or GL_R8.
+ * @return                Pointer to the initialized CFXRenderTarget instance.
+ */
+proc void* Ctor(CFXRenderTargetRef this, int width, int height, GLuint internalFormat)
+{
+    CFXRenderTarget->dtor = dtor;
+    this->width = width;
+    this->height = height;
+    this->previous = 0;
+
+    GLuint format = internalFormat == GL_R8 ? GL_RED : GL_RGBA;
+    GLuint type = internalFormat == GL_RGBA16F ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+    this->texture = NewCFXTexture2D(internalFormat, format, "rendertarget");
+    this->texture->Width = width;
+    this->texture->Height = height;
+    this->texture->wrapS = GL_CLAMP_TO_EDGE;
+    this->texture->wrapT = GL_CLAMP_TO_EDGE;
+
+    glBindTexture(GL_TEXTURE_2D, this->texture->Id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->texture->wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->texture->wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->texture->filterMin);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->texture->filterMag);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &this->FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture->Id, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        printf("| ERROR::RENDERTARGET: Framebuffer is not complete: %dx%d format 0x%x\n", width, height, internalFormat);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXRenderTarget object.
+ *
+ * Deletes the framebuffer and releases the color texture it owns.
+ *
+ * @param self Pointer to the CFXRenderTarget instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXRenderTargetRef this = self;
+    CFXDeletionQueue_Framebuffers(1, &this->FBO);
+    CFUnref(this->texture);
+}
+
+/**
+ * @brief Redirects rendering into the target.
+ *
+ * @param this Reference to the render target.
+ */
+proc void Begin(CFXRenderTargetRef this)
+{
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &this->previous);
+    glGetIntegerv(GL_VIEWPORT, this->viewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glViewport(0, 0, this->width, this->height);
+}
+
+/**
+ * @brief Restores the framebuffer and viewport that were current before Begin.
+ *
+ * @param this Reference to the render target.
+ */
+proc void End(CFXRenderTargetRef this)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->previous);
+    glViewport(this->viewport[0], this->viewport[1], this->viewport[2], this->viewport[3]);
+}
+
+/**
+ * @brief Draws a triangle covering the whole viewport.
+ *
+ * A single triangle avoids the diagonal seam of a two triangle quad, where
+ * fragments along the shared edge are shaded twice. GLES 3 still needs a
+ * vertex array bound, so an empty one is created on first use.
+ */
+void CFXRenderTarget_DrawFullscreen(void)
+{
+    static GLuint VAO = 0;
+    if (VAO == 0)
+        glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "shader.h"
+#include "texture2d.h"
+
+extern CFClassRef CFXRenderTarget;
+typedef struct __CFXRenderTarget* CFXRenderTargetRef;
+
+/**
+ * @brief Vertex shader for CFXRenderTarget_DrawFullscreen.
+ *
+ * Builds one oversized triangle covering the viewport from gl_VertexID alone
+ * and passes the matching texture coordinate to the fragment shader as uv.
+ */
+#define CFX_FULLSCREEN_VERTEX_SOURCE CFX_GLSL_VERSION \
+    "out vec2 uv;\n" \
+    "void main() {\n" \
+    "    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n" \
+    "    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);\n" \
+    "}\n"
+
+/**
+ * @struct __CFXRenderTarget
+ * @brief An offscreen framebuffer with a single color texture.
+ *
+ * Begin saves the current framebuffer binding and viewport and End restores
+ * them, so targets nest and always return to whatever the caller was drawing
+ * into, whether that is the window or another target.
+ *
+ * Members:
+ * - obj:            Base object information for the render target.
+ * - FBO:            OpenGL Framebuffer Object identifier.
+ * - texture:        Color attachment, bindable like any other texture.
+ * - width, height:  Size of the color attachment in pixels.
+ * - previous:       Framebuffer bound before Begin.
+ * - viewport:       Viewport in effect before Begin.
+ */
+typedef struct __CFXRenderTarget {
+    __CFObject obj;
+    GLuint FBO;
+    CFXTexture2DRef texture;
+    int width;
+    int height;
+    GLint previous;
+    GLint viewport[4];
+} __CFXRenderTarget;
+
+extern proc void* Ctor(
+    CFXRenderTargetRef this,
+    int width,
+    int height,
+    GLuint internalFormat);
+
+extern proc void Begin(
+    CFXRenderTargetRef this);
+
+extern proc void End(
+    CFXRenderTargetRef this);
+
+/**
+ * @brief Draws a triangle covering the whole viewport.
+ *
+ * The current program must use CFX_FULLSCREEN_VERTEX_SOURCE or an equivalent
+ * vertex shader that needs no attributes.
+ */
+extern void CFXRenderTarget_DrawFullscreen(void);
+
+/**
+ * @brief Creates a new CFXRenderTarget of the given size and color format.
+ *
+ * @param width           Width in pixels.
+ * @param height          Height in pixels.
+ * @param internalFormat  Sized internal format of the color texture, e.g. GL_RGBA8.
+ * @return A reference to the newly created CFXRenderTarget.
+ */
+static inline CFXRenderTargetRef NewCFXRenderTarget(int width, int height, GLuint internalFormat)
+{
+    return Ctor((CFXRenderTargetRef)CFCreate(CFXRenderTarget), width, height, internalFormat);
+}
@@ -0,0 +1,259 @@
+#include <string.h>
+#include <time.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "resolutionscaler.h"
+
+class2(CFXResolutionScaler);
+
+/**
+ * Game time is counted in 100ns ticks, as in game.c.
+ */
+constexpr double SecondsPerTick = 1.0 / 10000000.0;
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Reports whether GL_TIME_ELAPSED queries are available.
+ */
+static bool TimerQueries(void)
+{
+    static int supported = -1;
+    if (supported < 0) {
+        supported = 0;
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (strcmp(name, "GL_ARB_timer_query") == 0
+                || strcmp(name, "GL_EXT_disjoint_timer_query_webgl2") == 0
+                || strcmp(name, "GL_EXT_disjoint_timer_query") == 0)
+                supported = 1;
+        }
+    }
+    return supported;
+}
+
+/**
+ * Sharp bilinear: samples at the nearest texel center except within a band
+ * one output pixel wide at texel edges, where it blends with bilinear
+ * filtering. Scaled pixels stay square without the shimmer of nearest
+ * filtering at non-integer ratios.
+ */
+static const GLchar* UpscaleFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 sourceSize;\n"
+    "uniform vec2 textureSize;\n"
+    "uniform vec2 outputSize;\n"
+    "void main() {\n"
+    "    vec2 texel = uv * sourceSize;\n"
+    "    vec2 scale = max(outputSize / sourceSize, vec2(1.0));\n"
+    "    vec2 center = fract(texel) - 0.5;\n"
+    "    vec2 range = 0.5 - 0.5 / scale;\n"
+    "    vec2 f = (center - clamp(center, -range, range)) * scale + 0.5;\n"
+    "    color = texture(source, (floor(texel) + f) / textureSize);\n"
+    "}\n";
+
+/**
+ * @brief Constructor for the CFXResolutionScaler object.
+ *
+ * @param this      Pointer to the CFXResolutionScaler instance to initialize.
+ * @param width     Native width in pixels.
+ * @param height    Native height in pixels.
+ * @param minScale  Lowest resolution scale allowed.
+ * @return          Pointer to the initialized CFXResolutionScaler instance.
+ */
+proc void* Ctor(CFXResolutionScalerRef this, int width, int height, GLfloat minScale)
+{
+    CFXResolutionScaler->dtor = dtor;
+    this->target = NewCFXRenderTarget(width, height, GL_RGBA8);
+    this->upscale = (CFXShaderRef)CFCreate(CFXShader);
+    Compile(this->upscale, CFX_FULLSCREEN_VERTEX_SOURCE, UpscaleFragmentSource);
+    this->scale = 1.0f;
+    this->minScale = minScale;
+    this->maxScale = 1.0f;
+    this->step = 0.1f;
+    this->budget = 0.0;
+    this->headroom = 0.8;
+    this->frameTime = 0.0;
+    this->downFrames = 10;
+    this->upFrames = 60;
+    this->overBudget = 0;
+    this->underBudget = 0;
+    this->beginTime = 0.0;
+    this->cpuTime = 0.0;
+    memset(this->queries, 0, sizeof(this->queries));
+    if (TimerQueries())
+        glGenQueries(CFX_SCALER_QUERIES, this->queries);
+    this->queryHead = 0;
+    this->queryCount = 0;
+    this->scaledWidth = width;
+    this->scaledHeight = height;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXResolutionScaler object.
+ *
+ * @param self Pointer to the CFXResolutionScaler instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXResolutionScalerRef this = self;
+    if (this->queries[0] != 0)
+        glDeleteQueries(CFX_SCALER_QUERIES, this->queries);
+    CFUnref(this->target);
+    CFUnref(this->upscale);
+}
+
+/**
+ * @brief Changes the native size, typically from the framebuffer size callback.
+ *
+ * @param this    Reference to the resolution scaler.
+ * @param width   New native width in pixels.
+ * @param height  New native height in pixels.
+ */
+proc void Resize(CFXResolutionScalerRef this, int width, int height)
+{
+    if (width == this->target->width && height == this->target->height)
+        return;
+    CFUnref(this->target);
+    this->target = NewCFXRenderTarget(width, height, GL_RGBA8);
+}
+
+/**
+ * @brief Folds one frame's drawing time into the smoothed frame time.
+ */
+static void Measure(CFXResolutionScalerRef this, double elapsed)
+{
+    this->frameTime = this->frameTime > 0.0 ? this->frameTime * 0.9 + elapsed * 0.1 : elapsed;
+}
+
+/**
+ * @brief Collects the GPU times that have arrived, oldest first, without waiting.
+ *
+ * @return true if any arrived.
+ */
+static bool CollectQueries(CFXResolutionScalerRef this)
+{
+    bool collected = false;
+#if __EMSCRIPTEN__
+    // A disjoint event, such as a clock change, invalidates the pending results
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        this->queryHead = (this->queryHead + this->queryCount) % CFX_SCALER_QUERIES;
+        this->queryCount = 0;
+        return false;
+    }
+#endif
+    while (this->queryCount > 0) {
+        GLuint query = this->queries[this->queryHead];
+        GLuint available = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 nanoseconds = 0;
+#if __EMSCRIPTEN__
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT, &nanoseconds);
+#else
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+#endif
+        double gpuTime = nanoseconds * 1e-9;
+        Measure(this, gpuTime > this->cpuTime ? gpuTime : this->cpuTime);
+        this->queryHead = (this->queryHead + 1) % CFX_SCALER_QUERIES;
+        this->queryCount--;
+        collected = true;
+    }
+    return collected;
+}
+
+/**
+ * @brief Adjusts the scale from the measured drawing time and starts drawing the world.
+ *
+ * @param this  Reference to the resolution scaler.
+ * @param game  The game, for its target frame time and isRunningSlowly.
+ */
+proc void Begin(CFXResolutionScalerRef this, CFXGameRef game)
+{
+    bool measured = this->queries[0] != 0 ? CollectQueries(this) : this->cpuTime > 0.0;
+    if (this->queries[0] == 0 && measured)
+        Measure(this, this->cpuTime);
+
+    double budget = this->budget > 0.0 ? this->budget : game->targetElapsedTime * SecondsPerTick;
+    if (game->isRunningSlowly || (measured && this->frameTime > budget)) {
+        this->underBudget = 0;
+        if (++this->overBudget >= this->downFrames && this->scale > this->minScale) {
+            this->scale = this->scale - this->step < this->minScale ? this->minScale : this->scale - this->step;
+            this->overBudget = 0;
+        }
+    } else if (!measured) {
+        // Nothing new to judge by while the GPU times are in flight
+    } else if (this->frameTime < budget * this->headroom) {
+        this->overBudget = 0;
+        if (++this->underBudget >= this->upFrames && this->scale < this->maxScale) {
+            this->scale = this->scale + this->step > this->maxScale ? this->maxScale : this->scale + this->step;
+            this->underBudget = 0;
+        }
+    } else {
+        this->overBudget = 0;
+        this->underBudget = 0;
+    }
+
+    this->scaledWidth = Max((int)(this->target->width * this->scale + 0.5f), 1);
+    this->scaledHeight = Max((int)(this->target->height * this->scale + 0.5f), 1);
+    Begin(this->target);
+    glViewport(0, 0, this->scaledWidth, this->scaledHeight);
+
+    // With every query in flight this frame goes untimed on the GPU
+    if (this->queries[0] != 0 && this->queryCount < CFX_SCALER_QUERIES)
+        glBeginQuery(GL_TIME_ELAPSED, this->queries[(this->queryHead + this->queryCount) % CFX_SCALER_QUERIES]);
+    this->beginTime = Now();
+}
+
+/**
+ * @brief Upscales the world to the framebuffer that was bound before Begin.
+ *
+ * @param this Reference to the resolution scaler.
+ */
+proc void End(CFXResolutionScalerRef this)
+{
+    End(this->target);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    Use(this->upscale);
+    SetInteger(this->upscale, "source", 0);
+    SetVector2(this->upscale, "sourceSize", this->scaledWidth, this->scaledHeight);
+    SetVector2(this->upscale, "textureSize", this->target->width, this->target->height);
+    SetVector2(this->upscale, "outputSize", this->target->viewport[2], this->target->viewport[3]);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(this->target->texture);
+    CFXRenderTarget_DrawFullscreen();
+    if (blend)
+        glEnable(GL_BLEND);
+
+    if (this->queries[0] != 0 && this->queryCount < CFX_SCALER_QUERIES) {
+        glEndQuery(GL_TIME_ELAPSED);
+        this->queryCount++;
+    }
+    this->cpuTime = Now() - this->beginTime;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "game.h"
+#include "rendertarget.h"
+#include "shader.h"
+
+extern CFClassRef CFXResolutionScaler;
+typedef struct __CFXResolutionScaler* CFXResolutionScalerRef;
+
+#define CFX_SCALER_QUERIES 4
+
+/**
+ * @struct __CFXResolutionScaler
+ * @brief Renders the world at a variable resolution to hold the frame rate.
+ *
+ * The world is drawn between Begin and End into a native size target through
+ * a viewport shrunk by scale, so changing the scale never reallocates. End
+ * upscales that region to the previous framebuffer with a sharp bilinear
+ * filter, which keeps texel edges crisp where plain bilinear would blur
+ * them. Anything drawn after End, such as HUD text, stays at native size.
+ *
+ * The scaler measures the work of drawing the world rather than the time
+ * between frames, which vsync and the game's frame pacing hold at the
+ * budget whatever the scale. With timer queries (GL_ARB_timer_query, or
+ * EXT_disjoint_timer_query_webgl2 on the web) the GPU time from Begin to
+ * End is read back a few frames late without stalling; the CPU time
+ * between them counts too, and the larger of the two is smoothed. The
+ * scale drops by step once the frame time has been over budget, or the game
+ * has reported isRunningSlowly, for downFrames frames in a row, and rises by
+ * step only after upFrames frames under headroom * budget. The gap between
+ * the two thresholds and the longer wait before raising keep the scale from
+ * oscillating.
+ *
+ * Members:
+ * - obj:         Base object information for the resolution scaler.
+ * - target:      Native size render target.
+ * - upscale:     Built-in sharp bilinear upscale shader.
+ * - scale:       Current resolution scale, between minScale and maxScale.
+ * - minScale:    Lowest scale allowed.
+ * - maxScale:    Highest scale allowed, normally 1.
+ * - step:        Amount the scale changes by at once.
+ * - budget:      Frame time budget in seconds; 0 uses the game's target frame time.
+ * - headroom:    Fraction of the budget the frame time must stay under to raise the scale.
+ * - frameTime:   Smoothed time in seconds the world took to draw.
+ * - downFrames:  Consecutive frames over budget before lowering the scale.
+ * - upFrames:    Consecutive frames with headroom before raising the scale.
+ * - overBudget:  Current run of frames over budget.
+ * - underBudget: Current run of frames with headroom.
+ * - beginTime:   CPU time of the current Begin in seconds.
+ * - cpuTime:     CPU time between the last Begin and End in seconds.
+ * - queries:     Ring of GL_TIME_ELAPSED queries, or zeros without timer queries.
+ * - queryHead:   Oldest query still waiting for its result.
+ * - queryCount:  Queries waiting for their results.
+ * - scaledWidth, scaledHeight: Size of the region drawn this frame.
+ */
+typedef struct __CFXResolutionScaler {
+    __CFObject obj;
+    CFXRenderTargetRef target;
+    CFXShaderRef upscale;
+    GLfloat scale;
+    GLfloat minScale;
+    GLfloat maxScale;
+    GLfloat step;
+    double budget;
+    double headroom;
+    double frameTime;
+    int downFrames;
+    int upFrames;
+    int overBudget;
+    int underBudget;
+    double beginTime;
+    double cpuTime;
+    GLuint queries[CFX_SCALER_QUERIES];
+    int queryHead;
+    int queryCount;
+    int scaledWidth;
+    int scaledHeight;
+} __CFXResolutionScaler;
+
+extern proc void* Ctor(
+    CFXResolutionScalerRef this,
+    int width,
+    int height,
+    GLfloat minScale);
+
+extern proc void Resize(
+    CFXResolutionScalerRef this,
+    int width,
+    int height);
+
+extern proc void Begin(
+    CFXResolutionScalerRef this,
+    CFXGameRef game);
+
+extern proc void End(
+    CFXResolutionScalerRef this);
+
+/**
+ * @brief Creates a new CFXResolutionScaler.
+ *
+ * @param width     Native width in pixels, normally the framebuffer width.
+ * @param height    Native height in pixels.
+ * @param minScale  Lowest resolution scale allowed, e.g. 0.5.
+ * @return A reference to the newly created CFXResolutionScaler.
+ */
+static inline CFXResolutionScalerRef NewCFXResolutionScaler(int width, int height, GLfloat minScale)
+{
+    return Ctor((CFXResolutionScalerRef)CFCreate(CFXResolutionScaler), width, height, minScale);
+}
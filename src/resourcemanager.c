@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <emscripten.h>
 #define GL_GLEXT_PROTOTYPES
@@ -17,12 +18,27 @@
  
 class2(CFXResourceManager);
 
+/**
+ * Pages cut by LoadVirtualTexture are 128 texels with their border, and the
+ * page cache is 16 x 16 pages, a 2048 x 2048 texture.
+ */
+constexpr int VirtualPageSize = 128;
+constexpr int VirtualCacheSide = 16;
+
+/**
+ * Most defines a shader variant may be asked for with.
+ */
+constexpr int MaxDefines = 64;
+
 void Init(CFXResourceManagerRef this);
 
 CFXShaderRef LoadShaderFromFile(
     const CFXResourceManagerRef this,
     const GLchar* vShaderFile,
-    const GLchar* fShaderFile);
+    const GLchar* fShaderFile,
+    const char* defines);
+static char* CanonicalDefines(
+    const char* defines);
 CFXTexture2DRef LoadTextureFromFile(
     const CFXResourceManagerRef this,
     const GLchar* file,
@@ -51,6 +67,14 @@ static void dtor(void* self)
     }
     CFUnref(this->Shaders);
 
+    CFMapIter(this->ShaderVariants, &iter);
+    while (iter.key != nullptr) {
+        if (CFIs(iter.obj, (CFClassRef)CFXShader))
+            CFUnref(iter.obj);
+        CFMapIterNext(&iter);
+    }
+    CFUnref(this->ShaderVariants);
+
     CFMapIter(this->Textures, &iter);
     while (iter.key != nullptr) {
         if (CFIs(iter.obj, (CFClassRef)CFXTexture2D))
@@ -58,21 +82,43 @@ static void dtor(void* self)
         CFMapIterNext(&iter);
     }
     CFUnref(this->Textures);
+
+    CFMapIter(this->VirtualTextures, &iter);
+    while (iter.key != nullptr) {
+        if (CFIs(iter.obj, (CFClassRef)CFXVirtualTexture))
+            CFUnref(iter.obj);
+        CFMapIterNext(&iter);
+    }
+    CFUnref(this->VirtualTextures);
+
+    if (this->Loader != nullptr)
+        CFUnref(this->Loader);
+    if (this->Context != nullptr)
+        CFUnref(this->Context);
+    for (int i = 0; i < this->PackCount; i++)
+        CFUnref(this->Packs[i]);
+    free(this->Packs);
 }
 
 /**
  * @brief Initializes the resource manager by creating new maps for shaders and textures.
  *
- * This function allocates and assigns new CFMap instances to the Shaders and Textures
- * members of the resource manager. These maps are intended to store shader and texture
- * resources, respectively.
+ * This function allocates and assigns new CFMap instances to the Shaders,
+ * ShaderVariants, Textures and VirtualTextures members of the resource manager.
+ * The texture loader is created by the first LoadTextureAsync.
  *
  * @param this Pointer to the CFXResourceManagerRef instance to initialize.
  */
 void Init(CFXResourceManagerRef this)
 {
     this->Shaders = CFNew(CFMap, nullptr);
+    this->ShaderVariants = CFNew(CFMap, nullptr);
     this->Textures = CFNew(CFMap, nullptr);
+    this->VirtualTextures = CFNew(CFMap, nullptr);
+    this->Loader = nullptr;
+    this->Context = nullptr;
+    this->Packs = nullptr;
+    this->PackCount = 0;
 }
 
 /**
@@ -89,6 +135,84 @@ proc void* Ctor(CFXResourceManagerRef this)
     return this;
 }
 
+/**
+ * @brief Opens an asset pack and resolves file names through it from now on.
+ *
+ * Shaders and textures are looked up in the mounted packs, last mounted
+ * first, then among the embedded files, before the filesystem. Mount
+ * packs before loading from them; the loader threads read the pack list
+ * without a lock.
+ *
+ * @param this  Reference to the resource manager.
+ * @param path  Pack file, as written by cfxpack.
+ * @return      false if the pack could not be opened.
+ */
+proc bool MountPack(
+    const CFXResourceManagerRef this,
+    const char* path)
+{
+    CFXAssetPackRef pack = NewCFXAssetPack(path);
+    if (!IsOpen(pack)) {
+        CFUnref(pack);
+        return false;
+    }
+    this->Packs = realloc(this->Packs, (this->PackCount + 1) * sizeof(CFXAssetPackRef));
+    this->Packs[this->PackCount++] = pack;
+    return true;
+}
+
+/**
+ * @brief Finds the mounted pack holding a file, last mounted first.
+ */
+static CFXAssetPackRef PackOf(const CFXResourceManagerRef this, const char* path)
+{
+    for (int i = this->PackCount - 1; i >= 0; i--)
+        if (Lookup(this->Packs[i], path) != nullptr)
+            return this->Packs[i];
+    return nullptr;
+}
+
+/**
+ * @brief Finds a file in the mounted packs or among the embedded files.
+ *
+ * @return true with file pointing at the contents in place, or false to read the filesystem.
+ */
+static bool FindFile(const CFXResourceManagerRef this, const char* path, CFXEmbeddedFile* file)
+{
+    CFXAssetPackRef pack = PackOf(this, path);
+    if (pack != nullptr && Find(pack, path, file))
+        return true;
+    const CFXEmbeddedFile* embedded = CFXEmbedded_Find(path);
+    if (embedded == nullptr)
+        return false;
+    *file = *embedded;
+    return true;
+}
+
+/**
+ * @brief Moves shader compiles and async texture uploads onto a loader thread.
+ *
+ * Shaders loaded afterwards are returned at once and compiled by the loader
+ * context; their first Use waits for them. Textures from LoadTextureAsync
+ * are uploaded there instead of by Upload. CFXGame::Run sets its loader
+ * context here when it has one and is given the resource manager.
+ *
+ * @param this     Reference to the resource manager.
+ * @param context  Loader context to use, or nullptr to load on the calling thread.
+ */
+proc void SetLoaderContext(
+    const CFXResourceManagerRef this,
+    CFXLoaderContextRef context)
+{
+    if (context != nullptr)
+        CFRef(context);
+    if (this->Context != nullptr)
+        CFUnref(this->Context);
+    this->Context = context;
+    if (this->Loader != nullptr)
+        SetLoaderContext(this->Loader, context);
+}
+
 /**
  * @brief Loads a shader from the specified vertex and fragment shader files and stores it in the resource manager.
  *
@@ -109,10 +233,67 @@ proc CFXShaderRef LoadShader(
 {
     assert(this != nullptr);
 
-    CFMapSetC(this->Shaders, name, LoadShaderFromFile(this, vShaderFile, fShaderFile));
+    CFMapSetC(this->Shaders, name, LoadShaderFromFile(this, vShaderFile, fShaderFile, nullptr));
     return CFMapGetC(this->Shaders, name);
 }
 
+/**
+ * Loads one specialization of a shader, compiling it on first request.
+ *
+ * Variants are cached by their files and define set, so renderers can ask
+ * for the cheapest program for each draw, e.g. "TEXTURED;PREMULTIPLIED",
+ * instead of branching on uniforms. The order and repetition of the
+ * defines do not matter. Each spelling of a define list is put in canonical
+ * form once and then found under the spelling itself, so a repeated request
+ * is a single map lookup.
+ *
+ * @param this         Reference to the resource manager.
+ * @param vShaderFile  Path to the vertex shader file.
+ * @param fShaderFile  Path to the fragment shader file.
+ * @param defines      Defines separated by ';', ',' or spaces, each NAME or NAME=VALUE.
+ * @return             Reference to the cached or newly compiled variant, or
+ *                     nullptr if there are more defines than MaxDefines.
+ */
+proc CFXShaderRef LoadShaderVariant(
+    const CFXResourceManagerRef this,
+    const GLchar* vShaderFile,
+    const GLchar* fShaderFile,
+    const char* defines)
+{
+    if (defines == nullptr)
+        defines = "";
+    char buffer[256];
+    size_t length = strlen(vShaderFile) + strlen(fShaderFile) + strlen(defines) + 3;
+    char* key = length <= sizeof(buffer) ? buffer : malloc(length);
+    snprintf(key, length, "%s|%s|%s", vShaderFile, fShaderFile, defines);
+    CFXShaderRef shader = CFMapGetC(this->ShaderVariants, key);
+    if (shader != nullptr) {
+        if (key != buffer)
+            free(key);
+        return shader;
+    }
+
+    char* set = CanonicalDefines(defines);
+    if (set != nullptr) {
+        size_t canonicalLength = strlen(vShaderFile) + strlen(fShaderFile) + strlen(set) + 3;
+        char* canonical = malloc(canonicalLength);
+        snprintf(canonical, canonicalLength, "%s|%s|%s", vShaderFile, fShaderFile, set);
+        shader = CFMapGetC(this->ShaderVariants, canonical);
+        if (shader == nullptr) {
+            CFMapSetC(this->ShaderVariants, canonical, LoadShaderFromFile(this, vShaderFile, fShaderFile, set));
+            shader = CFMapGetC(this->ShaderVariants, canonical);
+        }
+        // Each entry holds its own reference, so the map releases aliases like any other
+        if (shader != nullptr && strcmp(key, canonical) != 0)
+            CFMapSetC(this->ShaderVariants, key, CFRef(shader));
+        free(canonical);
+        free(set);
+    }
+    if (key != buffer)
+        free(key);
+    return shader;
+}
+
 /**
  * Retrieves a shader resource by its name from the resource manager.
  *
@@ -146,6 +327,83 @@ proc CFXTexture2DRef LoadTexture(
     return CFMapGetC(this->Textures, name);
 }
 
+/**
+ * Starts loading a texture in the background and stores it in the texture map.
+ *
+ * The texture is returned and stored at once, holding a transparent
+ * placeholder; worker threads decode the image and Upload moves it into
+ * the texture on a later frame.
+ *
+ * @param this   Reference to the resource manager.
+ * @param file   Path to the texture file to load.
+ * @param alpha  Specifies whether the texture should include an alpha channel.
+ * @param name   Name to associate with the texture in the texture map.
+ * @return       Reference to the texture.
+ */
+proc CFXTexture2DRef LoadTextureAsync(
+    const CFXResourceManagerRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    const char* name)
+{
+    return LoadTextureAsync(this, file, alpha, name, nullptr, nullptr);
+}
+
+/**
+ * Starts loading a texture in the background, calling back once it is uploaded.
+ *
+ * @param this      Reference to the resource manager.
+ * @param file      Path to the texture file to load.
+ * @param alpha     Specifies whether the texture should include an alpha channel.
+ * @param name      Name to associate with the texture in the texture map.
+ * @param callback  Called on the GL thread after the upload, or nullptr.
+ * @param context   Passed to callback.
+ * @return          Reference to the texture.
+ */
+proc CFXTexture2DRef LoadTextureAsync(
+    const CFXResourceManagerRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    const char* name,
+    CFXTextureLoadedProc callback,
+    void* context)
+{
+    if (this->Loader == nullptr) {
+        this->Loader = NewCFXTextureLoader(0);
+        if (this->Context != nullptr)
+            SetLoaderContext(this->Loader, this->Context);
+    }
+    CFXAssetPackRef pack = PackOf(this, file);
+    CFMapSetC(this->Textures, name, Load(this->Loader, pack, file, alpha, callback, context));
+    return CFMapGetC(this->Textures, name);
+}
+
+/**
+ * Uploads textures decoded since the last call, within a time budget.
+ *
+ * @param this    Reference to the resource manager.
+ * @param budget  Seconds the call may spend.
+ * @return        Number of textures completed.
+ */
+proc int Upload(
+    const CFXResourceManagerRef this,
+    double budget)
+{
+    return this->Loader != nullptr ? Upload(this->Loader, budget) : 0;
+}
+
+/**
+ * Returns the number of textures from LoadTextureAsync still loading.
+ *
+ * @param this  Reference to the resource manager.
+ * @return      Textures not yet uploaded; 0 once everything has arrived.
+ */
+proc int Pending(
+    const CFXResourceManagerRef this)
+{
+    return this->Loader != nullptr ? Pending(this->Loader) : 0;
+}
+
 /**
  * Retrieves a texture resource by its name from the resource manager.
  *
@@ -160,41 +418,378 @@ proc CFXTexture2DRef GetTexture(
     return CFMapGetC(this->Textures, name);
 }
 
+/**
+ * Loads a virtual texture and stores it in the resource manager's virtual texture map.
+ *
+ * The page file is cut from the image on first use and reused afterwards;
+ * ship the page file alone to skip decoding the image at runtime.
+ *
+ * @param this      Reference to the resource manager.
+ * @param image     Source image, only read when the page file does not exist.
+ * @param pageFile  Page file to open or create.
+ * @param name      Name to associate with the virtual texture.
+ * @return          Reference to the loaded virtual texture.
+ */
+proc CFXVirtualTextureRef LoadVirtualTexture(
+    const CFXResourceManagerRef this,
+    const GLchar* image,
+    const GLchar* pageFile,
+    const char* name)
+{
+    struct stat st;
+    if (stat(pageFile, &st) != 0)
+        CFXVirtualTexture_Split(image, pageFile, VirtualPageSize);
+
+    CFMapSetC(this->VirtualTextures, name, NewCFXVirtualTexture(pageFile, VirtualCacheSide));
+    return CFMapGetC(this->VirtualTextures, name);
+}
+
+/**
+ * Retrieves a virtual texture by its name from the resource manager.
+ *
+ * @param this Pointer to the resource manager instance.
+ * @param name The name of the virtual texture to retrieve.
+ * @return A reference to the virtual texture if found, otherwise NULL.
+ */
+proc CFXVirtualTextureRef GetVirtualTexture(
+    const CFXResourceManagerRef this,
+    const char* name)
+{
+    return CFMapGetC(this->VirtualTextures, name);
+}
+
 /**
  * @brief Clears the resource manager by destructing and reinitializing it.
  *
  * This function first calls the destructor on the given resource manager instance
  * to release any allocated resources, and then reinitializes it to a clean state.
+ * The loader context and mounted packs are kept.
  *
  * @param this A reference to the resource manager to be cleared.
  */
 void Clear(CFXResourceManagerRef this)
 {
+    CFXLoaderContextRef context = this->Context != nullptr ? CFRef(this->Context) : nullptr;
+    CFXAssetPackRef* packs = this->Packs;
+    int packCount = this->PackCount;
+    this->Packs = nullptr;
+    this->PackCount = 0;
     dtor(this);
     Init(this);
+    this->Context = context;
+    this->Packs = packs;
+    this->PackCount = packCount;
+}
+
+/**
+ * Growable text the preprocessor writes into.
+ */
+typedef struct ShaderText {
+    char* data;
+    size_t length;
+    size_t capacity;
+} ShaderText;
+
+static void Append(ShaderText* text, const char* data, size_t length)
+{
+    if (text->length + length + 1 > text->capacity) {
+        text->capacity = Max(text->capacity * 2, text->length + length + 1);
+        text->data = realloc(text->data, text->capacity);
+    }
+    memcpy(text->data + text->length, data, length);
+    text->length += length;
+    text->data[text->length] = '\0';
+}
+
+static void AppendLine(ShaderText* text, int line, int file)
+{
+    char directive[32];
+    Append(text, directive, snprintf(directive, sizeof(directive), "#line %d %d\n", line, file));
+}
+
+static int CompareDefines(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+/**
+ * @brief Sorts a define list and drops repeats, so equal sets share one key.
+ *
+ * @param defines  Defines separated by ';', ',' or spaces, or nullptr.
+ * @return A new string of the defines joined by ';', or nullptr if there
+ *         are more than MaxDefines.
+ */
+static char* CanonicalDefines(const char* defines)
+{
+    char* copy = strdup(defines != nullptr ? defines : "");
+    int count = 0;
+    char* names[MaxDefines];
+    for (char* name = strtok(copy, ";, \t\n"); name != nullptr; name = strtok(nullptr, ";, \t\n")) {
+        if (count == MaxDefines) {
+            printf("| ERROR::RESOURCEMANAGER: More than %d defines in \"%s\"\n", MaxDefines, defines);
+            free(copy);
+            return nullptr;
+        }
+        names[count++] = name;
+    }
+    qsort(names, count, sizeof(char*), CompareDefines);
+
+    ShaderText set = {};
+    Append(&set, "", 0);
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && strcmp(names[i], names[i - 1]) == 0)
+            continue;
+        if (set.length > 0)
+            Append(&set, ";", 1);
+        Append(&set, names[i], strlen(names[i]));
+    }
+    free(copy);
+    return set.data;
+}
+
+/**
+ * @brief Writes a canonical define set as #define lines.
+ */
+static void AppendDefines(ShaderText* text, const char* defines)
+{
+    for (const char* name = defines; *name != '\0';) {
+        size_t length = strcspn(name, ";");
+        size_t nameLength = strcspn(name, "=;");
+        Append(text, "#define ", 8);
+        Append(text, name, nameLength);
+        if (nameLength < length) {
+            Append(text, " ", 1);
+            Append(text, name + nameLength + 1, length - nameLength - 1);
+        }
+        Append(text, "\n", 1);
+        name += length + (name[length] == ';');
+    }
+}
+
+/**
+ * @brief Opens a shader file, reading a packed or embedded copy in place if there is one.
+ */
+static FILE* OpenShaderFile(const CFXResourceManagerRef this, const char* path)
+{
+    CFXEmbeddedFile found;
+    if (FindFile(this, path, &found) && found.size > 0)
+        return fmemopen((void*)found.data, found.size, "rb");
+    return fopen(path, "rb");
+}
+
+/**
+ * Files already expanded into the source being built, in the order they
+ * were first read; a file's index is its #line source string number.
+ */
+typedef struct ShaderFiles {
+    char* paths[32];
+    int count;
+} ShaderFiles;
+
+/**
+ * @brief Expands a shader file and, recursively, the files it includes.
+ *
+ * `#include "file"` is resolved against the including file's directory
+ * and each file is expanded once, so shared headers need no guards. The
+ * defines go right after the top file's #version line, which GLSL
+ * requires first, wherever comments or blank lines put it; without one
+ * they lead the source. #line directives keep compiler errors pointing at the
+ * original file and line; the file numbers follow the order in which the
+ * files are reported.
+ *
+ * @return false if a file could not be read.
+ */
+static bool Preprocess(const CFXResourceManagerRef this, ShaderText* text, ShaderFiles* files, const char* path, const char* defines)
+{
+    for (int i = 0; i < files->count; i++)
+        if (strcmp(files->paths[i], path) == 0)
+            return true;
+    if (files->count == 32) {
+        printf("| ERROR::RESOURCEMANAGER: Too many shader includes at %s\n", path);
+        return false;
+    }
+    FILE* file = OpenShaderFile(this, path);
+    if (file == nullptr) {
+        printf("| ERROR::RESOURCEMANAGER: Failed to open shader %s\n", path);
+        return false;
+    }
+    int index = files->count;
+    files->paths[files->count++] = strdup(path);
+    if (index > 0)
+        AppendLine(text, 1, index);
+
+    bool ok = true;
+    bool top = index == 0;
+    char line[1024];
+    if (top) {
+        // Comments may precede #version, so look for it before copying anything
+        bool version = false;
+        while (!version && fgets(line, sizeof(line), file) != nullptr)
+            version = strncmp(line + strspn(line, " \t"), "#version", 8) == 0;
+        rewind(file);
+        if (!version) {
+            AppendDefines(text, defines);
+            AppendLine(text, 1, index);
+            top = false;
+        }
+    }
+    for (int number = 1; fgets(line, sizeof(line), file) != nullptr; number++) {
+        const char* directive = line + strspn(line, " \t");
+        if (top && strncmp(directive, "#version", 8) == 0) {
+            Append(text, line, strlen(line));
+            AppendDefines(text, defines);
+            AppendLine(text, number + 1, index);
+            top = false;
+            continue;
+        }
+        if (strncmp(directive, "#include", 8) != 0) {
+            Append(text, line, strlen(line));
+            continue;
+        }
+
+        const char* open = strpbrk(directive + 8, "\"<");
+        const char* close = open != nullptr ? strpbrk(open + 1, "\">") : nullptr;
+        if (close == nullptr) {
+            printf("| ERROR::RESOURCEMANAGER: Malformed #include in %s:%d\n", path, number);
+            ok = false;
+            break;
+        }
+        const char* slash = strrchr(path, '/');
+        int dirLength = slash != nullptr ? (int)(slash - path + 1) : 0;
+        char include[1024];
+        snprintf(include, sizeof(include), "%.*s%.*s", dirLength, path, (int)(close - open - 1), open + 1);
+        if (!Preprocess(this, text, files, include, "")) {
+            ok = false;
+            break;
+        }
+        AppendLine(text, number + 1, index);
+    }
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Reads a shader file with its includes expanded and the defines injected.
+ *
+ * @return The source, to be freed by the caller, or nullptr on failure.
+ */
+static char* ReadShaderSource(const CFXResourceManagerRef this, const char* path, const char* defines)
+{
+    ShaderText text = {};
+    ShaderFiles files = {};
+    Append(&text, "", 0);
+    bool ok = Preprocess(this, &text, &files, path, defines != nullptr ? defines : "");
+    for (int i = 0; i < files.count; i++)
+        free(files.paths[i]);
+    if (!ok) {
+        free(text.data);
+        return nullptr;
+    }
+    return text.data;
+}
+
+/**
+ * @brief Compiles a shader pair into shader; see LoadShaderFromFile.
+ */
+static void BuildShader(
+    const CFXResourceManagerRef this,
+    CFXShaderRef shader,
+    const GLchar* vShaderFile,
+    const GLchar* fShaderFile,
+    const char* defines)
+{
+    // Packed or embedded sources that need no preprocessing compile straight from read-only data
+    CFXEmbeddedFile vFound, fFound;
+    if (FindFile(this, vShaderFile, &vFound) && FindFile(this, fShaderFile, &fFound)
+        && (defines == nullptr || defines[0] == '\0')
+        && strstr((const char*)vFound.data, "#include") == nullptr
+        && strstr((const char*)fFound.data, "#include") == nullptr) {
+        Compile(shader, (const GLchar*)vFound.data, (const GLchar*)fFound.data);
+        return;
+    }
+
+    char* vShader = ReadShaderSource(this, vShaderFile, defines);
+    char* fShader = ReadShaderSource(this, fShaderFile, defines);
+    if (vShader != nullptr && fShader != nullptr)
+        Compile(shader, vShader, fShader);
+    free(vShader);
+    free(fShader);
+}
+
+/**
+ * A shader pair being compiled on the loader thread into built, whose
+ * program replaces shader's once published.
+ */
+typedef struct ShaderTask {
+    CFXResourceManagerRef manager;
+    CFXShaderRef shader;
+    CFXShaderRef built;
+    char* vShaderFile;
+    char* fShaderFile;
+    char* defines;
+} ShaderTask;
+
+static void RunShaderTask(void* context)
+{
+    ShaderTask* task = context;
+    BuildShader(task->manager, task->built, task->vShaderFile, task->fShaderFile, task->defines);
+}
+
+static void PublishShaderTask(void* context)
+{
+    ShaderTask* task = context;
+    task->shader->Id = task->built->Id;
+    task->shader->loader = nullptr;
+    task->shader->loaderTask = nullptr;
+    task->built->Id = 0;
+    CFUnref(task->built);
+    CFUnref(task->shader);
+    CFUnref(task->manager);
+    free(task->vShaderFile);
+    free(task->fShaderFile);
+    free(task->defines);
+    free(task);
 }
 
 /**
  * @brief Loads a shader from vertex and fragment shader source files.
  *
  * This function reads the contents of the specified vertex and fragment shader files,
- * then creates and returns a new shader object using those sources.
+ * expanding their #include directives and injecting the defines, then creates and
+ * returns a new shader object using those sources. Files compiled in with
+ * CFX_EMBED_FILES, or held by a mounted pack, are read in place instead of
+ * from the filesystem. With a loader context the reading and compiling
+ * happen on its thread and the shader is returned at once.
  *
  * @param this         Reference to the resource manager.
  * @param vShaderFile  Path to the vertex shader source file.
  * @param fShaderFile  Path to the fragment shader source file.
+ * @param defines      Canonical define set joined by ';', or nullptr for none.
  * @return             Reference to the created shader object.
  */
 CFXShaderRef LoadShaderFromFile(
     const CFXResourceManagerRef this,
     const GLchar* vShaderFile,
-    const GLchar* fShaderFile)
+    const GLchar* fShaderFile,
+    const char* defines)
 {
+    CFXShaderRef shader = (CFXShaderRef)CFCreate(CFXShader);
+    if (this->Context == nullptr) {
+        BuildShader(this, shader, vShaderFile, fShaderFile, defines);
+        return shader;
+    }
 
-    CFStringRef vShader = CFFS.readTextFile((char*)vShaderFile);
-    CFStringRef fShader = CFFS.readTextFile((char*)fShaderFile);
-
-    return Ctor((CFXShaderRef)CFCreate(CFXShader), vShader, fShader);
+    ShaderTask* task = malloc(sizeof(ShaderTask));
+    task->manager = CFRef(this);
+    task->shader = CFRef(shader);
+    task->built = (CFXShaderRef)CFCreate(CFXShader);
+    task->vShaderFile = CFStrDup((char*)vShaderFile);
+    task->fShaderFile = CFStrDup((char*)fShaderFile);
+    task->defines = CFStrDup((char*)(defines != nullptr ? defines : ""));
+    shader->loader = this->Context;
+    shader->loaderTask = task;
+    Post(this->Context, RunShaderTask, PublishShaderTask, task);
+    return shader;
 }
 
 /**
@@ -202,9 +797,11 @@ CFXShaderRef LoadShaderFromFile(
  *
  * This function loads an image file using stb_image, optionally with an alpha channel,
  * and creates a texture object suitable for use with OpenGL. The image is flipped
- * vertically during loading to match OpenGL's coordinate system.
+ * vertically during loading to match OpenGL's coordinate system. Images in a
+ * mounted pack or compiled in with CFX_EMBED_FILES are decoded in place, and
+ * images a pack holds decoded are only copied or decompressed.
  *
- * @param this      The resource manager reference (unused in this function).
+ * @param this      The resource manager reference, whose packs are searched first.
  * @param file      The path to the image file to load.
  * @param alpha     GL_TRUE to load the image with an alpha channel (RGBA), GL_FALSE for RGB only.
  * @return          A reference to the created CFXTexture2D object containing the loaded texture.
@@ -219,9 +816,29 @@ CFXTexture2DRef LoadTextureFromFile(
 
     CFXTexture2DRef texture = Ctor((CFXTexture2DRef)CFCreate(CFXTexture2D), format, format, (char*)file);
 
+    CFXAssetPackRef pack = PackOf(this, file);
+    const CFXPackEntry* entry = pack != nullptr ? Lookup(pack, file) : nullptr;
+    if (entry != nullptr && (entry->flags & CFX_PACK_IMAGE)) {
+        unsigned char* pixels = malloc(entry->size);
+        if (entry->channels != (alpha ? 4u : 3u))
+            printf("| ERROR::RESOURCEMANAGER: %s is packed with %u channels\n", file, entry->channels);
+        else if (!Unpack(pack, entry, pixels))
+            printf("| ERROR::RESOURCEMANAGER: Corrupt image %s in %s\n", file, pack->path);
+        else {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            Generate(texture, (int)entry->width, (int)entry->height, pixels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        free(pixels);
+        return texture;
+    }
+
     stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
     int width, height, nrChannels;
-    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, stbiFlag);
+    CFXEmbeddedFile found;
+    unsigned char* data = FindFile(this, file, &found)
+        ? stbi_load_from_memory(found.data, (int)found.size, &width, &height, &nrChannels, stbiFlag)
+        : stbi_load(file, &width, &height, &nrChannels, stbiFlag);
     Generate(texture, width, height, (unsigned char*)data);
     stbi_image_free(data);
 
@@ -2,7 +2,11 @@
 #include <corefw.h>       // IWYU pragma: keep
 #include "corefx.h"                 // IWYU pragma: keep
 #include "shader.h"
+#include "assetpack.h"
+#include "loadercontext.h"
 #include "texture2d.h"
+#include "textureloader.h"
+#include "virtualtexture.h"
 
 extern CFClassRef CFXResourceManager;
 
@@ -18,25 +22,51 @@ typedef struct __CFXResourceManager* CFXResourceManagerRef;
  * Members:
  * - obj:      Base object information for resource manager.
  * - Shaders:  Map reference holding shader resources.
+ * - ShaderVariants: Map reference holding shader variants by files and define set.
  * - Textures: Map reference holding texture resources.
  * - Fonts:    Map reference holding font resources.
+ * - VirtualTextures: Map reference holding virtual texture resources.
+ * - Loader:   Decodes textures for LoadTextureAsync; created on first use.
+ * - Context:  Optional loader context that compiles shaders and uploads async textures.
+ * - Packs:    Mounted asset packs, searched last mounted first.
+ * - PackCount: Number of mounted packs.
  */
 typedef struct __CFXResourceManager {
     __CFObject obj;
     CFMapRef Shaders;
+    CFMapRef ShaderVariants;
     CFMapRef Textures;
     CFMapRef Fonts;
+    CFMapRef VirtualTextures;
+    CFXTextureLoaderRef Loader;
+    CFXLoaderContextRef Context;
+    CFXAssetPackRef* Packs;
+    int PackCount;
 } __CFXResourceManager;
 
 extern proc void* Ctor(
     CFXResourceManagerRef this);
 
+extern proc void SetLoaderContext(
+    const CFXResourceManagerRef this,
+    CFXLoaderContextRef context);
+
+extern proc bool MountPack(
+    const CFXResourceManagerRef this,
+    const char* path);
+
 extern proc CFXShaderRef LoadShader(
     const CFXResourceManagerRef this,
     const GLchar* vShaderFile,
     const GLchar* fShaderFile,
     const char* name);
 
+extern proc CFXShaderRef LoadShaderVariant(
+    const CFXResourceManagerRef this,
+    const GLchar* vShaderFile,
+    const GLchar* fShaderFile,
+    const char* defines);
+
 extern proc CFXShaderRef GetShader(
     const CFXResourceManagerRef this,
     const char* name);
@@ -47,10 +77,41 @@ extern proc CFXTexture2DRef LoadTexture(
     GLboolean alpha,
     const char* name);
 
+extern proc CFXTexture2DRef LoadTextureAsync(
+    const CFXResourceManagerRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    const char* name);
+
+extern proc CFXTexture2DRef LoadTextureAsync(
+    const CFXResourceManagerRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    const char* name,
+    CFXTextureLoadedProc callback,
+    void* context);
+
+extern proc int Upload(
+    const CFXResourceManagerRef this,
+    double budget);
+
+extern proc int Pending(
+    const CFXResourceManagerRef this);
+
 extern proc CFXTexture2DRef GetTexture(
     const CFXResourceManagerRef this,
     const char* name);
 
+extern proc CFXVirtualTextureRef LoadVirtualTexture(
+    const CFXResourceManagerRef this,
+    const GLchar* image,
+    const GLchar* pageFile,
+    const char* name);
+
+extern proc CFXVirtualTextureRef GetVirtualTexture(
+    const CFXResourceManagerRef this,
+    const char* name);
+
 /**
  * @brief Creates and initializes a new CFXResourceManager instance.
  *
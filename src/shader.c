@@ -1,5 +1,11 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <emscripten.h>
 #define GL_GLEXT_PROTOTYPES
 #define EGL_EGLEXT_PROTOTYPES
@@ -7,7 +13,27 @@
 #include "corefx.h"                 // IWYU pragma: keep
 #include <GLFW/glfw3.h>
 
-class(CFXShader);
+class2(CFXShader);
+
+static void Finish(CFXShaderRef this);
+
+/**
+ * @brief Destructor for the CFXShader object.
+ *
+ * Queues the program for deletion once the GPU is done with it.
+ *
+ * @param self Pointer to the CFXShader instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXShaderRef this = self;
+    if (this->linking) {
+        CFXDeletionQueue_Shaders(1, &this->vertex);
+        CFXDeletionQueue_Shaders(1, &this->fragment);
+    }
+    CFXDeletionQueue_Programs(1, &this->Id);
+    free(this->cachePath);
+}
 
 /**
  * @brief Constructor function for CFXShaderRef objects.
@@ -25,11 +51,30 @@ proc void* Ctor(CFXShaderRef this, CFStringRef vShader, CFStringRef fShader)
     return this;
 }
 
+/**
+ * @brief Constructor function for CFXShaderRef objects that feed a transform feedback buffer.
+ *
+ * @param this Pointer to the CFXShaderRef object to initialize.
+ * @param vShader Reference to the vertex shader source code as a CFStringRef.
+ * @param fShader Reference to the fragment shader source code as a CFStringRef.
+ * @param varyings Names of the vertex shader outputs to capture.
+ * @param count Number of entries in varyings.
+ * @return Pointer to the initialized CFXShaderRef object.
+ */
+proc void* Ctor(CFXShaderRef this, CFStringRef vShader, CFStringRef fShader, const GLchar* const* varyings, GLsizei count)
+{
+    Compile(this, CFStringC(vShader), CFStringC(fShader), varyings, count);
+    return this;
+}
+
 /**
  * Activates the specified shader program for subsequent rendering operations.
  *
  * This function calls glUseProgram with the shader program's ID, making it the current
- * active shader program in the OpenGL context. It returns the same shader reference for
+ * active shader program in the OpenGL context, first waiting for a loader
+ * thread still compiling it, and for nothing else the thread has queued,
+ * and checking the results of a compile deferred
+ * by async mode. It returns the same shader reference for
  * possible chaining or further use.
  *
  * @param this A reference to the shader program to activate.
@@ -37,10 +82,264 @@ proc void* Ctor(CFXShaderRef this, CFStringRef vShader, CFStringRef fShader)
  */
 proc CFXShaderRef Use(CFXShaderRef this)
 {
+    if (this->loader != nullptr)
+        Finish(this->loader, this->loaderTask);
+    if (this->linking)
+        Finish(this);
     glUseProgram(this->Id);
     return this;
 }
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Per thread, so a loader thread compiling during LoadContent checks its own results
+static _Thread_local bool Async;
+
+/**
+ * @brief Turns deferred status checks on or off for later compiles.
+ *
+ * In async mode Compile submits the shaders and the link and returns
+ * without asking for their status, which would wait for the driver. The
+ * errors are checked on the program's first Use, so a batch of compiles
+ * submitted together overlaps with whatever the caller does next.
+ * CFXGame::Run enables it around LoadContent. The mode is per thread.
+ *
+ * @param async  Defer status checks to first Use.
+ */
+void CFXShader_SetAsync(bool async)
+{
+    Async = async;
+}
+
+/**
+ * @brief Reports whether the driver compiles in the background and can be polled.
+ */
+static bool ParallelCompile(void)
+{
+    static int supported = -1;
+    if (supported < 0) {
+        supported = 0;
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (strcmp(name, "GL_KHR_parallel_shader_compile") == 0
+                || strcmp(name, "GL_ARB_parallel_shader_compile") == 0)
+                supported = 1;
+        }
+    }
+    return supported;
+}
+
+/**
+ * Linked programs are cached as `<CacheDirectory>/<key>.bin`, where the key
+ * hashes everything that decides the binary: both sources, the captured
+ * varyings and the driver's vendor, renderer and version strings. A driver
+ * update changes the key, so stale binaries are never offered; one the
+ * driver rejects anyway is recompiled and overwritten.
+ *
+ * WebGL has no program binaries, so the cache only exists in native builds.
+ */
+#define CFX_SHADER_CACHE_MAGIC 0x50584643 // "CFXP"
+
+typedef struct CFXShaderCacheHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+    uint32_t reserved;
+    double compileSeconds;
+} CFXShaderCacheHeader;
+
+// Programs compile on the render thread and on a loader thread, so these are locked
+static pthread_mutex_t CacheLock = PTHREAD_MUTEX_INITIALIZER;
+static char* CacheDirectory;
+static bool CacheConfigured;
+static int CacheHits;
+static int CacheMisses;
+static double CacheSecondsSaved;
+
+/**
+ * @brief Sets the directory linked programs are cached in.
+ *
+ * The cache is off unless a directory is set here or named by the
+ * CFX_SHADER_CACHE environment variable; pick a per-user location, since
+ * a relative path lands in whatever directory the game was started from.
+ * The directory is created on the first save.
+ *
+ * @param path  Cache directory, or nullptr to disable the cache.
+ */
+void CFXShader_SetCacheDirectory(const char* path)
+{
+    pthread_mutex_lock(&CacheLock);
+    free(CacheDirectory);
+    CacheDirectory = path != nullptr ? strdup(path) : nullptr;
+    CacheConfigured = true;
+    pthread_mutex_unlock(&CacheLock);
+}
+
+/**
+ * @brief Prints the cache hit rate and the link time it saved so far.
+ */
+void CFXShader_LogCacheStats(void)
+{
+    pthread_mutex_lock(&CacheLock);
+    int hits = CacheHits, loads = CacheHits + CacheMisses;
+    double saved = CacheSecondsSaved;
+    pthread_mutex_unlock(&CacheLock);
+    if (loads == 0)
+        return;
+    printf("| SHADER: program cache %d/%d hits (%.0f%%), %.1f ms saved\n",
+        hits, loads, 100.0 * hits / loads, saved * 1000.0);
+}
+
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+#if !__EMSCRIPTEN__
+static uint64_t Hash(uint64_t hash, const char* text)
+{
+    // FNV-1a, with the terminator hashed so ("ab", "c") differs from ("a", "bc")
+    if (text == nullptr)
+        text = "";
+    do {
+        hash ^= (unsigned char)*text;
+        hash *= 0x100000001b3ull;
+    } while (*text++ != '\0');
+    return hash;
+}
+
+/**
+ * @brief Returns the cache file of a program, or false if caching is off.
+ */
+static bool CachePath(
+    char* path,
+    size_t size,
+    const GLchar* vShaderSrc,
+    const GLchar* fShaderSrc,
+    const GLchar* const* varyings,
+    GLsizei count)
+{
+    pthread_mutex_lock(&CacheLock);
+    if (!CacheConfigured) {
+        const char* env = getenv("CFX_SHADER_CACHE");
+        CacheDirectory = env != nullptr ? strdup(env) : nullptr;
+        CacheConfigured = true;
+    }
+    bool enabled = CacheDirectory != nullptr && CacheDirectory[0] != '\0';
+    int length = enabled ? snprintf(path, size, "%s/", CacheDirectory) : 0;
+    pthread_mutex_unlock(&CacheLock);
+    if (!enabled || length < 0 || (size_t)length >= size)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+        return false;
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = Hash(hash, vShaderSrc);
+    hash = Hash(hash, fShaderSrc);
+    for (GLsizei i = 0; i < count; i++)
+        hash = Hash(hash, varyings[i]);
+    hash = Hash(hash, (const char*)glGetString(GL_VENDOR));
+    hash = Hash(hash, (const char*)glGetString(GL_RENDERER));
+    hash = Hash(hash, (const char*)glGetString(GL_VERSION));
+    snprintf(path + length, size - length, "%016llx.bin", (unsigned long long)hash);
+    return true;
+}
+
+/**
+ * @brief Creates a program from its cached binary.
+ *
+ * @return The linked program, or 0 if there is no usable binary.
+ */
+static GLuint LoadCached(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+        return 0;
+    double start = Now();
+    CFXShaderCacheHeader header;
+    void* binary = nullptr;
+    bool read = fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == CFX_SHADER_CACHE_MAGIC
+        && (binary = malloc(header.length)) != nullptr
+        && fread(binary, header.length, 1, file) == 1;
+    fclose(file);
+    if (!read) {
+        free(binary);
+        printf("| ERROR::SHADER: Corrupt program cache entry: %s\n", path);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary, header.length);
+    free(binary);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Usually a driver update that kept its version string; relink and overwrite
+        printf("| ERROR::SHADER: Driver rejected cached program, recompiling: %s\n", path);
+        glDeleteProgram(program);
+        return 0;
+    }
+    pthread_mutex_lock(&CacheLock);
+    CacheSecondsSaved += header.compileSeconds - (Now() - start);
+    pthread_mutex_unlock(&CacheLock);
+    return program;
+}
+
+/**
+ * @brief Writes a linked program's binary to the cache.
+ *
+ * The file is written under a temporary name and renamed into place, so a
+ * crash or a second process never leaves a truncated entry behind.
+ */
+static void SaveCached(const char* path, GLuint program, double compileSeconds)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    CFXShaderCacheHeader header = {
+        .magic = CFX_SHADER_CACHE_MAGIC,
+        .length = (uint32_t)length,
+        .compileSeconds = compileSeconds,
+    };
+    void* binary = malloc(length);
+    GLenum format;
+    glGetProgramBinary(program, length, nullptr, &format, binary);
+    header.format = format;
+
+    // The entry's directory, as it was when the path was made
+    char directory[1024];
+    snprintf(directory, sizeof(directory), "%.*s", (int)(strrchr(path, '/') - path), path);
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("| ERROR::SHADER: Unable to create program cache %s\n", directory);
+        free(binary);
+        return;
+    }
+    char temp[1024];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* file = fopen(temp, "wb");
+    bool written = file != nullptr
+        && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(binary, length, 1, file) == 1;
+    if (file != nullptr)
+        written = fclose(file) == 0 && written;
+    if (!written || rename(temp, path) != 0) {
+        printf("| ERROR::SHADER: Unable to write program cache entry %s\n", path);
+        remove(temp);
+    }
+    free(binary);
+}
+#endif
+
 /**
  * @brief Checks and reports shader compilation or program linking errors.
  *
@@ -75,6 +374,36 @@ void CheckCompileErrors(
     }
 }
 
+/**
+ * @brief Checks the results of a submitted compile and releases its shaders.
+ *
+ * Querying compile or link status waits for the driver, so in async mode
+ * this runs on the program's first Use rather than in Compile.
+ *
+ * @param this  Reference to the shader object.
+ */
+static void Finish(CFXShaderRef this)
+{
+    double start = Now();
+    this->linking = false;
+    CheckCompileErrors(this, this->vertex, "VERTEX");
+    CheckCompileErrors(this, this->fragment, "FRAGMENT");
+    CheckCompileErrors(this, this->Id, "PROGRAM");
+    // Delete the shaders as they're linked into our program now and no longer necessery
+    glDeleteShader(this->vertex);
+    glDeleteShader(this->fragment);
+    this->vertex = this->fragment = 0;
+
+#if !__EMSCRIPTEN__
+    GLint success;
+    glGetProgramiv(this->Id, GL_LINK_STATUS, &success);
+    if (this->cachePath != nullptr && success)
+        SaveCached(this->cachePath, this->Id, this->compileSeconds + Now() - start);
+#endif
+    free(this->cachePath);
+    this->cachePath = nullptr;
+}
+
 /**
  * @brief Compiles and links vertex and fragment shaders into a shader program.
  *
@@ -91,27 +420,96 @@ proc void Compile(
     const GLchar* vShaderSrc,
     const GLchar* fShaderSrc)
 {
+    Compile(this, vShaderSrc, fShaderSrc, nullptr, 0);
+}
 
-    GLuint sVertex, sFragment;
-    // Vertex CFXShader
-    sVertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(sVertex, 1, &vShaderSrc, nullptr);
-    glCompileShader(sVertex);
-    CheckCompileErrors(this, sVertex, "VERTEX");
-    // Fragment CFXShader
-    sFragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(sFragment, 1, &fShaderSrc, nullptr);
-    glCompileShader(sFragment);
-    CheckCompileErrors(this, sFragment, "FRAGMENT");
+/**
+ * @brief Compiles and links a shader program, capturing the given varyings with transform feedback.
+ *
+ * The varyings must be declared before glLinkProgram, so they are registered here
+ * between attaching the shaders and linking. They are captured interleaved into a
+ * single buffer bound at GL_TRANSFORM_FEEDBACK_BUFFER index 0.
+ *
+ * In native builds the linked program is first looked up in the program
+ * binary cache, and saved to it after a full compile. In async mode the
+ * status checks and the save wait for the program's first Use.
+ *
+ * @param this Pointer to the CFXShaderRef object where the program ID will be stored.
+ * @param vShaderSrc Source code for the vertex shader.
+ * @param fShaderSrc Source code for the fragment shader.
+ * @param varyings Names of the vertex shader outputs to capture, or nullptr for none.
+ * @param count Number of entries in varyings.
+ */
+proc void Compile(
+    CFXShaderRef this,
+    const GLchar* vShaderSrc,
+    const GLchar* fShaderSrc,
+    const GLchar* const* varyings,
+    GLsizei count)
+{
+    // Built-in shaders are made with CFCreate and Compile, bypassing Ctor
+    CFXShader->dtor = dtor;
+    if (this->linking)
+        Finish(this);
+    if (this->Id != 0)
+        CFXDeletionQueue_Programs(1, &this->Id);
+
+    double start = Now();
+#if !__EMSCRIPTEN__
+    char path[1024];
+    if (CachePath(path, sizeof(path), vShaderSrc, fShaderSrc, varyings, count)) {
+        this->Id = LoadCached(path);
+        pthread_mutex_lock(&CacheLock);
+        if (this->Id != 0)
+            CacheHits++;
+        else
+            CacheMisses++;
+        pthread_mutex_unlock(&CacheLock);
+        if (this->Id != 0)
+            return;
+        this->cachePath = strdup(path);
+    }
+#endif
+
+    this->vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(this->vertex, 1, &vShaderSrc, nullptr);
+    glCompileShader(this->vertex);
+    this->fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(this->fragment, 1, &fShaderSrc, nullptr);
+    glCompileShader(this->fragment);
 
     this->Id = glCreateProgram();
-    glAttachShader(this->Id, sVertex);
-    glAttachShader(this->Id, sFragment);
+    glAttachShader(this->Id, this->vertex);
+    glAttachShader(this->Id, this->fragment);
+    if (count > 0)
+        glTransformFeedbackVaryings(this->Id, count, varyings, GL_INTERLEAVED_ATTRIBS);
+#if !__EMSCRIPTEN__
+    if (this->cachePath != nullptr)
+        glProgramParameteri(this->Id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
     glLinkProgram(this->Id);
-    CheckCompileErrors(this, this->Id, "PROGRAM");
-    // Delete the shaders as they're linked into our program now and no longer necessery
-    glDeleteShader(sVertex);
-    glDeleteShader(sFragment);
+    this->linking = true;
+    this->compileSeconds = Now() - start;
+    if (!Async)
+        Finish(this);
+}
+
+/**
+ * @brief Reports whether the driver has finished linking the program.
+ *
+ * Without KHR_parallel_shader_compile the driver cannot be asked, so this
+ * returns true and the first Use waits instead.
+ *
+ * @param this  Reference to the shader object.
+ * @return true if Use will not block on compilation.
+ */
+proc bool IsReady(CFXShaderRef this)
+{
+    if (!this->linking || !ParallelCompile())
+        return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(this->Id, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
 }
 
 /**
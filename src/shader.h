@@ -8,7 +8,16 @@
 
 extern CFClassRef CFXShader;
 
+/**
+ * @brief GLSL header prepended to the framework's built-in shaders.
+ *
+ * WebGL2 only accepts GLSL ES 3.00, and desktop Mesa (llvmpipe included)
+ * accepts it through GL_ARB_ES3_compatibility, so one source serves both builds.
+ */
+#define CFX_GLSL_VERSION "#version 300 es\nprecision highp float;\n"
+
 typedef struct __CFXShader* CFXShaderRef;
+typedef struct __CFXLoaderContext* CFXLoaderContextRef;
 
 /**
  * @struct __CFXShader
@@ -21,10 +30,29 @@ typedef struct __CFXShader* CFXShaderRef;
  *      The base CoreFX object, providing common object functionality.
  * @var __CFXShader::Id
  *      The OpenGL identifier for the shader object.
+ * @var __CFXShader::vertex, __CFXShader::fragment
+ *      Shaders of a compile whose status has not been checked yet.
+ * @var __CFXShader::linking
+ *      Whether a compile is awaiting its status check on first Use.
+ * @var __CFXShader::cachePath
+ *      Program cache entry to save once the pending link succeeds.
+ * @var __CFXShader::compileSeconds
+ *      Time spent compiling so far, stored with the cache entry.
+ * @var __CFXShader::loader
+ *      Loader context compiling the program, until it is published.
+ * @var __CFXShader::loaderTask
+ *      Context the compile was posted to loader with, so Use waits for it alone.
  */
 typedef struct __CFXShader {
     __CFObject obj;
     GLuint Id;
+    GLuint vertex;
+    GLuint fragment;
+    bool linking;
+    char* cachePath;
+    double compileSeconds;
+    CFXLoaderContextRef loader;
+    void* loaderTask;
 } __CFXShader;
 
 extern proc void* Ctor(
@@ -32,6 +60,13 @@ extern proc void* Ctor(
     CFStringRef vShader, 
     CFStringRef fShader);
 
+extern proc void* Ctor(
+    CFXShaderRef this,
+    CFStringRef vShader,
+    CFStringRef fShader,
+    const GLchar* const* varyings,
+    GLsizei count);
+
 extern proc CFXShaderRef Use(
     CFXShaderRef this);
 
@@ -42,7 +77,25 @@ extern proc void Compile(
     CFXShaderRef this, 
     const GLchar* vertexSource, 
     const GLchar* fragmentSource);
+
+extern proc void Compile(
+    CFXShaderRef this,
+    const GLchar* vertexSource,
+    const GLchar* fragmentSource,
+    const GLchar* const* varyings,
+    GLsizei count);
     
+extern void CFXShader_SetCacheDirectory(
+    const char* path);
+
+extern void CFXShader_LogCacheStats(void);
+
+extern void CFXShader_SetAsync(
+    bool async);
+
+extern proc bool IsReady(
+    CFXShaderRef this);
+
 extern proc void SetFloat(
     CFXShaderRef this,
     const GLchar* name,
@@ -163,3 +216,19 @@ static inline CFXShaderRef NewCFXShader(CFStringRef vShader, CFStringRef fShader
 {
     return Ctor((CFXShaderRef)CFCreate(CFXShader), vShader, fShader);
 }
+
+/**
+ * @brief Creates a new CFXShader whose vertex outputs are captured by transform feedback.
+ *
+ * The named varyings are registered, interleaved, before the program is linked.
+ *
+ * @param vShader   The source code for the vertex shader as a CFStringRef.
+ * @param fShader   The source code for the fragment shader as a CFStringRef.
+ * @param varyings  Names of the vertex shader outputs to capture, in buffer order.
+ * @param count     Number of entries in varyings.
+ * @return CFXShaderRef A reference to the newly created shader object.
+ */
+static inline CFXShaderRef NewCFXShaderWithFeedback(CFStringRef vShader, CFStringRef fShader, const GLchar* const* varyings, GLsizei count)
+{
+    return Ctor((CFXShaderRef)CFCreate(CFXShader), vShader, fShader, varyings, count);
+}
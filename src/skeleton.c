@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "skeleton.h"
+
+class2(CFXSkeleton);
+
+/**
+ * @brief Constructor for the CFXSkeleton object.
+ *
+ * @param this Pointer to the CFXSkeleton instance to initialize.
+ * @return     Pointer to the initialized CFXSkeleton instance.
+ */
+proc void* Ctor(CFXSkeletonRef this)
+{
+    CFXSkeleton->dtor = dtor;
+    this->boneCount = 0;
+    this->boneCapacity = 0;
+    this->parent = nullptr;
+    this->boneNames = nullptr;
+    this->setup = nullptr;
+    this->vertices = nullptr;
+    this->vertexCount = 0;
+    this->vertexCapacity = 0;
+    this->indices = nullptr;
+    this->indexCount = 0;
+    this->indexCapacity = 0;
+    this->poses = nullptr;
+    this->poseFrames = 0;
+    this->poseCapacity = 0;
+    this->clips = nullptr;
+    this->clipCount = 0;
+    this->clipCapacity = 0;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXSkeleton object.
+ *
+ * @param self Pointer to the CFXSkeleton instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXSkeletonRef this = self;
+    for (int i = 0; i < this->boneCount; i++)
+        free(this->boneNames[i]);
+    for (int i = 0; i < this->clipCount; i++)
+        free(this->clips[i].name);
+    free(this->boneNames);
+    free(this->parent);
+    free(this->setup);
+    free(this->vertices);
+    free(this->indices);
+    free(this->poses);
+    free(this->clips);
+}
+
+/**
+ * @brief Adds a bone.
+ *
+ * Bones must be added parents first and before any clip, since baked clips
+ * are laid out by bone count.
+ *
+ * @param this    Reference to the skeleton.
+ * @param name    Bone name.
+ * @param parent  Index of an already added bone, or -1 for a root.
+ * @param setup   Rest pose relative to the parent.
+ * @return        Index of the bone, or -1 if the order rules are broken.
+ */
+proc int AddBone(CFXSkeletonRef this, const char* name, int parent, CFXBonePose setup)
+{
+    if (parent >= this->boneCount || this->clipCount > 0) {
+        printf("| ERROR::SKELETON: Bone %s added out of order\n", name);
+        return -1;
+    }
+    if (this->boneCount == this->boneCapacity) {
+        this->boneCapacity = this->boneCapacity ? this->boneCapacity * 2 : 16;
+        this->parent = realloc(this->parent, this->boneCapacity * sizeof(int));
+        this->boneNames = realloc(this->boneNames, this->boneCapacity * sizeof(char*));
+        this->setup = realloc(this->setup, this->boneCapacity * sizeof(CFXBonePose));
+    }
+    this->parent[this->boneCount] = parent;
+    this->boneNames[this->boneCount] = CFStrDup((char*)name);
+    this->setup[this->boneCount] = setup;
+    return this->boneCount++;
+}
+
+/**
+ * @brief Looks up a bone by name.
+ *
+ * @return Index of the bone, or -1.
+ */
+proc int FindBone(CFXSkeletonRef this, const char* name)
+{
+    for (int i = 0; i < this->boneCount; i++)
+        if (strcmp(this->boneNames[i], name) == 0)
+            return i;
+    return -1;
+}
+
+/**
+ * @brief Attaches rigged geometry, appending to the skeleton's vertex and index lists.
+ *
+ * @param this         Reference to the skeleton.
+ * @param vertices     Rigged vertices.
+ * @param vertexCount  Number of vertices.
+ * @param indices      Triangles, indexing vertices from 0.
+ * @param indexCount   Number of indices, a multiple of 3.
+ */
+proc void AddMesh(
+    CFXSkeletonRef this,
+    const CFXSkeletonVertex* vertices,
+    int vertexCount,
+    const GLuint* indices,
+    int indexCount)
+{
+    if (this->vertexCount + vertexCount > this->vertexCapacity) {
+        this->vertexCapacity = Max(this->vertexCapacity * 2, this->vertexCount + vertexCount);
+        this->vertices = realloc(this->vertices, this->vertexCapacity * sizeof(CFXSkeletonVertex));
+    }
+    if (this->indexCount + indexCount > this->indexCapacity) {
+        this->indexCapacity = Max(this->indexCapacity * 2, this->indexCount + indexCount);
+        this->indices = realloc(this->indices, this->indexCapacity * sizeof(GLuint));
+    }
+    for (int i = 0; i < indexCount; i++)
+        this->indices[this->indexCount + i] = indices[i] + this->vertexCount;
+    memcpy(this->vertices + this->vertexCount, vertices, vertexCount * sizeof(CFXSkeletonVertex));
+    this->vertexCount += vertexCount;
+    this->indexCount += indexCount;
+}
+
+/**
+ * @brief Attaches a rectangular sprite rigidly to a bone.
+ *
+ * @param this    Reference to the skeleton.
+ * @param bone    Index of the bone.
+ * @param bounds  Rectangle in the bone's space.
+ * @param uvRect  Region of the atlas: offset (x, y) and size (z, w) in uv space.
+ */
+proc void AddSprite(CFXSkeletonRef this, int bone, CFXRect bounds, Vec4 uvRect)
+{
+    float x0 = bounds.x, y0 = bounds.y, x1 = bounds.x + bounds.w, y1 = bounds.y + bounds.h;
+    float u0 = uvRect.x, v0 = uvRect.y + uvRect.w, u1 = uvRect.x + uvRect.z, v1 = uvRect.y;
+    CFXSkeletonVertex quad[4] = {
+        { { { x0, y0 } }, { bone, bone }, 1.0f, { u0, v0 } },
+        { { { x1, y0 } }, { bone, bone }, 1.0f, { u1, v0 } },
+        { { { x1, y1 } }, { bone, bone }, 1.0f, { u1, v1 } },
+        { { { x0, y1 } }, { bone, bone }, 1.0f, { u0, v1 } },
+    };
+    // Counter-clockwise once the y-down projection flips them, so culling keeps them
+    static const GLuint indices[] = { 0, 2, 1, 0, 3, 2 };
+    AddMesh(this, quad, 4, indices, 6);
+}
+
+/**
+ * @brief Samples one bone's channel at a time from its keys, linearly.
+ *
+ * Falls back to the setup pose when the bone has no keys; holds the first
+ * and last keys outside their range.
+ */
+static GLfloat SampleKeys(
+    CFXSkeletonRef this,
+    const CFXBoneKey* keys,
+    int keyCount,
+    int bone,
+    int channel,
+    GLfloat time)
+{
+    const CFXBoneKey* before = nullptr;
+    const CFXBoneKey* after = nullptr;
+    for (int k = 0; k < keyCount; k++) {
+        if (keys[k].bone != bone)
+            continue;
+        if (keys[k].time <= time && (before == nullptr || keys[k].time >= before->time))
+            before = &keys[k];
+        if (keys[k].time >= time && (after == nullptr || keys[k].time < after->time))
+            after = &keys[k];
+    }
+    if (before == nullptr && after == nullptr)
+        return ((const GLfloat*)&this->setup[bone])[channel];
+    if (before == nullptr)
+        before = after;
+    if (after == nullptr)
+        after = before;
+    GLfloat a = ((const GLfloat*)&before->pose)[channel];
+    GLfloat b = ((const GLfloat*)&after->pose)[channel];
+    GLfloat span = after->time - before->time;
+    return span > 0.0f ? a + (b - a) * (time - before->time) / span : a;
+}
+
+/**
+ * @brief Adds a clip, baking its keys into poses sampled at a fixed rate.
+ *
+ * @param this      Reference to the skeleton.
+ * @param name      Clip name.
+ * @param keys      Keyframes, in any order.
+ * @param keyCount  Number of keys.
+ * @param duration  Length of the clip in seconds.
+ * @param rate      Baked frames per second; 30 is plenty for linear keys. It is
+ *                  adjusted so a whole number of frames spans the duration.
+ * @param loop      Whether the clip repeats.
+ * @return          Index of the clip.
+ */
+proc int AddClip(
+    CFXSkeletonRef this,
+    const char* name,
+    const CFXBoneKey* keys,
+    int keyCount,
+    GLfloat duration,
+    GLfloat rate,
+    bool loop)
+{
+    int frames = Max((int)(duration * rate + 0.5f), 1) + 1;
+    // Frames are spaced evenly over the duration, at the rate playback samples them
+    GLfloat spacing = duration > 0.0f ? duration : 1.0f;
+    if (this->poseFrames + frames > this->poseCapacity) {
+        this->poseCapacity = Max(this->poseCapacity * 2, this->poseFrames + frames);
+        this->poses = realloc(this->poses, (size_t)this->poseCapacity * CFX_BONE_CHANNELS * this->boneCount * sizeof(GLfloat));
+    }
+    for (int f = 0; f < frames; f++) {
+        GLfloat time = f == frames - 1 ? duration : f * spacing / (frames - 1);
+        GLfloat* frame = this->poses + (size_t)(this->poseFrames + f) * CFX_BONE_CHANNELS * this->boneCount;
+        for (int c = 0; c < CFX_BONE_CHANNELS; c++)
+            for (int b = 0; b < this->boneCount; b++)
+                frame[c * this->boneCount + b] = SampleKeys(this, keys, keyCount, b, c, time);
+    }
+
+    if (this->clipCount == this->clipCapacity) {
+        this->clipCapacity = this->clipCapacity ? this->clipCapacity * 2 : 8;
+        this->clips = realloc(this->clips, this->clipCapacity * sizeof(CFXSkeletonClip));
+    }
+    this->clips[this->clipCount] = (CFXSkeletonClip) {
+        .name = CFStrDup((char*)name), .first = this->poseFrames, .frames = frames,
+        .rate = (frames - 1) / spacing, .loop = loop };
+    this->poseFrames += frames;
+    return this->clipCount++;
+}
+
+/**
+ * @brief Looks up a clip by name.
+ *
+ * @return Index of the clip, or -1.
+ */
+proc int FindClip(CFXSkeletonRef this, const char* name)
+{
+    for (int i = 0; i < this->clipCount; i++)
+        if (strcmp(this->clips[i].name, name) == 0)
+            return i;
+    return -1;
+}
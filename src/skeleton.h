@@ -0,0 +1,190 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rect.h"
+#include "tglm.h"
+
+extern CFClassRef CFXSkeleton;
+typedef struct __CFXSkeleton* CFXSkeletonRef;
+
+/**
+ * Channels of a bone pose, in the order they are stored in baked clips.
+ */
+enum {
+    CFX_BONE_X,
+    CFX_BONE_Y,
+    CFX_BONE_ROTATION,
+    CFX_BONE_SCALE_X,
+    CFX_BONE_SCALE_Y,
+    CFX_BONE_CHANNELS
+};
+
+/**
+ * @struct CFXBonePose
+ * @brief Transform of a bone relative to its parent.
+ *
+ * Rotation is in radians. Scale applies before rotation, then translation.
+ */
+typedef struct CFXBonePose {
+    GLfloat x;
+    GLfloat y;
+    GLfloat rotation;
+    GLfloat scaleX;
+    GLfloat scaleY;
+} CFXBonePose;
+
+/**
+ * @struct CFXBoneKey
+ * @brief A keyframe of one bone, used to build a clip.
+ *
+ * Rotations are interpolated as given, without wrapping, so a key at 350
+ * degrees following one at 10 turns the long way round; unwrap them first.
+ */
+typedef struct CFXBoneKey {
+    int bone;
+    GLfloat time;
+    CFXBonePose pose;
+} CFXBoneKey;
+
+/**
+ * @struct CFXSkeletonVertex
+ * @brief A rigged vertex influenced by up to two bones.
+ *
+ * Members:
+ * - position:  Position in the space of each bone.
+ * - bone:      Influencing bones; bone[1] is ignored when weight is 1.
+ * - weight:    Influence of bone[0]; bone[1] gets 1 - weight.
+ * - uv:        Texture coordinate in the atlas.
+ */
+typedef struct CFXSkeletonVertex {
+    Vec2 position[2];
+    int bone[2];
+    GLfloat weight;
+    Vec2 uv;
+} CFXSkeletonVertex;
+
+/**
+ * @struct CFXSkeletonClip
+ * @brief An animation baked into evenly spaced poses of every bone.
+ *
+ * Members:
+ * - name:    Clip name, for FindClip.
+ * - first:   Index of the clip's first baked frame.
+ * - frames:  Number of baked frames; the last one is the pose at duration.
+ * - rate:    Baked frames per second, (frames - 1) / duration.
+ * - loop:    Whether playback wraps or holds the last pose.
+ */
+typedef struct CFXSkeletonClip {
+    char* name;
+    int first;
+    int frames;
+    GLfloat rate;
+    bool loop;
+} CFXSkeletonClip;
+
+/**
+ * @struct __CFXSkeleton
+ * @brief Shared definition of a rig: bones, skinned geometry and clips.
+ *
+ * Bones are stored parents first, so world transforms can be computed in a
+ * single forward pass. Attached sprites and meshes are flattened into one
+ * vertex and index list, so a character of any number of bones and parts
+ * is drawn with one call by CFXSkeletonBatch.
+ *
+ * Clips are baked at load time into poses sampled at a fixed rate. A baked
+ * frame stores each channel as a contiguous array over bones, so sampling a
+ * character is a handful of straight lerp loops rather than a keyframe
+ * search per bone.
+ *
+ * Members:
+ * - obj:            Base object information for the skeleton.
+ * - boneCount:      Number of bones.
+ * - boneCapacity:   Allocated size of the bone arrays.
+ * - parent:         Index of each bone's parent, or -1 for roots.
+ * - boneNames:      Bone names, for FindBone.
+ * - setup:          Rest pose of each bone, used where a clip has no keys.
+ * - vertices:       Rigged vertices of every attachment.
+ * - vertexCount:    Number of vertices.
+ * - vertexCapacity: Allocated size of vertices.
+ * - indices:        Triangles, indexing vertices.
+ * - indexCount:     Number of indices.
+ * - indexCapacity:  Allocated size of indices.
+ * - poses:          Baked frames: frame * CFX_BONE_CHANNELS * boneCount floats each.
+ * - poseFrames:     Number of baked frames over all clips.
+ * - poseCapacity:   Allocated size of poses in frames.
+ * - clips:          Clips, indexing the baked frames.
+ * - clipCount:      Number of clips.
+ * - clipCapacity:   Allocated size of clips.
+ */
+typedef struct __CFXSkeleton {
+    __CFObject obj;
+    int boneCount;
+    int boneCapacity;
+    int* parent;
+    char** boneNames;
+    CFXBonePose* setup;
+    CFXSkeletonVertex* vertices;
+    int vertexCount;
+    int vertexCapacity;
+    GLuint* indices;
+    int indexCount;
+    int indexCapacity;
+    GLfloat* poses;
+    int poseFrames;
+    int poseCapacity;
+    CFXSkeletonClip* clips;
+    int clipCount;
+    int clipCapacity;
+} __CFXSkeleton;
+
+extern proc void* Ctor(
+    CFXSkeletonRef this);
+
+extern proc int AddBone(
+    CFXSkeletonRef this,
+    const char* name,
+    int parent,
+    CFXBonePose setup);
+
+extern proc int FindBone(
+    CFXSkeletonRef this,
+    const char* name);
+
+extern proc void AddSprite(
+    CFXSkeletonRef this,
+    int bone,
+    CFXRect bounds,
+    Vec4 uvRect);
+
+extern proc void AddMesh(
+    CFXSkeletonRef this,
+    const CFXSkeletonVertex* vertices,
+    int vertexCount,
+    const GLuint* indices,
+    int indexCount);
+
+extern proc int AddClip(
+    CFXSkeletonRef this,
+    const char* name,
+    const CFXBoneKey* keys,
+    int keyCount,
+    GLfloat duration,
+    GLfloat rate,
+    bool loop);
+
+extern proc int FindClip(
+    CFXSkeletonRef this,
+    const char* name);
+
+/**
+ * @brief Creates a new, empty CFXSkeleton.
+ *
+ * @return A reference to the newly created CFXSkeleton.
+ */
+static inline CFXSkeletonRef NewCFXSkeleton()
+{
+    return Ctor((CFXSkeletonRef)CFCreate(CFXSkeleton));
+}
@@ -0,0 +1,371 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "skeletonbatch.h"
+
+class2(CFXSkeletonBatch);
+
+/**
+ * Indices into world: the 2x2 linear part by columns, then the translation.
+ */
+enum { AffineA, AffineB, AffineC, AffineD, AffineX, AffineY };
+
+/**
+ * @brief Constructor for the CFXSkeletonBatch object.
+ *
+ * @param this      Pointer to the CFXSkeletonBatch instance to initialize.
+ * @param skeleton  Rig shared by every character.
+ * @param shader    Shader used to draw.
+ * @param texture   Atlas the attachments sample.
+ * @return          Pointer to the initialized CFXSkeletonBatch instance.
+ */
+proc void* Ctor(CFXSkeletonBatchRef this, CFXSkeletonRef skeleton, CFXShaderRef shader, CFXTexture2DRef texture)
+{
+    CFXSkeletonBatch->dtor = dtor;
+    this->skeleton = skeleton;
+    this->shader = shader;
+    this->texture = texture;
+    this->count = 0;
+    this->capacity = 0;
+    this->clip = nullptr;
+    this->time = nullptr;
+    this->speed = nullptr;
+    this->position = nullptr;
+    this->color = nullptr;
+    this->dirty = nullptr;
+    this->pending = nullptr;
+    memset(this->local, 0, sizeof(this->local));
+    memset(this->world, 0, sizeof(this->world));
+    this->vertices = nullptr;
+    this->vertexCount = skeleton->vertexCount;
+    this->indexedCount = 0;
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->EBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CFXSkinVertex), (GLvoid*)offsetof(CFXSkinVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CFXSkinVertex), (GLvoid*)offsetof(CFXSkinVertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CFXSkinVertex), (GLvoid*)offsetof(CFXSkinVertex, color));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXSkeletonBatch object.
+ *
+ * @param self Pointer to the CFXSkeletonBatch instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXSkeletonBatchRef this = self;
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
+    CFXDeletionQueue_Buffers(1, &this->EBO);
+    free(this->clip);
+    free(this->time);
+    free(this->speed);
+    free(this->position);
+    free(this->color);
+    free(this->dirty);
+    free(this->pending);
+    for (int i = 0; i < CFX_BONE_CHANNELS; i++)
+        free(this->local[i]);
+    for (int i = 0; i < 6; i++)
+        free(this->world[i]);
+    free(this->vertices);
+}
+
+/**
+ * @brief Relays the skinned vertices out when attachments were added to the skeleton.
+ *
+ * Every character is re-skinned into the new layout on the next Update, and
+ * the index buffer is rebuilt on the next Draw.
+ */
+static void ResizeVertices(CFXSkeletonBatchRef this)
+{
+    if (this->vertexCount == this->skeleton->vertexCount)
+        return;
+    this->vertexCount = this->skeleton->vertexCount;
+    this->vertices = realloc(this->vertices, (size_t)this->capacity * this->vertexCount * sizeof(CFXSkinVertex));
+    for (int i = 0; i < this->count; i++)
+        this->dirty[i] = true;
+    this->indexedCount = 0;
+}
+
+/**
+ * @brief Adds a character at the start of a clip.
+ *
+ * @param this      Reference to the batch.
+ * @param clip      Index of a clip of the skeleton.
+ * @param position  World position of the root bones.
+ * @return          Index of the character, or -1 if there is no such clip.
+ */
+proc int AddCharacter(CFXSkeletonBatchRef this, int clip, Vec2 position)
+{
+    if (clip < 0 || clip >= this->skeleton->clipCount) {
+        printf("| ERROR::SKELETONBATCH: No clip %d\n", clip);
+        return -1;
+    }
+    ResizeVertices(this);
+    int bones = this->skeleton->boneCount;
+    if (this->count == this->capacity) {
+        this->capacity = this->capacity ? this->capacity * 2 : 16;
+        size_t n = this->capacity;
+        this->clip = realloc(this->clip, n * sizeof(int));
+        this->time = realloc(this->time, n * sizeof(GLfloat));
+        this->speed = realloc(this->speed, n * sizeof(GLfloat));
+        this->position = realloc(this->position, n * sizeof(Vec2));
+        this->color = realloc(this->color, n * sizeof(Vec4));
+        this->dirty = realloc(this->dirty, n * sizeof(bool));
+        this->pending = realloc(this->pending, n * sizeof(int));
+        for (int i = 0; i < CFX_BONE_CHANNELS; i++)
+            this->local[i] = realloc(this->local[i], n * bones * sizeof(GLfloat));
+        for (int i = 0; i < 6; i++)
+            this->world[i] = realloc(this->world[i], n * bones * sizeof(GLfloat));
+        this->vertices = realloc(this->vertices, n * this->vertexCount * sizeof(CFXSkinVertex));
+    }
+    int character = this->count++;
+    this->speed[character] = 1.0f;
+    this->position[character] = position;
+    this->color[character] = (Vec4) { 1.0f, 1.0f, 1.0f, 1.0f };
+    Play(this, character, clip);
+    return character;
+}
+
+/**
+ * @brief Removes a character by moving the last character into its slot.
+ *
+ * @param this       Reference to the batch.
+ * @param character  Index of the character; the last character takes this index.
+ */
+proc void RemoveCharacter(CFXSkeletonBatchRef this, int character)
+{
+    if (character < 0 || character >= this->count)
+        return;
+    int last = --this->count;
+    if (character == last)
+        return;
+    int bones = this->skeleton->boneCount;
+    int vertexCount = this->vertexCount;
+    this->clip[character] = this->clip[last];
+    this->time[character] = this->time[last];
+    this->speed[character] = this->speed[last];
+    this->position[character] = this->position[last];
+    this->color[character] = this->color[last];
+    this->dirty[character] = this->dirty[last];
+    for (int i = 0; i < CFX_BONE_CHANNELS; i++)
+        memcpy(this->local[i] + character * bones, this->local[i] + last * bones, bones * sizeof(GLfloat));
+    for (int i = 0; i < 6; i++)
+        memcpy(this->world[i] + character * bones, this->world[i] + last * bones, bones * sizeof(GLfloat));
+    memcpy(this->vertices + character * vertexCount, this->vertices + last * vertexCount, vertexCount * sizeof(CFXSkinVertex));
+}
+
+/**
+ * @brief Restarts a character on a clip.
+ *
+ * Does nothing for a character or clip that does not exist, such as the -1
+ * FindClip returns for an unknown name.
+ */
+proc void Play(CFXSkeletonBatchRef this, int character, int clip)
+{
+    if (character < 0 || character >= this->count || clip < 0 || clip >= this->skeleton->clipCount) {
+        printf("| ERROR::SKELETONBATCH: No character %d or clip %d\n", character, clip);
+        return;
+    }
+    this->clip[character] = clip;
+    this->time[character] = 0.0f;
+    this->dirty[character] = true;
+}
+
+/**
+ * @brief Moves a character.
+ */
+proc void SetPosition(CFXSkeletonBatchRef this, int character, Vec2 position)
+{
+    this->position[character] = position;
+    this->dirty[character] = true;
+}
+
+/**
+ * @brief Advances every character and skins the ones whose pose changed.
+ *
+ * Pass the delta from Tick.
+ *
+ * @param this   Reference to the batch.
+ * @param delta  Seconds since the last update.
+ */
+proc void Update(CFXSkeletonBatchRef this, GLfloat delta)
+{
+    CFXSkeletonRef skeleton = this->skeleton;
+    const int bones = skeleton->boneCount;
+    const int stride = CFX_BONE_CHANNELS * bones;
+    ResizeVertices(this);
+
+    // Advance clip times, collecting the characters whose pose changed.
+    int pendingCount = 0;
+    for (int i = 0; i < this->count; i++) {
+        if (this->speed[i] != 0.0f) {
+            const CFXSkeletonClip* clip = &skeleton->clips[this->clip[i]];
+            GLfloat duration = (clip->frames - 1) / clip->rate;
+            GLfloat t = this->time[i] + delta * this->speed[i];
+            if (clip->loop && duration > 0.0f) {
+                t = fmodf(t, duration);
+                if (t < 0.0f)
+                    t += duration;
+            } else
+                t = t < 0.0f ? 0.0f : t > duration ? duration : t;
+            if (t != this->time[i])
+                this->dirty[i] = true;
+            this->time[i] = t;
+        }
+        if (this->dirty[i]) {
+            this->dirty[i] = false;
+            this->pending[pendingCount++] = i;
+        }
+    }
+    const int* pending = this->pending;
+
+    // Sample: lerp the two baked frames around the current time, channel by channel.
+    for (int n = 0; n < pendingCount; n++) {
+        const int base = pending[n] * bones;
+        const CFXSkeletonClip* clip = &skeleton->clips[this->clip[pending[n]]];
+        GLfloat at = this->time[pending[n]] * clip->rate;
+        int frame = (int)at;
+        if (frame > clip->frames - 2)
+            frame = Max(clip->frames - 2, 0);
+        GLfloat alpha = clip->frames > 1 ? at - frame : 0.0f;
+        const GLfloat* from = skeleton->poses + (size_t)(clip->first + frame) * stride;
+        const GLfloat* to = clip->frames > 1 ? from + stride : from;
+        for (int ch = 0; ch < CFX_BONE_CHANNELS; ch++) {
+            GLfloat* restrict out = this->local[ch] + base;
+            const GLfloat* restrict a = from + ch * bones;
+            const GLfloat* restrict b = to + ch * bones;
+            for (int k = 0; k < bones; k++)
+                out[k] = a[k] + (b[k] - a[k]) * alpha;
+        }
+    }
+
+    GLfloat* restrict wa = this->world[AffineA];
+    GLfloat* restrict wb = this->world[AffineB];
+    GLfloat* restrict wc = this->world[AffineC];
+    GLfloat* restrict wd = this->world[AffineD];
+    GLfloat* restrict wx = this->world[AffineX];
+    GLfloat* restrict wy = this->world[AffineY];
+
+    // Local matrices, written where the world matrices will go.
+    const GLfloat* restrict rotation = this->local[CFX_BONE_ROTATION];
+    const GLfloat* restrict scaleX = this->local[CFX_BONE_SCALE_X];
+    const GLfloat* restrict scaleY = this->local[CFX_BONE_SCALE_Y];
+    for (int n = 0; n < pendingCount; n++) {
+        const int base = pending[n] * bones;
+        for (int k = base; k < base + bones; k++) {
+            GLfloat cs = cosf(rotation[k]), sn = sinf(rotation[k]);
+            wa[k] = cs * scaleX[k];
+            wb[k] = sn * scaleX[k];
+            wc[k] = -sn * scaleY[k];
+            wd[k] = cs * scaleY[k];
+        }
+        memcpy(wx + base, this->local[CFX_BONE_X] + base, bones * sizeof(GLfloat));
+        memcpy(wy + base, this->local[CFX_BONE_Y] + base, bones * sizeof(GLfloat));
+    }
+
+    // Concatenate down the hierarchy; parents precede children, so each
+    // parent is already in world space when its children are reached.
+    for (int n = 0; n < pendingCount; n++) {
+        const int base = pending[n] * bones;
+        Vec2 root = this->position[pending[n]];
+        for (int b = 0; b < bones; b++) {
+            int k = base + b;
+            if (skeleton->parent[b] < 0) {
+                wx[k] += root.x;
+                wy[k] += root.y;
+                continue;
+            }
+            int p = base + skeleton->parent[b];
+            GLfloat la = wa[k], lb = wb[k], lc = wc[k], ld = wd[k], lx = wx[k], ly = wy[k];
+            wa[k] = wa[p] * la + wc[p] * lb;
+            wb[k] = wb[p] * la + wd[p] * lb;
+            wc[k] = wa[p] * lc + wc[p] * ld;
+            wd[k] = wb[p] * lc + wd[p] * ld;
+            wx[k] = wa[p] * lx + wc[p] * ly + wx[p];
+            wy[k] = wb[p] * lx + wd[p] * ly + wy[p];
+        }
+    }
+
+    // Skin.
+    for (int n = 0; n < pendingCount; n++) {
+        const int base = pending[n] * bones;
+        Vec4 color = this->color[pending[n]];
+        CFXSkinVertex* restrict out = this->vertices + (size_t)pending[n] * this->vertexCount;
+        for (int v = 0; v < this->vertexCount; v++) {
+            const CFXSkeletonVertex* in = &skeleton->vertices[v];
+            int b0 = base + in->bone[0];
+            Vec2 p0 = in->position[0];
+            GLfloat x = wa[b0] * p0.x + wc[b0] * p0.y + wx[b0];
+            GLfloat y = wb[b0] * p0.x + wd[b0] * p0.y + wy[b0];
+            if (in->weight < 1.0f) {
+                int b1 = base + in->bone[1];
+                Vec2 p1 = in->position[1];
+                GLfloat x1 = wa[b1] * p1.x + wc[b1] * p1.y + wx[b1];
+                GLfloat y1 = wb[b1] * p1.x + wd[b1] * p1.y + wy[b1];
+                x = x1 + (x - x1) * in->weight;
+                y = y1 + (y - y1) * in->weight;
+            }
+            out[v] = (CFXSkinVertex) { { x, y }, in->uv, color };
+        }
+    }
+}
+
+/**
+ * @brief Draws every character with one draw call.
+ *
+ * The index buffer repeats the skeleton's triangles once per character and
+ * is only rebuilt when the number of characters changes.
+ *
+ * @param this Reference to the batch.
+ */
+proc void Draw(CFXSkeletonBatchRef this)
+{
+    CFXSkeletonRef skeleton = this->skeleton;
+    // Attachments were added since the last Update; skin them in before drawing
+    if (this->vertexCount != skeleton->vertexCount)
+        Update(this, 0.0f);
+    if (this->count == 0 || skeleton->indexCount == 0)
+        return;
+
+    glBindVertexArray(this->VAO);
+    if (this->indexedCount != this->count) {
+        size_t total = (size_t)this->count * skeleton->indexCount;
+        GLuint* indices = malloc(total * sizeof(GLuint));
+        for (int i = 0; i < this->count; i++)
+            for (int k = 0; k < skeleton->indexCount; k++)
+                indices[i * skeleton->indexCount + k] = skeleton->indices[k] + i * this->vertexCount;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, total * sizeof(GLuint), indices, GL_STATIC_DRAW);
+        free(indices);
+        this->indexedCount = this->count;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)this->count * this->vertexCount * sizeof(CFXSkinVertex), this->vertices, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Use(this->shader);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(this->texture);
+    glDrawElements(GL_TRIANGLES, this->count * skeleton->indexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "shader.h"
+#include "skeleton.h"
+#include "texture2d.h"
+#include "tglm.h"
+
+extern CFClassRef CFXSkeletonBatch;
+typedef struct __CFXSkeletonBatch* CFXSkeletonBatchRef;
+
+/**
+ * @struct CFXSkinVertex
+ * @brief A skinned vertex as uploaded; same layout as CFXUIVertex.
+ */
+typedef struct CFXSkinVertex {
+    Vec2 position;
+    Vec2 uv;
+    Vec4 color;
+} CFXSkinVertex;
+
+/**
+ * @struct __CFXSkeletonBatch
+ * @brief Animates and draws every character sharing a skeleton.
+ *
+ * Characters are stored as parallel arrays, and their per-bone state as
+ * arrays indexed by character * boneCount + bone, one array per channel.
+ * Update runs each stage over all characters before the next: advance
+ * clip times, lerp between baked frames, build local matrices, concatenate
+ * them down the hierarchy, then skin the vertices into one buffer. Draw
+ * uploads that buffer and issues a single draw call for all characters.
+ *
+ * Characters whose pose did not change since the last Update, because they
+ * are paused or holding the end of a clip, keep their cached world
+ * transforms and skinned vertices; the stages run over the rest only.
+ * Attachments added to the skeleton after characters were added are
+ * picked up by the next Update, which re-skins every character.
+ *
+ * The shader reads the same attributes as the CFXUILayer shader:
+ * - location 0: vec2 position in world units
+ * - location 1: vec2 atlas uv
+ * - location 2: vec4 tint
+ *
+ * Members:
+ * - obj:        Base object information for the batch.
+ * - skeleton:   Shared rig.
+ * - shader:     Shader used to draw.
+ * - texture:    Atlas the attachments sample.
+ * - count:      Number of characters.
+ * - capacity:   Allocated number of characters.
+ * - clip:       Per character: clip playing.
+ * - time:       Per character: seconds into the clip.
+ * - speed:      Per character: playback rate, 0 pauses.
+ * - position:   Per character: world position of the root bones.
+ * - color:      Per character: tint.
+ * - dirty:      Per character: pose must be recomputed on the next Update.
+ * - pending:    Characters the current Update recomputes.
+ * - local:      Per character and bone: sampled pose, one array per channel.
+ * - world:      Per character and bone: world affine transform (a, b, c, d, tx, ty),
+ *               one array per coefficient.
+ * - vertices:   Skinned vertices of all characters.
+ * - vertexCount: Vertices per character vertices is laid out for.
+ * - VAO, VBO, EBO: OpenGL objects of the batch.
+ * - indexedCount: Number of characters the index buffer was built for.
+ */
+typedef struct __CFXSkeletonBatch {
+    __CFObject obj;
+    CFXSkeletonRef skeleton;
+    CFXShaderRef shader;
+    CFXTexture2DRef texture;
+    int count;
+    int capacity;
+    int* clip;
+    GLfloat* time;
+    GLfloat* speed;
+    Vec2* position;
+    Vec4* color;
+    bool* dirty;
+    int* pending;
+    GLfloat* local[CFX_BONE_CHANNELS];
+    GLfloat* world[6];
+    CFXSkinVertex* vertices;
+    int vertexCount;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint EBO;
+    int indexedCount;
+} __CFXSkeletonBatch;
+
+extern proc void* Ctor(
+    CFXSkeletonBatchRef this,
+    CFXSkeletonRef skeleton,
+    CFXShaderRef shader,
+    CFXTexture2DRef texture);
+
+extern proc int AddCharacter(
+    CFXSkeletonBatchRef this,
+    int clip,
+    Vec2 position);
+
+extern proc void RemoveCharacter(
+    CFXSkeletonBatchRef this,
+    int character);
+
+extern proc void Play(
+    CFXSkeletonBatchRef this,
+    int character,
+    int clip);
+
+extern proc void SetPosition(
+    CFXSkeletonBatchRef this,
+    int character,
+    Vec2 position);
+
+extern proc void Update(
+    CFXSkeletonBatchRef this,
+    GLfloat delta);
+
+extern proc void Draw(
+    CFXSkeletonBatchRef this);
+
+/**
+ * @brief Creates a new, empty CFXSkeletonBatch.
+ *
+ * The skeleton's bones must be complete; attachments may still be added.
+ *
+ * @param skeleton  Rig shared by every character of the batch.
+ * @param shader    Shader used to draw.
+ * @param texture   Atlas the attachments sample.
+ * @return A reference to the newly created CFXSkeletonBatch.
+ */
+static inline CFXSkeletonBatchRef NewCFXSkeletonBatch(CFXSkeletonRef skeleton, CFXShaderRef shader, CFXTexture2DRef texture)
+{
+    return Ctor((CFXSkeletonBatchRef)CFCreate(CFXSkeletonBatch), skeleton, shader, texture);
+}
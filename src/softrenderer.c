@@ -0,0 +1,522 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+#include "softrenderer.h"
+
+class2(CFXSoftRenderer);
+
+constexpr int MaxThreads = 64;
+
+static void* PoolThread(void* arg);
+
+/**
+ * Four lanes of floats or integers; arithmetic on them compiles to the
+ * target's SIMD instructions.
+ */
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
+typedef uint32_t UInt4 __attribute__((vector_size(16)));
+
+/**
+ * Framebuffer is flipped vertically on present, rows being top to bottom
+ * in memory and bottom to top in GL.
+ */
+static const GLchar* PresentFragmentSource = CFX_GLSL_VERSION
+    "in vec2 uv;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D image;\n"
+    "void main() { color = texture(image, vec2(uv.x, 1.0 - uv.y)); }\n";
+
+/**
+ * @brief Constructor for the CFXSoftRenderer object.
+ *
+ * @param this     Pointer to the CFXSoftRenderer instance to initialize.
+ * @param width    Framebuffer width in pixels.
+ * @param height   Framebuffer height in pixels.
+ * @param threads  Rasterizer threads; 0 uses one per core.
+ * @return         Pointer to the initialized CFXSoftRenderer instance.
+ */
+proc void* Ctor(CFXSoftRendererRef this, int width, int height, int threads)
+{
+    CFXSoftRenderer->dtor = dtor;
+    this->width = Max(width, 1);
+    this->height = Max(height, 1);
+    this->pixels = calloc((size_t)this->width * this->height, sizeof(uint32_t));
+    this->clearColor = (Vec4) { 0.0f, 0.0f, 0.0f, 1.0f };
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    this->threads = threads < 1 ? 1 : threads > MaxThreads ? MaxThreads : threads;
+    this->tilesX = (this->width + CFX_SOFT_TILE - 1) / CFX_SOFT_TILE;
+    this->tilesY = (this->height + CFX_SOFT_TILE - 1) / CFX_SOFT_TILE;
+    this->bins = calloc(this->tilesX * this->tilesY, sizeof(CFXSoftBin));
+    this->quads = nullptr;
+    this->quadCount = 0;
+    this->quadCapacity = 0;
+    this->nextTile = 0;
+    this->texture = nullptr;
+    this->shader = nullptr;
+
+    this->generation = 0;
+    this->busy = 0;
+    this->stopping = false;
+    pthread_mutex_init(&this->lock, nullptr);
+    pthread_cond_init(&this->wake, nullptr);
+    pthread_cond_init(&this->done, nullptr);
+    this->workers = malloc(MaxThreads * sizeof(pthread_t));
+    this->workerCount = 0;
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    for (int i = 1; i < this->threads; i++)
+        if (pthread_create(&this->workers[this->workerCount], nullptr, PoolThread, this) == 0)
+            this->workerCount++;
+#endif
+
+    // Image 0 is a white texel for textures without an image
+    this->images = malloc(sizeof(CFXSoftImage));
+    this->images[0] = (CFXSoftImage) { nullptr, 1, 1, malloc(sizeof(uint32_t)) };
+    this->images[0].pixels[0] = 0xffffffffu;
+    this->imageCount = 1;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXSoftRenderer object.
+ *
+ * @param self Pointer to the CFXSoftRenderer instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXSoftRendererRef this = self;
+    pthread_mutex_lock(&this->lock);
+    this->stopping = true;
+    pthread_cond_broadcast(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+    for (int i = 0; i < this->workerCount; i++)
+        pthread_join(this->workers[i], nullptr);
+    free(this->workers);
+    pthread_mutex_destroy(&this->lock);
+    pthread_cond_destroy(&this->wake);
+    pthread_cond_destroy(&this->done);
+
+    for (int i = 0; i < this->tilesX * this->tilesY; i++)
+        free(this->bins[i].quads);
+    for (int i = 0; i < this->imageCount; i++) {
+        free(this->images[i].path);
+        free(this->images[i].pixels);
+    }
+    free(this->bins);
+    free(this->quads);
+    free(this->images);
+    free(this->pixels);
+    if (this->texture != nullptr)
+        CFUnref(this->texture);
+    if (this->shader != nullptr)
+        CFUnref(this->shader);
+}
+
+/**
+ * @brief Finds or loads the CPU image of a texture, flipped like LoadTexture flips it.
+ */
+static int Image(CFXSoftRendererRef this, CFXTexture2DRef texture)
+{
+    const char* path = texture != nullptr ? texture->path : nullptr;
+    if (path == nullptr || path[0] == '\0')
+        return 0;
+    for (int i = 1; i < this->imageCount; i++)
+        if (strcmp(this->images[i].path, path) == 0)
+            return i;
+
+    CFXSoftImage image = { CFStrDup((char*)path), 1, 1, nullptr };
+    int channels;
+    stbi_set_flip_vertically_on_load(true);
+    const CFXEmbeddedFile* embedded = CFXEmbedded_Find(path);
+    unsigned char* data = embedded != nullptr
+        ? stbi_load_from_memory(embedded->data, (int)embedded->size, &image.width, &image.height, &channels, STBI_rgb_alpha)
+        : stbi_load(path, &image.width, &image.height, &channels, STBI_rgb_alpha);
+    if (data != nullptr) {
+        image.pixels = malloc((size_t)image.width * image.height * sizeof(uint32_t));
+        memcpy(image.pixels, data, (size_t)image.width * image.height * sizeof(uint32_t));
+        stbi_image_free(data);
+    } else {
+        printf("| ERROR::SOFTRENDERER: Failed to load %s\n", path);
+        image.width = image.height = 1;
+        image.pixels = malloc(sizeof(uint32_t));
+        image.pixels[0] = 0xffffffffu;
+    }
+    this->images = realloc(this->images, (this->imageCount + 1) * sizeof(CFXSoftImage));
+    this->images[this->imageCount] = image;
+    return this->imageCount++;
+}
+
+/**
+ * @brief Starts a frame, dropping the quads of the previous one.
+ *
+ * @param this        Reference to the software renderer.
+ * @param clearColor  Color the framebuffer is cleared to by End.
+ */
+proc void Begin(CFXSoftRendererRef this, Vec4 clearColor)
+{
+    this->clearColor = clearColor;
+    this->quadCount = 0;
+    for (int i = 0; i < this->tilesX * this->tilesY; i++)
+        this->bins[i].count = 0;
+}
+
+/**
+ * @brief Records a textured quad and bins it into the tiles it touches.
+ *
+ * @param this      Reference to the software renderer.
+ * @param texture   Texture to sample; its path supplies the image.
+ * @param position  Top-left corner of the unrotated quad, in pixels.
+ * @param size      Size of the quad in pixels.
+ * @param rotate    Rotation in radians about the quad's center.
+ * @param color     Tint multiplied with the texels.
+ * @param uvRect    Region of the texture in uv space: offset (x, y) and size (z, w).
+ */
+proc void Draw(
+    CFXSoftRendererRef this,
+    CFXTexture2DRef texture,
+    Vec2 position,
+    Vec2 size,
+    GLfloat rotate,
+    Vec3 color,
+    Vec4 uvRect)
+{
+    float c = cosf(rotate), s = sinf(rotate);
+    Vec2 ex = { c * size.x, s * size.x };
+    Vec2 ey = { -s * size.y, c * size.y };
+    Vec2 origin = {
+        position.x + 0.5f * size.x - 0.5f * (ex.x + ey.x),
+        position.y + 0.5f * size.y - 0.5f * (ex.y + ey.y),
+    };
+    float det = ex.x * ey.y - ex.y * ey.x;
+    if (fabsf(det) < 1e-12f)
+        return;
+
+    float minX = origin.x + fminf(0.0f, ex.x) + fminf(0.0f, ey.x);
+    float maxX = origin.x + fmaxf(0.0f, ex.x) + fmaxf(0.0f, ey.x);
+    float minY = origin.y + fminf(0.0f, ex.y) + fminf(0.0f, ey.y);
+    float maxY = origin.y + fmaxf(0.0f, ex.y) + fmaxf(0.0f, ey.y);
+    int x0 = Max((int)floorf(minX), 0), y0 = Max((int)floorf(minY), 0);
+    int x1 = (int)ceilf(maxX), y1 = (int)ceilf(maxY);
+    x1 = x1 < this->width ? x1 : this->width;
+    y1 = y1 < this->height ? y1 : this->height;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    CFXSoftQuad quad;
+    quad.sx = ey.y / det;
+    quad.sy = -ey.x / det;
+    quad.s0 = -(origin.x * quad.sx + origin.y * quad.sy);
+    quad.tx = -ex.y / det;
+    quad.ty = ex.x / det;
+    quad.t0 = -(origin.x * quad.tx + origin.y * quad.ty);
+    quad.x0 = x0;
+    quad.y0 = y0;
+    quad.x1 = x1;
+    quad.y1 = y1;
+    quad.uvRect = uvRect;
+    quad.tint = color;
+    quad.image = Image(this, texture);
+    quad.repeat = texture != nullptr && texture->wrapS == GL_REPEAT;
+    quad.bilinear = texture != nullptr && texture->filterMag == GL_LINEAR;
+
+    if (this->quadCount == this->quadCapacity) {
+        this->quadCapacity = this->quadCapacity ? this->quadCapacity * 2 : 256;
+        this->quads = realloc(this->quads, this->quadCapacity * sizeof(CFXSoftQuad));
+    }
+    int index = this->quadCount++;
+    this->quads[index] = quad;
+
+    for (int ty = y0 / CFX_SOFT_TILE; ty <= (y1 - 1) / CFX_SOFT_TILE; ty++) {
+        for (int tx = x0 / CFX_SOFT_TILE; tx <= (x1 - 1) / CFX_SOFT_TILE; tx++) {
+            CFXSoftBin* bin = &this->bins[ty * this->tilesX + tx];
+            if (bin->count == bin->capacity) {
+                bin->capacity = bin->capacity ? bin->capacity * 2 : 64;
+                bin->quads = realloc(bin->quads, bin->capacity * sizeof(int));
+            }
+            bin->quads[bin->count++] = index;
+        }
+    }
+}
+
+static inline int Wrap(int i, int n, bool repeat)
+{
+    if (repeat) {
+        i %= n;
+        return i < 0 ? i + n : i;
+    }
+    return i < 0 ? 0 : i >= n ? n - 1 : i;
+}
+
+static inline void Unpack(UInt4 c, Float4* r, Float4* g, Float4* b, Float4* a)
+{
+    *r = __builtin_convertvector((Int4)(c & 0xffu), Float4);
+    *g = __builtin_convertvector((Int4)((c >> 8) & 0xffu), Float4);
+    *b = __builtin_convertvector((Int4)((c >> 16) & 0xffu), Float4);
+    *a = __builtin_convertvector((Int4)(c >> 24), Float4);
+}
+
+/**
+ * @brief Clamps channel values to [0, 255], as GL saturates a tinted color.
+ */
+static inline Float4 Saturate(Float4 v)
+{
+    const Float4 top = { 255.0f, 255.0f, 255.0f, 255.0f };
+    v = (Float4)((Int4)v & (v > 0.0f));
+    Int4 over = v > top;
+    return (Float4)(((Int4)v & ~over) | ((Int4)top & over));
+}
+
+static inline UInt4 Pack(Float4 r, Float4 g, Float4 b, Float4 a)
+{
+    UInt4 ri = (UInt4)__builtin_convertvector(r + 0.5f, Int4);
+    UInt4 gi = (UInt4)__builtin_convertvector(g + 0.5f, Int4);
+    UInt4 bi = (UInt4)__builtin_convertvector(b + 0.5f, Int4);
+    UInt4 ai = (UInt4)__builtin_convertvector(a + 0.5f, Int4);
+    return ri | (gi << 8) | (bi << 16) | (ai << 24);
+}
+
+/**
+ * @brief Samples four pixels' texels into channel vectors in [0, 255].
+ *
+ * Texel addresses are computed per lane since gathers are not portable;
+ * the filtering itself runs on whole vectors.
+ */
+static inline void Sample(const CFXSoftQuad* q, const CFXSoftImage* image, Float4 s, Float4 t, int n,
+    Float4* r, Float4* g, Float4* b, Float4* a)
+{
+    int w = image->width, h = image->height;
+    UInt4 c00 = { 0 }, c10 = { 0 }, c01 = { 0 }, c11 = { 0 };
+    Float4 fx = { 0 }, fy = { 0 };
+    for (int i = 0; i < n; i++) {
+        float si = s[i] < 0.0f ? 0.0f : s[i] > 1.0f ? 1.0f : s[i];
+        float ti = t[i] < 0.0f ? 0.0f : t[i] > 1.0f ? 1.0f : t[i];
+        float u = (q->uvRect.x + si * q->uvRect.z) * w;
+        float v = (q->uvRect.y + ti * q->uvRect.w) * h;
+        if (q->bilinear) {
+            u -= 0.5f;
+            v -= 0.5f;
+            float x0 = floorf(u), y0 = floorf(v);
+            fx[i] = u - x0;
+            fy[i] = v - y0;
+            int ix0 = Wrap((int)x0, w, q->repeat), ix1 = Wrap((int)x0 + 1, w, q->repeat);
+            int iy0 = Wrap((int)y0, h, q->repeat), iy1 = Wrap((int)y0 + 1, h, q->repeat);
+            c00[i] = image->pixels[iy0 * w + ix0];
+            c10[i] = image->pixels[iy0 * w + ix1];
+            c01[i] = image->pixels[iy1 * w + ix0];
+            c11[i] = image->pixels[iy1 * w + ix1];
+        } else {
+            c00[i] = image->pixels[Wrap((int)floorf(v), h, q->repeat) * w + Wrap((int)floorf(u), w, q->repeat)];
+        }
+    }
+    Unpack(c00, r, g, b, a);
+    if (!q->bilinear)
+        return;
+
+    Float4 r1, g1, b1, a1;
+    Unpack(c10, &r1, &g1, &b1, &a1);
+    *r += (r1 - *r) * fx;
+    *g += (g1 - *g) * fx;
+    *b += (b1 - *b) * fx;
+    *a += (a1 - *a) * fx;
+    Float4 r2, g2, b2, a2;
+    Unpack(c01, &r2, &g2, &b2, &a2);
+    Unpack(c11, &r1, &g1, &b1, &a1);
+    r2 += (r1 - r2) * fx;
+    g2 += (g1 - g2) * fx;
+    b2 += (b1 - b2) * fx;
+    a2 += (a1 - a2) * fx;
+    *r += (r2 - *r) * fy;
+    *g += (g2 - *g) * fy;
+    *b += (b2 - *b) * fy;
+    *a += (a2 - *a) * fy;
+}
+
+/**
+ * @brief Blends a quad over the pixels [x0, x1) of row y, four at a time.
+ */
+static void FillSpan(const CFXSoftQuad* q, const CFXSoftImage* image, uint32_t* row, int y, int x0, int x1)
+{
+    float py = y + 0.5f;
+    float sRow = q->s0 + q->sy * py, tRow = q->t0 + q->ty * py;
+    const Float4 lane = { 0.5f, 1.5f, 2.5f, 3.5f };
+    for (int x = x0; x < x1; x += 4) {
+        int n = x1 - x < 4 ? x1 - x : 4;
+        Float4 px = lane + (float)x;
+        Float4 s = sRow + q->sx * px;
+        Float4 t = tRow + q->tx * px;
+
+        Float4 r, g, b, a;
+        Sample(q, image, s, t, n, &r, &g, &b, &a);
+        r = Saturate(r * q->tint.x);
+        g = Saturate(g * q->tint.y);
+        b = Saturate(b * q->tint.z);
+
+        UInt4 dst = { 0 };
+        memcpy(&dst, row + x, n * sizeof(uint32_t));
+        Float4 dr, dg, db, da;
+        Unpack(dst, &dr, &dg, &db, &da);
+        Float4 alpha = a * (1.0f / 255.0f);
+        Float4 inverse = 1.0f - alpha;
+        dst = Pack(r * alpha + dr * inverse, g * alpha + dg * inverse, b * alpha + db * inverse, a * alpha + da * inverse);
+        memcpy(row + x, &dst, n * sizeof(uint32_t));
+    }
+}
+
+/**
+ * @brief Narrows [*a, *b) to the pixel centers where f0 + d * x lies in [0, 1).
+ */
+static inline void Clip(float f0, float d, float* a, float* b)
+{
+    if (fabsf(d) < 1e-12f) {
+        if (f0 < 0.0f || f0 >= 1.0f)
+            *b = *a;
+        return;
+    }
+    float e0 = -f0 / d, e1 = (1.0f - f0) / d;
+    if (d < 0.0f) {
+        float swap = e0;
+        e0 = e1;
+        e1 = swap;
+    }
+    *a = fmaxf(*a, e0);
+    *b = fminf(*b, e1);
+}
+
+static void RasterizeTile(CFXSoftRendererRef this, int tile)
+{
+    int left = (tile % this->tilesX) * CFX_SOFT_TILE, top = (tile / this->tilesX) * CFX_SOFT_TILE;
+    int right = left + CFX_SOFT_TILE < this->width ? left + CFX_SOFT_TILE : this->width;
+    int bottom = top + CFX_SOFT_TILE < this->height ? top + CFX_SOFT_TILE : this->height;
+
+    Vec4 c = this->clearColor;
+    uint32_t clear = (uint32_t)(c.x * 255.0f + 0.5f) | (uint32_t)(c.y * 255.0f + 0.5f) << 8
+        | (uint32_t)(c.z * 255.0f + 0.5f) << 16 | (uint32_t)(c.w * 255.0f + 0.5f) << 24;
+    for (int y = top; y < bottom; y++)
+        for (int x = left; x < right; x++)
+            this->pixels[(size_t)y * this->width + x] = clear;
+
+    CFXSoftBin* bin = &this->bins[tile];
+    for (int i = 0; i < bin->count; i++) {
+        const CFXSoftQuad* q = &this->quads[bin->quads[i]];
+        const CFXSoftImage* image = &this->images[q->image];
+        int y0 = Max(q->y0, top), y1 = q->y1 < bottom ? q->y1 : bottom;
+        int x0 = Max(q->x0, left), x1 = q->x1 < right ? q->x1 : right;
+        for (int y = y0; y < y1; y++) {
+            float py = y + 0.5f;
+            float a = x0 + 0.5f, b = x1 + 0.5f;
+            Clip(q->s0 + q->sy * py, q->sx, &a, &b);
+            Clip(q->t0 + q->ty * py, q->tx, &a, &b);
+            if (a >= b)
+                continue;
+            int start = Max((int)ceilf(a - 0.5f), x0);
+            int end = (int)ceilf(b - 0.5f);
+            end = end < x1 ? end : x1;
+            if (start < end)
+                FillSpan(q, image, &this->pixels[(size_t)y * this->width], y, start, end);
+        }
+    }
+}
+
+static void RasterizeTiles(CFXSoftRendererRef this)
+{
+    int tiles = this->tilesX * this->tilesY;
+    for (;;) {
+        int tile = __atomic_fetch_add(&this->nextTile, 1, __ATOMIC_RELAXED);
+        if (tile >= tiles)
+            break;
+        RasterizeTile(this, tile);
+    }
+}
+
+/**
+ * @brief Pool thread: rasterizes tiles of every frame End hands out until the destructor.
+ */
+static void* PoolThread(void* arg)
+{
+    CFXSoftRendererRef this = arg;
+    int seen = 0;
+    pthread_mutex_lock(&this->lock);
+    for (;;) {
+        while (this->generation == seen && !this->stopping)
+            pthread_cond_wait(&this->wake, &this->lock);
+        if (this->stopping)
+            break;
+        seen = this->generation;
+        pthread_mutex_unlock(&this->lock);
+        RasterizeTiles(this);
+        pthread_mutex_lock(&this->lock);
+        if (--this->busy == 0)
+            pthread_cond_signal(&this->done);
+    }
+    pthread_mutex_unlock(&this->lock);
+    return nullptr;
+}
+
+/**
+ * @brief Clears the framebuffer and rasterizes the recorded quads.
+ *
+ * Returns once every tile is done; pixels then holds the frame.
+ *
+ * @param this Reference to the software renderer.
+ */
+proc void End(CFXSoftRendererRef this)
+{
+    this->nextTile = 0;
+    if (this->workerCount == 0) {
+        RasterizeTiles(this);
+        return;
+    }
+    pthread_mutex_lock(&this->lock);
+    this->busy = this->workerCount;
+    this->generation++;
+    pthread_cond_broadcast(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+
+    RasterizeTiles(this);
+
+    pthread_mutex_lock(&this->lock);
+    while (this->busy > 0)
+        pthread_cond_wait(&this->done, &this->lock);
+    pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * @brief Uploads the framebuffer with glTexSubImage2D and draws it over the current viewport.
+ *
+ * @param this Reference to the software renderer.
+ */
+proc void Present(CFXSoftRendererRef this)
+{
+    if (this->texture == nullptr) {
+        this->texture = NewCFXTexture2D(GL_RGBA8, GL_RGBA, "");
+        this->texture->wrapS = GL_CLAMP_TO_EDGE;
+        this->texture->wrapT = GL_CLAMP_TO_EDGE;
+        this->texture->filterMin = GL_NEAREST;
+        this->texture->filterMag = GL_NEAREST;
+        Allocate(this->texture, this->width, this->height, 1);
+        this->shader = (CFXShaderRef)CFCreate(CFXShader);
+        Compile(this->shader, CFX_FULLSCREEN_VERTEX_SOURCE, PresentFragmentSource);
+    }
+    SubImage(this->texture, 0, 0, 0, this->width, this->height, (const unsigned char*)this->pixels);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    Use(this->shader);
+    SetInteger(this->shader, "image", 0);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(this->texture);
+    CFXRenderTarget_DrawFullscreen();
+    if (blend)
+        glEnable(GL_BLEND);
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <pthread.h>
+#include <stdint.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "shader.h"
+#include "texture2d.h"
+#include "tglm.h"
+
+extern CFClassRef CFXSoftRenderer;
+typedef struct __CFXSoftRenderer* CFXSoftRendererRef;
+
+#define CFX_SOFT_TILE 64
+
+/**
+ * @struct CFXSoftImage
+ * @brief CPU copy of a texture's image, rows bottom to top like the GL texture.
+ */
+typedef struct CFXSoftImage {
+    char* path;
+    int width;
+    int height;
+    uint32_t* pixels;
+} CFXSoftImage;
+
+/**
+ * @struct CFXSoftQuad
+ * @brief A recorded quad, set up for rasterization.
+ *
+ * The quad's local coordinates (s, t) in [0, 1) are affine in the pixel
+ * position, s = s0 + sx * x + sy * y and likewise for t, so a row span is
+ * found by clipping both against [0, 1).
+ *
+ * Members:
+ * - s0, sx, sy:  Local s as a function of the pixel center.
+ * - t0, tx, ty:  Local t as a function of the pixel center.
+ * - x0, y0, x1, y1: Pixel bounds, x1 and y1 exclusive.
+ * - uvRect:      Region of the image: offset (x, y) and size (z, w).
+ * - tint:        Color multiplied with the texels.
+ * - image:       Image sampled, index into the renderer's images.
+ * - repeat:      GL_REPEAT wrapping rather than clamping.
+ * - bilinear:    Bilinear rather than nearest filtering.
+ */
+typedef struct CFXSoftQuad {
+    float s0, sx, sy;
+    float t0, tx, ty;
+    int x0, y0, x1, y1;
+    Vec4 uvRect;
+    Vec3 tint;
+    int image;
+    bool repeat;
+    bool bilinear;
+} CFXSoftQuad;
+
+/**
+ * @struct CFXSoftBin
+ * @brief Indices of the quads overlapping one tile, in submission order.
+ */
+typedef struct CFXSoftBin {
+    int* quads;
+    int count;
+    int capacity;
+} CFXSoftBin;
+
+/**
+ * @struct __CFXSoftRenderer
+ * @brief A CPU rasterizer for textured, tinted, rotated quads.
+ *
+ * Draw records a quad and bins it into the CFX_SOFT_TILE square tiles its
+ * bounds touch. End clears and rasterizes the tiles on a pool of threads,
+ * each taking the next unclaimed tile, so no two threads ever write the same
+ * pixel and quads within a tile keep their order. The pool is started by
+ * the constructor and sleeps on a condition variable between frames. Spans are filled four
+ * pixels at a time with compiler vector types, which become SSE, NEON or
+ * WebAssembly SIMD instructions depending on the target.
+ *
+ * Quads follow CFXArrayRenderer: a unit quad scaled to size, rotated about
+ * its center and moved to position, with uv running along the quad's x and
+ * y in pixel space. Textures are sampled as GL would, honoring their wrap
+ * mode and their nearest or linear filter, and blended with GL_SRC_ALPHA,
+ * GL_ONE_MINUS_SRC_ALPHA. Their images are read once from the texture's
+ * path; textures without one sample as white.
+ *
+ * The framebuffer is RGBA8, rows top to bottom. Present shows it through a
+ * texture updated with glTexSubImage2D; headless users read pixels after End.
+ *
+ * Members:
+ * - obj:          Base object information for the software renderer.
+ * - width, height: Framebuffer size in pixels.
+ * - pixels:       The framebuffer.
+ * - clearColor:   Color End clears to.
+ * - threads:      Threads rasterizing, including the caller.
+ * - tilesX, tilesY: Tiles across and down.
+ * - bins:         Per tile: quads to rasterize.
+ * - quads:        Quads recorded since Begin.
+ * - quadCount:    Number of quads.
+ * - quadCapacity: Allocated size of quads.
+ * - images:       CPU images, loaded on first use.
+ * - imageCount:   Number of images.
+ * - nextTile:     Next tile to claim during End.
+ * - workers:      Pool threads; the caller of End is the last rasterizer.
+ * - workerCount:  Number of pool threads started.
+ * - generation:   Frames handed to the pool, for the workers to spot a new one.
+ * - busy:         Pool threads still rasterizing the current frame.
+ * - stopping:     Set by the destructor to end the pool threads.
+ * - lock, wake, done: Pool synchronization.
+ * - texture:      Texture Present uploads to; created on first use.
+ * - shader:       Shader Present draws with.
+ */
+typedef struct __CFXSoftRenderer {
+    __CFObject obj;
+    int width;
+    int height;
+    uint32_t* pixels;
+    Vec4 clearColor;
+    int threads;
+    int tilesX;
+    int tilesY;
+    CFXSoftBin* bins;
+    CFXSoftQuad* quads;
+    int quadCount;
+    int quadCapacity;
+    CFXSoftImage* images;
+    int imageCount;
+    int nextTile;
+    pthread_t* workers;
+    int workerCount;
+    int generation;
+    int busy;
+    bool stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    CFXTexture2DRef texture;
+    CFXShaderRef shader;
+} __CFXSoftRenderer;
+
+extern proc void* Ctor(
+    CFXSoftRendererRef this,
+    int width,
+    int height,
+    int threads);
+
+extern proc void Begin(
+    CFXSoftRendererRef this,
+    Vec4 clearColor);
+
+extern proc void Draw(
+    CFXSoftRendererRef this,
+    CFXTexture2DRef texture,
+    Vec2 position,
+    Vec2 size,
+    GLfloat rotate,
+    Vec3 color,
+    Vec4 uvRect);
+
+extern proc void End(
+    CFXSoftRendererRef this);
+
+extern proc void Present(
+    CFXSoftRendererRef this);
+
+/**
+ * @brief Creates a new CFXSoftRenderer.
+ *
+ * @param width    Framebuffer width in pixels.
+ * @param height   Framebuffer height in pixels.
+ * @param threads  Rasterizer threads; 0 uses one per core.
+ * @return A reference to the newly created CFXSoftRenderer.
+ */
+static inline CFXSoftRendererRef NewCFXSoftRenderer(int width, int height, int threads)
+{
+    return Ctor((CFXSoftRendererRef)CFCreate(CFXSoftRenderer), width, height, threads);
+}
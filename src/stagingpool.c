@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "stagingpool.h"
+
+class2(CFXStagingPool);
+
+/**
+ * @brief Destructor for the CFXStagingPool object.
+ *
+ * Buffers still lent out are released with the pool; their owner must not
+ * use them afterwards.
+ *
+ * @param self Pointer to the CFXStagingPool instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXStagingPoolRef this = self;
+    for (int i = 0; i < this->count; i++) {
+        CFXStagingBuffer* buffer = this->buffers[i];
+        if (buffer->mapped != nullptr) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer->Id);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        if (buffer->fence != nullptr)
+            glDeleteSync(buffer->fence);
+        CFXDeletionQueue_Buffers(1, &buffer->Id);
+        free(buffer);
+    }
+    free(this->buffers);
+}
+
+/**
+ * @brief Constructor for the CFXStagingPool object.
+ *
+ * @param this   Pointer to the CFXStagingPool instance to initialize.
+ * @param limit  Most bytes of staging memory the pool may hold.
+ * @return       Pointer to the initialized CFXStagingPool instance.
+ */
+proc void* Ctor(CFXStagingPoolRef this, GLsizeiptr limit)
+{
+    CFXStagingPool->dtor = dtor;
+    this->buffers = nullptr;
+    this->count = 0;
+    this->bytes = 0;
+    this->limit = limit;
+    return this;
+}
+
+/**
+ * @brief Reports whether a buffer can be lent out, retiring its fence once signaled.
+ */
+static bool IsIdle(CFXStagingBuffer* buffer)
+{
+    if (buffer->inUse)
+        return false;
+    if (buffer->fence != nullptr) {
+        if (glClientWaitSync(buffer->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(buffer->fence);
+        buffer->fence = nullptr;
+    }
+    return true;
+}
+
+static void Remove(CFXStagingPoolRef this, int index)
+{
+    CFXStagingBuffer* buffer = this->buffers[index];
+    this->bytes -= buffer->capacity;
+    CFXDeletionQueue_Buffers(1, &buffer->Id);
+    free(buffer);
+    this->buffers[index] = this->buffers[--this->count];
+}
+
+/**
+ * @brief Lends out an idle buffer of at least size bytes, mapped for writing.
+ *
+ * Call on the GL thread. The smallest idle buffer that fits is reused;
+ * otherwise a new one is created if the pool has room, after deleting idle
+ * buffers too small to matter.
+ *
+ * @param this  Reference to the staging pool.
+ * @param size  Bytes needed.
+ * @return      The mapped buffer, or nullptr if none is free yet.
+ */
+proc CFXStagingBuffer* Acquire(CFXStagingPoolRef this, GLsizeiptr size)
+{
+    CFXStagingBuffer* best = nullptr;
+    for (int i = 0; i < this->count; i++) {
+        CFXStagingBuffer* buffer = this->buffers[i];
+        if (buffer->capacity >= size && IsIdle(buffer) && (best == nullptr || buffer->capacity < best->capacity))
+            best = buffer;
+    }
+
+    if (best == nullptr) {
+        GLsizeiptr capacity = 64 * 1024;
+        while (capacity < size)
+            capacity *= 2;
+        for (int i = this->count - 1; i >= 0 && this->bytes + capacity > this->limit; i--)
+            if (IsIdle(this->buffers[i]))
+                Remove(this, i);
+        // An upload larger than the whole pool still gets a buffer once the pool is empty
+        if (this->bytes + capacity > this->limit && this->count > 0)
+            return nullptr;
+
+        best = calloc(1, sizeof(CFXStagingBuffer));
+        best->capacity = capacity;
+        glGenBuffers(1, &best->Id);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, best->Id);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        this->buffers = realloc(this->buffers, (this->count + 1) * sizeof(CFXStagingBuffer*));
+        this->buffers[this->count++] = best;
+        this->bytes += capacity;
+    } else
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, best->Id);
+
+    // The fence has signaled, so nothing can still be reading the buffer. Emscripten
+    // emulates mapping with a heap copy sent at unmap and rejects the unsynchronized bit.
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+#if !__EMSCRIPTEN__
+    access |= GL_MAP_UNSYNCHRONIZED_BIT;
+#endif
+    best->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (best->mapped == nullptr) {
+        printf("| ERROR::STAGINGPOOL: Failed to map a %ld byte staging buffer\n", (long)size);
+        return nullptr;
+    }
+    best->inUse = true;
+    return best;
+}
+
+/**
+ * @brief Unmaps a buffer once its contents are written, ready for uploads from it.
+ *
+ * Call on the GL thread, after every write through the mapped pointer.
+ *
+ * @param this    Reference to the staging pool.
+ * @param buffer  A buffer from Acquire.
+ */
+proc void Unmap(CFXStagingPoolRef this, CFXStagingBuffer* buffer)
+{
+    if (buffer->mapped == nullptr)
+        return;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer->Id);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    buffer->mapped = nullptr;
+}
+
+/**
+ * @brief Returns a buffer to the pool after the last upload from it has been issued.
+ *
+ * The buffer is fenced and lent out again once the GPU has read it.
+ *
+ * @param this    Reference to the staging pool.
+ * @param buffer  A buffer from Acquire.
+ */
+proc void Release(CFXStagingPoolRef this, CFXStagingBuffer* buffer)
+{
+    Unmap(this, buffer);
+    buffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer->inUse = false;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+
+extern CFClassRef CFXStagingPool;
+typedef struct __CFXStagingPool* CFXStagingPoolRef;
+
+/**
+ * @struct CFXStagingBuffer
+ * @brief A pixel unpack buffer lent out by a staging pool.
+ *
+ * Members:
+ * - Id:       OpenGL buffer name.
+ * - capacity: Size of the buffer in bytes.
+ * - mapped:   Write pointer while mapped, else nullptr. Any thread may write
+ *             through it; only the GL thread maps and unmaps.
+ * - fence:    Signals when the GPU has read the last uploads from the buffer.
+ * - inUse:    Lent out and not yet released.
+ */
+typedef struct CFXStagingBuffer {
+    GLuint Id;
+    GLsizeiptr capacity;
+    void* mapped;
+    GLsync fence;
+    bool inUse;
+} CFXStagingBuffer;
+
+/**
+ * @struct __CFXStagingPool
+ * @brief A reusable pool of GL_PIXEL_UNPACK_BUFFER staging memory.
+ *
+ * Texture data written into a mapped staging buffer reaches the texture by
+ * glTexSubImage2D with an offset into the bound buffer, so the driver
+ * copies from its own memory when the GPU gets to it rather than from
+ * client memory during the call. A released buffer is fenced after its
+ * uploads and lent out again once the fence has signaled, so it is mapped
+ * unsynchronized and never stalls on the GPU.
+ *
+ * Buffers are rounded up to a power of two and kept for reuse, up to a
+ * total of limit bytes; past that, Acquire deletes idle buffers that are
+ * too small, or fails until some are released.
+ *
+ * Members:
+ * - obj:      Base object information for the staging pool.
+ * - buffers:  Buffers in the pool; pointers to them stay valid.
+ * - count:    Number of buffers.
+ * - bytes:    Total capacity of the buffers.
+ * - limit:    Most bytes the pool may hold.
+ */
+typedef struct __CFXStagingPool {
+    __CFObject obj;
+    CFXStagingBuffer** buffers;
+    int count;
+    GLsizeiptr bytes;
+    GLsizeiptr limit;
+} __CFXStagingPool;
+
+extern proc void* Ctor(
+    CFXStagingPoolRef this,
+    GLsizeiptr limit);
+
+extern proc CFXStagingBuffer* Acquire(
+    CFXStagingPoolRef this,
+    GLsizeiptr size);
+
+extern proc void Unmap(
+    CFXStagingPoolRef this,
+    CFXStagingBuffer* buffer);
+
+extern proc void Release(
+    CFXStagingPoolRef this,
+    CFXStagingBuffer* buffer);
+
+/**
+ * @brief Creates a new CFXStagingPool.
+ *
+ * @param limit  Most bytes of staging memory the pool may hold.
+ * @return A reference to the newly created CFXStagingPool.
+ */
+static inline CFXStagingPoolRef NewCFXStagingPool(GLsizeiptr limit)
+{
+    return Ctor((CFXStagingPoolRef)CFCreate(CFXStagingPool), limit);
+}
@@ -1,12 +1,14 @@
+#include <string.h>
 #include <emscripten.h>
 #define GL_GLEXT_PROTOTYPES
 #define EGL_EGLEXT_PROTOTYPES
 #include <corefw.h>    // IWYU pragma: keep
 #include "stb_image.h"
 #include <GLFW/glfw3.h>
+#include "deletionqueue.h"
 #include "texture2d.h"
 
-class(CFXTexture2D);
+class2(CFXTexture2D);
 
 /**
  * @brief Constructor for the CFXTexture2D object.
@@ -24,6 +26,7 @@ class(CFXTexture2D);
 proc void* Ctor(CFXTexture2DRef this, GLuint internalFormat, GLuint imageFormat, char* path)
 {
     // CFXTexture2DRef this = CFNew((CFClassRef)CFXTexture2D);
+    CFXTexture2D->dtor = dtor;
     this->path = CFStrDup(path);
     this->Width = 0;
     this->Height = 0;
@@ -37,6 +40,20 @@ proc void* Ctor(CFXTexture2DRef this, GLuint internalFormat, GLuint imageFormat,
     return this;
 }
 
+/**
+ * @brief Destructor for the CFXTexture2D object.
+ *
+ * Queues the texture name for deletion once the GPU is done with it.
+ *
+ * @param self Pointer to the CFXTexture2D instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXTexture2DRef this = self;
+    CFXDeletionQueue_Textures(1, &this->Id);
+    free(this->path);
+}
+
 /**
  * @brief Generates and configures a 2D texture object.
  *
@@ -69,6 +86,122 @@ proc void Generate(
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+/**
+ * @brief Reports whether glTexStorage2D is available: GL 4.2, ARB_texture_storage or WebGL 2.
+ */
+static bool TexStorage(void)
+{
+#if __EMSCRIPTEN__
+    return true;
+#else
+    static int supported = -1;
+    if (supported < 0) {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        supported = major > 4 || (major == 4 && minor >= 2);
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions && !supported; i++)
+            if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), "GL_ARB_texture_storage") == 0)
+                supported = 1;
+    }
+    return supported;
+#endif
+}
+
+/**
+ * @brief Allocates storage for a texture and its mip levels without uploading data.
+ *
+ * InternalFormat must be a sized format such as GL_RGBA8. Fill the levels
+ * afterwards with SubImage. The storage is immutable where glTexStorage2D is
+ * available; elsewhere each level is specified with glTexImage2D and no
+ * data, and GL_TEXTURE_MAX_LEVEL keeps the texture complete.
+ *
+ * @param this   Reference to the texture object.
+ * @param width  Width of level 0 in pixels.
+ * @param height Height of level 0 in pixels.
+ * @param levels Number of mip levels to allocate.
+ */
+proc void Allocate(
+    CFXTexture2DRef this,
+    GLuint width,
+    GLuint height,
+    GLsizei levels)
+{
+    this->Width = width;
+    this->Height = height;
+    glBindTexture(GL_TEXTURE_2D, this->Id);
+    if (TexStorage())
+        glTexStorage2D(GL_TEXTURE_2D, levels, this->InternalFormat, width, height);
+    else {
+        for (GLsizei level = 0; level < levels; level++)
+            glTexImage2D(GL_TEXTURE_2D, level, this->InternalFormat, Max((GLint)width >> level, 1),
+                Max((GLint)height >> level, 1), 0, this->ImageFormat, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->filterMin);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->filterMag);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * @brief Replaces a rectangle of one mip level with pixel data in ImageFormat.
+ *
+ * @param this   Reference to the texture object.
+ * @param level  Mip level to update.
+ * @param x      Left edge of the rectangle in pixels.
+ * @param y      Top edge of the rectangle in pixels.
+ * @param width  Width of the rectangle in pixels.
+ * @param height Height of the rectangle in pixels.
+ * @param data   Tightly packed rows of the rectangle.
+ */
+proc void SubImage(
+    CFXTexture2DRef this,
+    GLint level,
+    GLint x,
+    GLint y,
+    GLsizei width,
+    GLsizei height,
+    const unsigned char* data)
+{
+    glBindTexture(GL_TEXTURE_2D, this->Id);
+    glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, this->ImageFormat, GL_UNSIGNED_BYTE, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * @brief Replaces a rectangle of one mip level from a pixel unpack buffer.
+ *
+ * The driver reads the rows from buffer when the GPU executes the upload,
+ * so the call returns without copying them; see CFXStagingPool.
+ *
+ * @param this   Reference to the texture object.
+ * @param level  Mip level to update.
+ * @param x      Left edge of the rectangle in pixels.
+ * @param y      Top edge of the rectangle in pixels.
+ * @param width  Width of the rectangle in pixels.
+ * @param height Height of the rectangle in pixels.
+ * @param buffer GL_PIXEL_UNPACK_BUFFER holding tightly packed rows.
+ * @param offset Byte offset of the first row in buffer.
+ */
+proc void SubImage(
+    CFXTexture2DRef this,
+    GLint level,
+    GLint x,
+    GLint y,
+    GLsizei width,
+    GLsizei height,
+    GLuint buffer,
+    GLintptr offset)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    SubImage(this, level, x, y, width, height, (const unsigned char*)offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
 proc void Bind(const CFXTexture2DRef this)
 {
     glBindTexture(GL_TEXTURE_2D, this->Id);
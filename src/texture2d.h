@@ -53,6 +53,31 @@ extern proc void Generate(
     GLuint height,
     unsigned char* data);
 
+extern proc void Allocate(
+    CFXTexture2DRef this,
+    GLuint width,
+    GLuint height,
+    GLsizei levels);
+
+extern proc void SubImage(
+    CFXTexture2DRef this,
+    GLint level,
+    GLint x,
+    GLint y,
+    GLsizei width,
+    GLsizei height,
+    const unsigned char* data);
+
+extern proc void SubImage(
+    CFXTexture2DRef this,
+    GLint level,
+    GLint x,
+    GLint y,
+    GLsizei width,
+    GLsizei height,
+    GLuint buffer,
+    GLintptr offset);
+
 extern proc void Bind(
     const CFXTexture2DRef this);
 
@@ -0,0 +1,559 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+#include "textureloader.h"
+
+class2(CFXTextureLoader);
+
+constexpr int MaxThreads = 16;
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define CFX_TEXTURE_LOADER_THREADS 0
+#else
+#define CFX_TEXTURE_LOADER_THREADS 1
+#endif
+
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void Push(CFXTextureQueue* queue, CFXTextureJob* job)
+{
+    job->next = nullptr;
+    if (queue->tail != nullptr)
+        queue->tail->next = job;
+    else
+        queue->head = job;
+    queue->tail = job;
+}
+
+static CFXTextureJob* Pop(CFXTextureQueue* queue)
+{
+    CFXTextureJob* job = queue->head;
+    if (job != nullptr) {
+        queue->head = job->next;
+        if (queue->head == nullptr)
+            queue->tail = nullptr;
+    }
+    return job;
+}
+
+static void FreeJob(CFXTextureJob* job)
+{
+    CFUnref(job->texture);
+    if (job->Id != 0)
+        CFXDeletionQueue_Textures(1, &job->Id);
+    if (job->pack != nullptr)
+        CFUnref(job->pack);
+    stbi_image_free(job->pixels);
+    free(job->path);
+    free(job);
+}
+
+/**
+ * @brief Decodes a job's image; safe on any thread.
+ */
+static void Decode(CFXTextureJob* job)
+{
+    int channels;
+    int format = job->alpha ? STBI_rgb_alpha : STBI_rgb;
+#if CFX_TEXTURE_LOADER_THREADS
+    // The global flip flag is not thread safe; this one is per thread
+    stbi_set_flip_vertically_on_load_thread(true);
+#else
+    // On the main thread a per-thread flag, once set, would override the
+    // global one for every later stbi_load there, so set the global one as
+    // the other loaders do
+    stbi_set_flip_vertically_on_load(true);
+#endif
+    CFXEmbeddedFile packed;
+    const CFXEmbeddedFile* embedded = job->pack != nullptr && Find(job->pack, job->path, &packed)
+        ? &packed
+        : CFXEmbedded_Find(job->path);
+    job->pixels = embedded != nullptr
+        ? stbi_load_from_memory(embedded->data, (int)embedded->size, &job->width, &job->height, &channels, format)
+        : stbi_load(job->path, &job->width, &job->height, &channels, format);
+    if (job->pixels == nullptr)
+        printf("| ERROR::TEXTURELOADER: Failed to decode %s: %s\n", job->path, stbi_failure_reason());
+}
+
+static int BytesPerPixel(CFXTextureJob* job)
+{
+    return job->alpha ? 4 : 3;
+}
+
+/**
+ * @brief Copies a job's decoded pixels into its mapped staging buffer; safe on any thread.
+ */
+static void Copy(CFXTextureJob* job)
+{
+    memcpy(job->staging->mapped, job->pixels, (size_t)job->width * job->height * BytesPerPixel(job));
+    stbi_image_free(job->pixels);
+    job->pixels = nullptr;
+}
+
+/**
+ * @brief Number of pieces a job's copy into staging is split into.
+ */
+static uint32_t Blocks(CFXTextureJob* job)
+{
+    return job->entry != nullptr ? CFXPack_BlockCount(job->entry) : 1;
+}
+
+/**
+ * @brief Fills one piece of a job's staging buffer; safe on any thread.
+ *
+ * @return false if the pack's block was corrupt.
+ */
+static bool CopyBlock(CFXTextureJob* job, uint32_t block)
+{
+    if (job->entry != nullptr)
+        return Unpack(job->pack, job->entry, block, job->staging->mapped);
+    Copy(job);
+    return true;
+}
+
+static void Complete(CFXTextureLoaderRef this, CFXTextureJob* job, bool loaded);
+
+/**
+ * @brief Creates the job's own texture name with the texture's format and sampling.
+ *
+ * @param pixels  Image to upload, or nullptr to leave it for SubImage.
+ */
+static void CreateTexture(CFXTextureJob* job, const unsigned char* pixels)
+{
+    CFXTexture2DRef texture = job->texture;
+    glGenTextures(1, &job->Id);
+    glBindTexture(GL_TEXTURE_2D, job->Id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, texture->InternalFormat, job->width, job->height, 0, texture->ImageFormat, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture->wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture->wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture->filterMin);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture->filterMag);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * @brief Swaps the job's finished texture name in for the placeholder's, which is queued for deletion.
+ */
+static void SwapTexture(CFXTextureJob* job)
+{
+    CFXTexture2DRef texture = job->texture;
+    CFXDeletionQueue_Textures(1, &texture->Id);
+    texture->Id = job->Id;
+    texture->Width = job->width;
+    texture->Height = job->height;
+    job->Id = 0;
+}
+
+/**
+ * @brief Uploads a decoded image into a new texture on the loader thread.
+ */
+static void RunUpload(void* context)
+{
+    CFXTextureJob* job = context;
+    CreateTexture(job, job->pixels);
+    stbi_image_free(job->pixels);
+    job->pixels = nullptr;
+}
+
+/**
+ * @brief Swaps the uploaded texture in for the placeholder on the render thread.
+ */
+static void PublishUpload(void* context)
+{
+    CFXTextureJob* job = context;
+    SwapTexture(job);
+    Complete(job->owner, job, true);
+}
+
+#if CFX_TEXTURE_LOADER_THREADS
+static void* Worker(void* self)
+{
+    CFXTextureLoaderRef this = self;
+    pthread_mutex_lock(&this->lock);
+    while (true) {
+        while (this->queued.head == nullptr && this->copying.head == nullptr && !this->stopping)
+            pthread_cond_wait(&this->wake, &this->lock);
+        if (this->stopping)
+            break;
+        // Copies first: they hold staging memory and are nearer done
+        CFXTextureJob* job = this->copying.head;
+        if (job != nullptr) {
+            // The job leaves copying once its last block is claimed
+            uint32_t block = job->nextBlock++;
+            if (job->nextBlock == Blocks(job))
+                Pop(&this->copying);
+            pthread_mutex_unlock(&this->lock);
+            bool copied = CopyBlock(job, block);
+            pthread_mutex_lock(&this->lock);
+            job->failed = job->failed || !copied;
+            if (++job->blocksDone == Blocks(job))
+                Push(&this->copied, job);
+            continue;
+        }
+        job = Pop(&this->queued);
+        pthread_mutex_unlock(&this->lock);
+        Decode(job);
+        pthread_mutex_lock(&this->lock);
+        if (this->context == nullptr || job->pixels == nullptr || this->stopping) {
+            Push(&this->decoded, job);
+            continue;
+        }
+        // Posted outside the lock, as publishing takes it; SetLoaderContext
+        // waits on posting so it cannot swap the context out from under us
+        CFXLoaderContextRef context = this->context;
+        this->posting++;
+        pthread_mutex_unlock(&this->lock);
+        Post(context, RunUpload, PublishUpload, job);
+        pthread_mutex_lock(&this->lock);
+        if (--this->posting == 0)
+            pthread_cond_broadcast(&this->posted);
+    }
+    pthread_mutex_unlock(&this->lock);
+    return nullptr;
+}
+#endif
+
+/**
+ * @brief Destructor for the CFXTextureLoader object.
+ *
+ * Stops the workers, waiting for the images they are working on, and
+ * drops the jobs still queued; their textures keep the placeholder. The
+ * staging pool goes with the loader.
+ *
+ * @param self Pointer to the CFXTextureLoader instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXTextureLoaderRef this = self;
+    pthread_mutex_lock(&this->lock);
+    this->stopping = true;
+    pthread_cond_broadcast(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+    for (int i = 0; i < this->workerCount; i++)
+        pthread_join(this->workers[i], nullptr);
+    free(this->workers);
+    if (this->context != nullptr) {
+        // Tasks posted by the workers point back here
+        Finish(this->context);
+        CFUnref(this->context);
+    }
+
+    CFXTextureQueue* queues[] = { &this->queued, &this->decoded, &this->copying, &this->copied };
+    for (int i = 0; i < 4; i++) {
+        CFXTextureJob* job;
+        while ((job = Pop(queues[i])) != nullptr)
+            FreeJob(job);
+    }
+    CFUnref(this->staging);
+    pthread_cond_destroy(&this->posted);
+    pthread_cond_destroy(&this->wake);
+    pthread_mutex_destroy(&this->lock);
+}
+
+/**
+ * @brief Constructor for the CFXTextureLoader object.
+ *
+ * @param this     Pointer to the CFXTextureLoader instance to initialize.
+ * @param threads  Decoding threads; 0 uses one per core, less the GL thread's.
+ * @return         Pointer to the initialized CFXTextureLoader instance.
+ */
+proc void* Ctor(CFXTextureLoaderRef this, int threads)
+{
+    CFXTextureLoader->dtor = dtor;
+    pthread_mutex_init(&this->lock, nullptr);
+    pthread_cond_init(&this->wake, nullptr);
+    pthread_cond_init(&this->posted, nullptr);
+    this->queued = (CFXTextureQueue) {};
+    this->decoded = (CFXTextureQueue) {};
+    this->copying = (CFXTextureQueue) {};
+    this->copied = (CFXTextureQueue) {};
+    this->staging = NewCFXStagingPool(CFX_TEXTURE_STAGING_BYTES);
+    this->context = nullptr;
+    this->pending = 0;
+    this->posting = 0;
+    this->stopping = false;
+    this->workers = nullptr;
+    this->workerCount = 0;
+
+#if CFX_TEXTURE_LOADER_THREADS
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    threads = threads < 1 ? 1 : threads > MaxThreads ? MaxThreads : threads;
+    this->workers = malloc(threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; i++)
+        if (pthread_create(&this->workers[this->workerCount], nullptr, Worker, this) == 0)
+            this->workerCount++;
+#endif
+    return this;
+}
+
+/**
+ * @brief Returns a texture at once and loads its image in the background.
+ *
+ * The texture holds a transparent 1 x 1 placeholder until a later Upload
+ * fills it, and is safe to draw with in the meantime. Call on the GL thread.
+ *
+ * @param this      Reference to the texture loader.
+ * @param file      Image file, or the name of an embedded one.
+ * @param alpha     Load with an alpha channel (RGBA) rather than RGB.
+ * @param callback  Called on the GL thread after the upload, or nullptr.
+ * @param context   Passed to callback.
+ * @return          The texture, owned by the caller.
+ */
+proc CFXTexture2DRef Load(
+    CFXTextureLoaderRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    CFXTextureLoadedProc callback,
+    void* context)
+{
+    return Load(this, (CFXAssetPackRef)nullptr, file, alpha, callback, context);
+}
+
+/**
+ * @brief Returns a texture at once and decodes its image from an asset pack in the background.
+ *
+ * As Load, with the image read in place from pack, which is kept
+ * referenced until the image is uploaded. An image the pack holds decoded
+ * is not decoded again: its blocks are unpacked into the staging buffer
+ * in parallel.
+ *
+ * @param pack  Asset pack holding file, or nullptr to read the file.
+ */
+proc CFXTexture2DRef Load(
+    CFXTextureLoaderRef this,
+    CFXAssetPackRef pack,
+    const GLchar* file,
+    GLboolean alpha,
+    CFXTextureLoadedProc callback,
+    void* context)
+{
+    int format = alpha ? GL_RGBA : GL_RGB;
+    CFXTexture2DRef texture = Ctor((CFXTexture2DRef)CFCreate(CFXTexture2D), format, format, (char*)file);
+    unsigned char placeholder[4] = { 0, 0, 0, 0 };
+    Generate(texture, 1, 1, placeholder);
+
+    CFXTextureJob* job = calloc(1, sizeof(CFXTextureJob));
+    job->texture = CFRef(texture);
+    job->path = CFStrDup((char*)file);
+    job->pack = pack != nullptr ? CFRef(pack) : nullptr;
+    job->alpha = alpha;
+    job->owner = this;
+    job->callback = callback;
+    job->context = context;
+
+    // Decoded images go straight to staging; a channel mismatch fails in Upload
+    const CFXPackEntry* entry = pack != nullptr ? Lookup(pack, file) : nullptr;
+    bool image = entry != nullptr && (entry->flags & CFX_PACK_IMAGE);
+    if (image && entry->channels == (uint32_t)BytesPerPixel(job)) {
+        job->entry = entry;
+        job->width = (int)entry->width;
+        job->height = (int)entry->height;
+    } else if (image) {
+        printf("| ERROR::TEXTURELOADER: %s is packed with %u channels\n", file, entry->channels);
+    }
+
+    pthread_mutex_lock(&this->lock);
+    Push(image ? &this->decoded : &this->queued, job);
+    this->pending++;
+    pthread_cond_signal(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+    return texture;
+}
+
+/**
+ * @brief Finishes a job: calls back and drops it.
+ */
+static void Complete(CFXTextureLoaderRef this, CFXTextureJob* job, bool loaded)
+{
+    if (job->callback != nullptr)
+        job->callback(job->context, job->texture, loaded);
+    FreeJob(job);
+    pthread_mutex_lock(&this->lock);
+    this->pending--;
+    pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * @brief Uploads the next band of the oldest staged image.
+ *
+ * Bands go into a texture name of the job's own, so the texture keeps
+ * showing its placeholder while they land over several frames; the names
+ * are swapped once the last band is in.
+ *
+ * @return Bytes uploaded.
+ */
+static GLsizeiptr UploadBand(CFXTextureLoaderRef this, CFXTextureJob* job)
+{
+    int stride = job->width * BytesPerPixel(job);
+    if (job->rows == 0) {
+        Unmap(this->staging, job->staging);
+        CreateTexture(job, nullptr);
+    }
+    int rows = Max(CFX_TEXTURE_BAND_BYTES / stride, 1);
+    if (rows > job->height - job->rows)
+        rows = job->height - job->rows;
+    // Rows of RGB images are not 4-byte aligned in general
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job->staging->Id);
+    glBindTexture(GL_TEXTURE_2D, job->Id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job->rows, job->width, rows, job->texture->ImageFormat, GL_UNSIGNED_BYTE,
+        (const void*)((GLintptr)job->rows * stride));
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    job->rows += rows;
+    if (job->rows == job->height) {
+        Release(this->staging, job->staging);
+        SwapTexture(job);
+    }
+    return (GLsizeiptr)rows * stride;
+}
+
+/**
+ * @brief Moves decoded images along their upload phases until the budget is spent.
+ *
+ * Call once a frame on the GL thread; CFXGame::Tick does so for the
+ * resource manager it is given. Staged images are uploaded first, up to
+ * CFX_TEXTURE_FRAME_BYTES since the GPU's share of the work does not show
+ * in the time spent here, then decoded images are given staging buffers
+ * for the workers to fill. At least one step is taken per call, so
+ * loading always progresses.
+ *
+ * @param this    Reference to the texture loader.
+ * @param budget  Seconds the call may spend.
+ * @return        Number of textures completed.
+ */
+proc int Upload(CFXTextureLoaderRef this, double budget)
+{
+    double start = Now();
+    int completed = 0;
+    GLsizeiptr uploaded = 0;
+    do {
+        pthread_mutex_lock(&this->lock);
+        CFXTextureJob* job = this->copied.head;
+        pthread_mutex_unlock(&this->lock);
+        if (job != nullptr && job->failed) {
+            pthread_mutex_lock(&this->lock);
+            Pop(&this->copied);
+            pthread_mutex_unlock(&this->lock);
+            Unmap(this->staging, job->staging);
+            Release(this->staging, job->staging);
+            printf("| ERROR::TEXTURELOADER: Corrupt image %s in %s\n", job->path, job->pack->path);
+            Complete(this, job, false);
+            completed++;
+            continue;
+        }
+        if (job != nullptr && uploaded < CFX_TEXTURE_FRAME_BYTES) {
+            // Only this thread pops copied, so the head stays put while unlocked
+            uploaded += UploadBand(this, job);
+            if (job->rows == job->height) {
+                pthread_mutex_lock(&this->lock);
+                Pop(&this->copied);
+                pthread_mutex_unlock(&this->lock);
+                Complete(this, job, true);
+                completed++;
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&this->lock);
+        job = Pop(&this->decoded);
+#if !CFX_TEXTURE_LOADER_THREADS
+        if (job == nullptr)
+            job = Pop(&this->queued);
+#endif
+        pthread_mutex_unlock(&this->lock);
+        if (job == nullptr)
+            break;
+#if !CFX_TEXTURE_LOADER_THREADS
+        if (job->pixels == nullptr && job->entry == nullptr)
+            Decode(job);
+#endif
+        if (job->pixels == nullptr && job->entry == nullptr) {
+            Complete(this, job, false);
+            completed++;
+            continue;
+        }
+        job->staging = Acquire(this->staging, (GLsizeiptr)job->width * job->height * BytesPerPixel(job));
+        pthread_mutex_lock(&this->lock);
+        if (job->staging == nullptr) {
+            // Out of staging memory until the GPU releases some; retry next frame
+            job->next = this->decoded.head;
+            this->decoded.head = job;
+            if (this->decoded.tail == nullptr)
+                this->decoded.tail = job;
+            pthread_mutex_unlock(&this->lock);
+            break;
+        }
+#if CFX_TEXTURE_LOADER_THREADS
+        Push(&this->copying, job);
+        if (Blocks(job) > 1)
+            pthread_cond_broadcast(&this->wake);
+        else
+            pthread_cond_signal(&this->wake);
+        pthread_mutex_unlock(&this->lock);
+#else
+        pthread_mutex_unlock(&this->lock);
+        for (uint32_t i = 0; i < Blocks(job); i++)
+            job->failed = !CopyBlock(job, i) || job->failed;
+        pthread_mutex_lock(&this->lock);
+        Push(&this->copied, job);
+        pthread_mutex_unlock(&this->lock);
+#endif
+    } while (Now() - start < budget);
+    return completed;
+}
+
+/**
+ * @brief Returns the number of textures loaded but not yet uploaded.
+ *
+ * @param this Reference to the texture loader.
+ * @return     Textures still loading; 0 once everything has arrived.
+ */
+proc int Pending(CFXTextureLoaderRef this)
+{
+    pthread_mutex_lock(&this->lock);
+    int pending = this->pending;
+    pthread_mutex_unlock(&this->lock);
+    return pending;
+}
+
+/**
+ * @brief Has a loader context upload decoded images from now on.
+ *
+ * @param this     Reference to the texture loader.
+ * @param context  Loader context, or nullptr to upload in Upload.
+ */
+proc void SetLoaderContext(CFXTextureLoaderRef this, CFXLoaderContextRef context)
+{
+    if (context != nullptr)
+        CFRef(context);
+    pthread_mutex_lock(&this->lock);
+    CFXLoaderContextRef previous = this->context;
+    this->context = context;
+    while (this->posting > 0)
+        pthread_cond_wait(&this->posted, &this->lock);
+    pthread_mutex_unlock(&this->lock);
+    if (previous != nullptr) {
+        Finish(previous);
+        CFUnref(previous);
+    }
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <pthread.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "assetpack.h"
+#include "loadercontext.h"
+#include "stagingpool.h"
+#include "texture2d.h"
+
+extern CFClassRef CFXTextureLoader;
+
+/**
+ * Most bytes of one glTexSubImage2D band, most bytes uploaded per frame,
+ * and the staging pool's budget.
+ */
+#define CFX_TEXTURE_BAND_BYTES (4 * 1024 * 1024)
+#define CFX_TEXTURE_FRAME_BYTES (8 * 1024 * 1024)
+#define CFX_TEXTURE_STAGING_BYTES (64 * 1024 * 1024)
+typedef struct __CFXTextureLoader* CFXTextureLoaderRef;
+
+/**
+ * @brief Called on the GL thread once a texture loaded by LoadTextureAsync is uploaded.
+ *
+ * @param context  The context passed to LoadTextureAsync.
+ * @param texture  The texture, now holding the image.
+ * @param loaded   false if the image could not be decoded; the texture keeps its placeholder.
+ */
+typedef void (*CFXTextureLoadedProc)(void* context, CFXTexture2DRef texture, bool loaded);
+
+/**
+ * @struct CFXTextureJob
+ * @brief One texture on its way from file to GPU.
+ *
+ * Members:
+ * - texture:  Texture to fill; the loader holds a reference until it is uploaded.
+ * - path:     Image file, or its name in pack.
+ * - pack:     Asset pack holding the image, or nullptr to read the file.
+ * - entry:    Decoded image in pack, copied or decompressed by blocks; else nullptr.
+ * - nextBlock: Next block of entry for a worker to claim.
+ * - blocksDone: Blocks of entry in the staging buffer.
+ * - failed:   A block of entry was corrupt.
+ * - alpha:    Decode to RGBA rather than RGB.
+ * - pixels:   Decoded image, flipped for GL; nullptr until decoded or if decoding failed.
+ * - width, height: Size of the decoded image.
+ * - staging:  Staging buffer the image is copied into, once one is free.
+ * - rows:     Rows uploaded to the texture so far.
+ * - Id:       Texture the image is uploaded into, on the loader context or in bands,
+ *             replacing texture's once complete; 0 after the swap.
+ * - owner:    Loader the job belongs to.
+ * - callback: Called after upload, or nullptr.
+ * - context:  Passed to callback.
+ * - next:     Next job in the same queue.
+ */
+typedef struct CFXTextureJob {
+    CFXTexture2DRef texture;
+    char* path;
+    CFXAssetPackRef pack;
+    const CFXPackEntry* entry;
+    uint32_t nextBlock;
+    uint32_t blocksDone;
+    bool failed;
+    bool alpha;
+    unsigned char* pixels;
+    int width;
+    int height;
+    CFXStagingBuffer* staging;
+    int rows;
+    GLuint Id;
+    struct __CFXTextureLoader* owner;
+    CFXTextureLoadedProc callback;
+    void* context;
+    struct CFXTextureJob* next;
+} CFXTextureJob;
+
+/**
+ * @struct CFXTextureQueue
+ * @brief First in, first out list of jobs.
+ */
+typedef struct CFXTextureQueue {
+    CFXTextureJob* head;
+    CFXTextureJob* tail;
+} CFXTextureQueue;
+
+/**
+ * @struct __CFXTextureLoader
+ * @brief Decodes images on a pool of worker threads and uploads them on the GL thread.
+ *
+ * Load hands back the texture at once, holding a transparent 1 x 1
+ * placeholder, and queues the file. Each texture then moves through three
+ * phases, each on the next queue:
+ *
+ * 1. A worker decodes the file with stb_image (queued to decoded), so
+ *    decoding runs on every core but the GL thread's.
+ * 2. Upload lends the image a mapped buffer from the staging pool and a
+ *    worker copies the pixels into it (decoded to copying to copied).
+ *    Images a pack holds decoded (CFX_PACK_IMAGE) skip phase 1; their
+ *    blocks are claimed one at a time by every idle worker and copied or
+ *    LZ4 decompressed from the pack straight into the staging buffer.
+ * 3. Upload unmaps the buffer and streams it into a new texture name in
+ *    bands of rows with glTexSubImage2D from the buffer, which returns
+ *    without copying. Bands are at most CFX_TEXTURE_BAND_BYTES and a frame
+ *    uploads at most CFX_TEXTURE_FRAME_BYTES, so a large atlas streams
+ *    in over several frames rather than all in one. The texture shows its
+ *    placeholder until the last band lands and the names are swapped.
+ *
+ * Upload, called once a frame on the GL thread, does what it can of
+ * phases 2 and 3 within its time budget. When the pool is out of buffers
+ * images wait in decoded for the GPU to release some.
+ *
+ * With a loader context, workers hand decoded images straight to its
+ * thread, which uploads each into a new texture; once the upload's fence
+ * signals, the new texture replaces the placeholder on the render thread.
+ * Upload then only finishes images that failed to decode.
+ *
+ * Without thread support (Emscripten builds without pthreads) Upload
+ * decodes and copies itself, within the same budget.
+ *
+ * Members:
+ * - obj:      Base object information for the loader.
+ * - lock:     Guards the queues, pending, posting and stopping.
+ * - wake:     Signaled when a file is queued or the loader stops.
+ * - posted:   Signaled when a worker has handed an image to context.
+ * - queued:   Files waiting for a worker.
+ * - decoded:  Images waiting for a staging buffer.
+ * - copying:  Images waiting for a worker to copy them into their staging buffer.
+ * - copied:   Staging buffers waiting for upload; the head may be partly uploaded.
+ * - staging:  Pool of pixel unpack buffers.
+ * - context:  Loader context uploading decoded images, or nullptr.
+ * - pending:  Textures loaded but not yet uploaded.
+ * - posting:  Workers handing an image to context outside the lock.
+ * - stopping: Set by the destructor to end the workers.
+ * - workers:  Worker threads.
+ * - workerCount: Number of worker threads.
+ */
+typedef struct __CFXTextureLoader {
+    __CFObject obj;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t posted;
+    CFXTextureQueue queued;
+    CFXTextureQueue decoded;
+    CFXTextureQueue copying;
+    CFXTextureQueue copied;
+    CFXStagingPoolRef staging;
+    CFXLoaderContextRef context;
+    int pending;
+    int posting;
+    bool stopping;
+    pthread_t* workers;
+    int workerCount;
+} __CFXTextureLoader;
+
+extern proc void* Ctor(
+    CFXTextureLoaderRef this,
+    int threads);
+
+extern proc CFXTexture2DRef Load(
+    CFXTextureLoaderRef this,
+    const GLchar* file,
+    GLboolean alpha,
+    CFXTextureLoadedProc callback,
+    void* context);
+
+extern proc CFXTexture2DRef Load(
+    CFXTextureLoaderRef this,
+    CFXAssetPackRef pack,
+    const GLchar* file,
+    GLboolean alpha,
+    CFXTextureLoadedProc callback,
+    void* context);
+
+extern proc int Upload(
+    CFXTextureLoaderRef this,
+    double budget);
+
+extern proc int Pending(
+    CFXTextureLoaderRef this);
+
+extern proc void SetLoaderContext(
+    CFXTextureLoaderRef this,
+    CFXLoaderContextRef context);
+
+/**
+ * @brief Creates a new CFXTextureLoader.
+ *
+ * @param threads  Decoding threads; 0 uses one per core, less the GL thread's.
+ * @return A reference to the newly created CFXTextureLoader.
+ */
+static inline CFXTextureLoaderRef NewCFXTextureLoader(int threads)
+{
+    return Ctor((CFXTextureLoaderRef)CFCreate(CFXTextureLoader), threads);
+}
@@ -0,0 +1,374 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "uilayer.h"
+
+class2(CFXUILayer);
+
+/**
+ * @brief Constructor for the CFXUILayer object.
+ *
+ * Creates the root group and an empty vertex buffer laid out as CFXUIVertex.
+ *
+ * @param this    Pointer to the CFXUILayer instance to initialize.
+ * @param shader  Reference to the UI shader.
+ * @param atlas   Texture holding every panel, image and glyph.
+ * @param width   Width of the layer in pixels.
+ * @param height  Height of the layer in pixels.
+ * @return        Pointer to the initialized CFXUILayer instance.
+ */
+proc void* Ctor(CFXUILayerRef this, CFXShaderRef shader, CFXTexture2DRef atlas, int width, int height)
+{
+    CFXUILayer->dtor = dtor;
+    this->shader = shader;
+    this->atlas = atlas;
+    this->width = width;
+    this->height = height;
+    this->root = NewCFXUINode(CFX_UI_GROUP, (CFXRect) { 0, 0, width, height });
+    this->font = (CFXRect) { 0, 0, 0, 0 };
+    this->glyphWidth = 0;
+    this->glyphHeight = 0;
+    this->firstGlyph = ' ';
+    this->vertices = nullptr;
+    this->vertexCount = 0;
+    this->vertexCapacity = 0;
+    this->batches = nullptr;
+    this->batchCount = 0;
+    this->batchCapacity = 0;
+    this->patches = nullptr;
+    this->patchCount = 0;
+    this->patchCapacity = 0;
+    this->bufferCapacity = 0;
+    this->reassemble = true;
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CFXUIVertex), (GLvoid*)offsetof(CFXUIVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CFXUIVertex), (GLvoid*)offsetof(CFXUIVertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CFXUIVertex), (GLvoid*)offsetof(CFXUIVertex, color));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXUILayer object.
+ *
+ * Releases the UI tree, the CPU side arrays and the OpenGL buffers.
+ *
+ * @param self Pointer to the CFXUILayer instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXUILayerRef this = self;
+    CFUnref(this->root);
+    free(this->vertices);
+    free(this->batches);
+    free(this->patches);
+    CFXDeletionQueue_VertexArrays(1, &this->VAO);
+    CFXDeletionQueue_Buffers(1, &this->VBO);
+}
+
+/**
+ * @brief Describes the bitmap font used by labels.
+ *
+ * @param this         Reference to the layer.
+ * @param font         Atlas region holding a grid of fixed-size glyphs.
+ * @param glyphWidth   Width of a glyph cell in pixels.
+ * @param glyphHeight  Height of a glyph cell in pixels.
+ * @param firstGlyph   Character code of the top-left glyph.
+ */
+proc void SetFont(CFXUILayerRef this, CFXRect font, int glyphWidth, int glyphHeight, int firstGlyph)
+{
+    this->font = font;
+    this->glyphWidth = glyphWidth;
+    this->glyphHeight = glyphHeight;
+    this->firstGlyph = firstGlyph;
+    MarkDirty(this->root);
+}
+
+/**
+ * @brief Resizes the layer, e.g. from the framebuffer size callback.
+ */
+proc void Resize(CFXUILayerRef this, int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    SetFrame(this->root, (CFXRect) { 0, 0, width, height });
+}
+
+/**
+ * @brief Appends one textured quad to a node's geometry cache.
+ *
+ * Atlas coordinates are given in pixels from the top left and converted to
+ * uv space, accounting for textures being loaded flipped on the y axis.
+ */
+static void PushQuad(
+    CFXUILayerRef this,
+    CFXUINodeRef node,
+    float x0, float y0, float x1, float y1,
+    float sx0, float sy0, float sx1, float sy1)
+{
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    if (node->vertexCount + 6 > node->vertexCapacity) {
+        node->vertexCapacity = node->vertexCapacity ? node->vertexCapacity * 2 : 6;
+        while (node->vertexCount + 6 > node->vertexCapacity)
+            node->vertexCapacity *= 2;
+        node->vertices = realloc(node->vertices, node->vertexCapacity * sizeof(CFXUIVertex));
+    }
+    float iw = 1.0f / (float)this->atlas->Width;
+    float ih = 1.0f / (float)this->atlas->Height;
+    float u0 = sx0 * iw, u1 = sx1 * iw;
+    float v0 = 1.0f - sy0 * ih, v1 = 1.0f - sy1 * ih;
+    CFXUIVertex* v = &node->vertices[node->vertexCount];
+    // Counter-clockwise once the y-down projection flips them, so culling keeps them
+    v[0] = (CFXUIVertex) { { x0, y0 }, { u0, v0 }, node->color };
+    v[1] = (CFXUIVertex) { { x0, y1 }, { u0, v1 }, node->color };
+    v[2] = (CFXUIVertex) { { x1, y1 }, { u1, v1 }, node->color };
+    v[3] = (CFXUIVertex) { { x0, y0 }, { u0, v0 }, node->color };
+    v[4] = (CFXUIVertex) { { x1, y1 }, { u1, v1 }, node->color };
+    v[5] = (CFXUIVertex) { { x1, y0 }, { u1, v0 }, node->color };
+    node->vertexCount += 6;
+}
+
+/**
+ * @brief Regenerates a node's cached geometry from its bounds.
+ *
+ * Panels are split into nine quads whose corners keep their source size,
+ * while edges and center stretch. Labels emit one quad per glyph from the
+ * layer's font grid, wrapping on '\n'.
+ */
+static void Generate(CFXUILayerRef this, CFXUINodeRef node)
+{
+    CFXRect b = node->bounds;
+    CFXRect s = node->source;
+    node->vertexCount = 0;
+
+    switch (node->kind) {
+    case CFX_UI_GROUP:
+        break;
+    case CFX_UI_IMAGE:
+        PushQuad(this, node, b.x, b.y, b.x + b.w, b.y + b.h, s.x, s.y, s.x + s.w, s.y + s.h);
+        break;
+    case CFX_UI_PANEL: {
+        float xs[4] = { b.x, b.x + node->border.x, b.x + b.w - node->border.z, b.x + b.w };
+        float ys[4] = { b.y, b.y + node->border.y, b.y + b.h - node->border.w, b.y + b.h };
+        float us[4] = { s.x, s.x + node->border.x, s.x + s.w - node->border.z, s.x + s.w };
+        float vs[4] = { s.y, s.y + node->border.y, s.y + s.h - node->border.w, s.y + s.h };
+        for (int row = 0; row < 3; row++)
+            for (int col = 0; col < 3; col++)
+                PushQuad(this, node, xs[col], ys[row], xs[col + 1], ys[row + 1], us[col], vs[row], us[col + 1], vs[row + 1]);
+        break;
+    }
+    case CFX_UI_LABEL: {
+        if (node->text == nullptr || this->glyphWidth == 0)
+            break;
+        int columns = this->font.w / this->glyphWidth;
+        int glyphs = columns * (this->font.h / this->glyphHeight);
+        float w = this->glyphWidth * node->textScale;
+        float h = this->glyphHeight * node->textScale;
+        float x = b.x, y = b.y;
+        for (const char* c = node->text; *c; c++) {
+            if (*c == '\n') {
+                x = b.x;
+                y += h;
+                continue;
+            }
+            int glyph = (unsigned char)*c - this->firstGlyph;
+            if (glyph >= 0 && glyph < glyphs) {
+                float gx = this->font.x + (glyph % columns) * this->glyphWidth;
+                float gy = this->font.y + (glyph / columns) * this->glyphHeight;
+                PushQuad(this, node, x, y, x + w, y + h, gx, gy, gx + this->glyphWidth, gy + this->glyphHeight);
+            }
+            x += w;
+        }
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Recomputes bounds and geometry along the dirty paths of the tree.
+ *
+ * A dirty node forces its whole subtree to relayout, since every descendant
+ * is positioned relative to it; a node that is only childDirty just passes
+ * the walk on. Regenerated nodes that kept their vertex count and already
+ * own a slot in the buffer are queued as in-place patches; anything else
+ * schedules a full reassembly. So does moving a node that clips or is
+ * clipped, as the clip rects are only rebuilt by reassembly.
+ */
+static void LayoutNode(CFXUILayerRef this, CFXUINodeRef node, CFXRect parent, bool force, bool clipped)
+{
+    if (!force && !node->dirty && !node->childDirty)
+        return;
+
+    bool relayout = force || node->dirty;
+    if (relayout) {
+        int previous = node->vertexCount;
+        node->bounds = (CFXRect) { parent.x + node->frame.x, parent.y + node->frame.y, node->frame.w, node->frame.h };
+        Generate(this, node);
+        if (node->offset < 0 || node->vertexCount != previous || node->clip || clipped)
+            this->reassemble = true;
+        else if (node->vertexCount > 0) {
+            if (this->patchCount == this->patchCapacity) {
+                this->patchCapacity = this->patchCapacity ? this->patchCapacity * 2 : 16;
+                this->patches = realloc(this->patches, this->patchCapacity * sizeof(CFXUINodeRef));
+            }
+            this->patches[this->patchCount++] = node;
+        }
+    }
+    if (node->restructured)
+        this->reassemble = true;
+
+    for (int i = 0; i < node->childCount; i++)
+        LayoutNode(this, node->children[i], node->bounds, relayout, clipped || node->clip);
+
+    node->dirty = false;
+    node->childDirty = false;
+    node->restructured = false;
+}
+
+/**
+ * @brief Forgets the buffer slots of a hidden subtree so it is never patched in place.
+ */
+static void Evict(CFXUINodeRef node)
+{
+    node->offset = -1;
+    for (int i = 0; i < node->childCount; i++)
+        Evict(node->children[i]);
+}
+
+/**
+ * @brief Returns the intersection of two rects, empty if they do not overlap.
+ */
+static CFXRect Intersect(CFXRect a, CFXRect b)
+{
+    int x0 = Max(a.x, b.x), y0 = Max(a.y, b.y);
+    int x1 = a.x + a.w < b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y1 = a.y + a.h < b.y + b.h ? a.y + a.h : b.y + b.h;
+    return (CFXRect) { x0, y0, Max(0, x1 - x0), Max(0, y1 - y0) };
+}
+
+/**
+ * @brief Appends a subtree's cached geometry to the layer buffer in draw order.
+ *
+ * Consecutive nodes under the same clip rect extend the current batch, so
+ * clipping only costs a state change where the clip actually changes.
+ */
+static void Assemble(CFXUILayerRef this, CFXUINodeRef node, bool clipped, CFXRect clip)
+{
+    if (!node->visible) {
+        Evict(node);
+        return;
+    }
+
+    node->offset = this->vertexCount;
+    if (node->vertexCount > 0) {
+        if (this->vertexCount + node->vertexCount > this->vertexCapacity) {
+            this->vertexCapacity = this->vertexCapacity ? this->vertexCapacity : 256;
+            while (this->vertexCount + node->vertexCount > this->vertexCapacity)
+                this->vertexCapacity *= 2;
+            this->vertices = realloc(this->vertices, this->vertexCapacity * sizeof(CFXUIVertex));
+        }
+        memcpy(&this->vertices[this->vertexCount], node->vertices, node->vertexCount * sizeof(CFXUIVertex));
+
+        CFXUIBatch* last = this->batchCount ? &this->batches[this->batchCount - 1] : nullptr;
+        if (last != nullptr && last->clipped == clipped && (!clipped || memcmp(&last->clip, &clip, sizeof(CFXRect)) == 0))
+            last->count += node->vertexCount;
+        else {
+            if (this->batchCount == this->batchCapacity) {
+                this->batchCapacity = this->batchCapacity ? this->batchCapacity * 2 : 8;
+                this->batches = realloc(this->batches, this->batchCapacity * sizeof(CFXUIBatch));
+            }
+            this->batches[this->batchCount++] = (CFXUIBatch) { this->vertexCount, node->vertexCount, clipped, clip };
+        }
+        this->vertexCount += node->vertexCount;
+    }
+
+    if (node->clip) {
+        clip = clipped ? Intersect(clip, node->bounds) : node->bounds;
+        clipped = true;
+    }
+    for (int i = 0; i < node->childCount; i++)
+        Assemble(this, node->children[i], clipped, clip);
+}
+
+/**
+ * @brief Brings the vertex buffer up to date with the tree.
+ *
+ * Does nothing when no node was marked dirty since the last call.
+ *
+ * @param this Reference to the layer.
+ */
+proc void Layout(CFXUILayerRef this)
+{
+    this->patchCount = 0;
+    LayoutNode(this, this->root, (CFXRect) { 0, 0, this->width, this->height }, false, false);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    if (this->reassemble) {
+        this->vertexCount = 0;
+        this->batchCount = 0;
+        Assemble(this, this->root, false, this->root->bounds);
+        if (this->vertexCount > this->bufferCapacity)
+            this->bufferCapacity = this->vertexCapacity;
+        glBufferData(GL_ARRAY_BUFFER, this->bufferCapacity * sizeof(CFXUIVertex), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, this->vertexCount * sizeof(CFXUIVertex), this->vertices);
+        this->reassemble = false;
+    } else {
+        for (int i = 0; i < this->patchCount; i++) {
+            CFXUINodeRef node = this->patches[i];
+            memcpy(&this->vertices[node->offset], node->vertices, node->vertexCount * sizeof(CFXUIVertex));
+            glBufferSubData(GL_ARRAY_BUFFER, node->offset * sizeof(CFXUIVertex), node->vertexCount * sizeof(CFXUIVertex), node->vertices);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Draws the whole layer, one glDrawArrays per clip batch.
+ *
+ * @param this Reference to the layer.
+ */
+proc void Draw(CFXUILayerRef this)
+{
+    Layout(this);
+    if (this->batchCount == 0)
+        return;
+
+    Use(this->shader);
+    glActiveTexture(GL_TEXTURE0);
+    Bind(this->atlas);
+    glBindVertexArray(this->VAO);
+
+    bool scissor = false;
+    for (int i = 0; i < this->batchCount; i++) {
+        CFXUIBatch* batch = &this->batches[i];
+        if (batch->clipped) {
+            if (!scissor)
+                glEnable(GL_SCISSOR_TEST);
+            scissor = true;
+            glScissor(batch->clip.x, this->height - batch->clip.y - batch->clip.h, batch->clip.w, batch->clip.h);
+        } else if (scissor) {
+            glDisable(GL_SCISSOR_TEST);
+            scissor = false;
+        }
+        glDrawArrays(GL_TRIANGLES, batch->first, batch->count);
+    }
+    if (scissor)
+        glDisable(GL_SCISSOR_TEST);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "texture2d.h"          // IWYU pragma: keep
+#include "shader.h"
+#include "uinode.h"
+#include "rect.h"
+#include "tglm.h"
+
+extern CFClassRef CFXUILayer;
+typedef struct __CFXUILayer* CFXUILayerRef;
+
+/**
+ * @struct CFXUIBatch
+ * @brief A contiguous range of the layer's vertex buffer drawn under one clip rect.
+ */
+typedef struct CFXUIBatch {
+    int first;
+    int count;
+    bool clipped;
+    CFXRect clip;
+} CFXUIBatch;
+
+/**
+ * @struct __CFXUILayer
+ * @brief Owns a retained UI tree and draws it from a cached vertex buffer.
+ *
+ * Every node in the tree samples the same atlas texture, so the whole layer
+ * draws with one shader, one texture and one vertex array; the only state
+ * changes between batches are scissor rects. Each frame the layer walks only
+ * the dirty paths of the tree: nodes whose vertex count did not change are
+ * patched in place with glBufferSubData, and the buffer is reassembled from
+ * the per-node caches only when the tree's shape changed.
+ *
+ * The shader is expected to read:
+ * - location 0: vec2 position in pixels, origin at the top left
+ * - location 1: vec2 atlas uv
+ * - location 2: vec4 tint
+ *
+ * Members:
+ * - obj:            Base object information for the layer.
+ * - shader:         Reference to the shader used to draw the layer.
+ * - atlas:          Texture holding panels, images and the font.
+ * - root:           Root group covering the whole layer.
+ * - VAO:            OpenGL Vertex Array Object identifier.
+ * - VBO:            OpenGL Vertex Buffer Object holding the assembled vertices.
+ * - bufferCapacity: Size of VBO in vertices.
+ * - width, height:  Size of the layer in pixels, used to flip scissor rects.
+ * - font:           Atlas region holding a grid of fixed-size glyphs.
+ * - glyphWidth:     Width of a glyph cell in pixels.
+ * - glyphHeight:    Height of a glyph cell in pixels.
+ * - firstGlyph:     Character code of the top-left glyph.
+ * - vertices:       Assembled vertices, in tree order.
+ * - vertexCount:    Number of assembled vertices.
+ * - vertexCapacity: Allocated size of vertices.
+ * - batches:        Draw ranges with their clip rects.
+ * - batchCount:     Number of batches.
+ * - batchCapacity:  Allocated size of batches.
+ * - patches:        Nodes regenerated this frame that can be patched in place.
+ * - patchCount:     Number of patches.
+ * - patchCapacity:  Allocated size of patches.
+ * - reassemble:     The vertex buffer must be rebuilt from the node caches.
+ */
+typedef struct __CFXUILayer {
+    __CFObject obj;
+    CFXShaderRef shader;
+    CFXTexture2DRef atlas;
+    CFXUINodeRef root;
+    GLuint VAO;
+    GLuint VBO;
+    int bufferCapacity;
+    int width;
+    int height;
+    CFXRect font;
+    int glyphWidth;
+    int glyphHeight;
+    int firstGlyph;
+    CFXUIVertex* vertices;
+    int vertexCount;
+    int vertexCapacity;
+    CFXUIBatch* batches;
+    int batchCount;
+    int batchCapacity;
+    CFXUINodeRef* patches;
+    int patchCount;
+    int patchCapacity;
+    bool reassemble;
+} __CFXUILayer;
+
+extern proc void* Ctor(
+    CFXUILayerRef this,
+    CFXShaderRef shader,
+    CFXTexture2DRef atlas,
+    int width,
+    int height);
+
+extern proc void SetFont(
+    CFXUILayerRef this,
+    CFXRect font,
+    int glyphWidth,
+    int glyphHeight,
+    int firstGlyph);
+
+extern proc void Resize(
+    CFXUILayerRef this,
+    int width,
+    int height);
+
+extern proc void Layout(
+    CFXUILayerRef this);
+
+extern proc void Draw(
+    CFXUILayerRef this);
+
+/**
+ * @brief Creates a new CFXUILayer drawing from the given atlas.
+ *
+ * @param shader  The UI shader.
+ * @param atlas   Texture holding every panel, image and glyph used by the layer.
+ * @param width   Width of the layer in pixels.
+ * @param height  Height of the layer in pixels.
+ * @return A reference to the newly created CFXUILayer.
+ */
+static inline CFXUILayerRef NewCFXUILayer(CFXShaderRef shader, CFXTexture2DRef atlas, int width, int height)
+{
+    return Ctor((CFXUILayerRef)CFCreate(CFXUILayer), shader, atlas, width, height);
+}
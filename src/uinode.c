@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include "uinode.h"
+
+class2(CFXUINode);
+
+/**
+ * @brief Constructor for the CFXUINode object.
+ *
+ * New nodes start visible, dirty and white, with no cached geometry.
+ *
+ * @param this   Pointer to the CFXUINode instance to initialize.
+ * @param kind   The kind of geometry the node emits.
+ * @param frame  Position and size relative to the parent.
+ * @return       Pointer to the initialized CFXUINode instance.
+ */
+proc void* Ctor(CFXUINodeRef this, CFXUINodeKind kind, CFXRect frame)
+{
+    CFXUINode->dtor = dtor;
+    this->kind = kind;
+    this->parent = nullptr;
+    this->children = nullptr;
+    this->childCount = 0;
+    this->childCapacity = 0;
+    this->frame = frame;
+    this->bounds = frame;
+    this->source = (CFXRect) { 0, 0, 0, 0 };
+    this->border = (Vec4) { 0.0f, 0.0f, 0.0f, 0.0f };
+    this->color = (Vec4) { 1.0f, 1.0f, 1.0f, 1.0f };
+    this->text = nullptr;
+    this->textScale = 1.0f;
+    this->visible = true;
+    this->clip = false;
+    this->dirty = true;
+    this->childDirty = false;
+    this->restructured = false;
+    this->vertices = nullptr;
+    this->vertexCount = 0;
+    this->vertexCapacity = 0;
+    this->offset = -1;
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXUINode object.
+ *
+ * Releases the cached geometry and text, and every child node.
+ *
+ * @param self Pointer to the CFXUINode instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXUINodeRef this = self;
+    for (int i = 0; i < this->childCount; i++)
+        CFUnref(this->children[i]);
+    free(this->children);
+    free(this->vertices);
+    free(this->text);
+}
+
+/**
+ * @brief Flags the node for relayout and tells every ancestor it has a dirty descendant.
+ *
+ * Walking stops at the first ancestor that already knows, so marking many
+ * siblings in one frame stays cheap.
+ *
+ * @param this Reference to the node.
+ */
+proc void MarkDirty(CFXUINodeRef this)
+{
+    this->dirty = true;
+    for (CFXUINodeRef node = this->parent; node != nullptr && !node->childDirty; node = node->parent)
+        node->childDirty = true;
+}
+
+/**
+ * @brief Appends a child node, transferring the caller's reference to the parent.
+ *
+ * @param this   Reference to the parent node.
+ * @param child  Node to append; must not already have a parent.
+ */
+proc void AddChild(CFXUINodeRef this, CFXUINodeRef child)
+{
+    if (this->childCount == this->childCapacity) {
+        this->childCapacity = this->childCapacity ? this->childCapacity * 2 : 4;
+        this->children = realloc(this->children, this->childCapacity * sizeof(CFXUINodeRef));
+    }
+    this->children[this->childCount++] = child;
+    child->parent = this;
+    this->restructured = true;
+    MarkDirty(child);
+}
+
+/**
+ * @brief Removes and releases a child node.
+ *
+ * @param this   Reference to the parent node.
+ * @param child  Node to remove.
+ */
+proc void RemoveChild(CFXUINodeRef this, CFXUINodeRef child)
+{
+    for (int i = 0; i < this->childCount; i++) {
+        if (this->children[i] != child)
+            continue;
+        memmove(&this->children[i], &this->children[i + 1], (this->childCount - i - 1) * sizeof(CFXUINodeRef));
+        this->childCount--;
+        child->parent = nullptr;
+        CFUnref(child);
+        this->restructured = true;
+        MarkDirty(this);
+        return;
+    }
+}
+
+/**
+ * @brief Moves or resizes the node relative to its parent.
+ */
+proc void SetFrame(CFXUINodeRef this, CFXRect frame)
+{
+    if (memcmp(&this->frame, &frame, sizeof(CFXRect)) == 0)
+        return;
+    this->frame = frame;
+    MarkDirty(this);
+}
+
+/**
+ * @brief Sets the atlas region and nine-slice insets of a panel or image.
+ *
+ * @param this    Reference to the node.
+ * @param source  Atlas region in pixels.
+ * @param border  Nine-slice insets in pixels (left, top, right, bottom); ignored by images.
+ */
+proc void SetSource(CFXUINodeRef this, CFXRect source, Vec4 border)
+{
+    this->source = source;
+    this->border = border;
+    MarkDirty(this);
+}
+
+/**
+ * @brief Sets the tint applied to the node's vertices.
+ */
+proc void SetColor(CFXUINodeRef this, Vec4 color)
+{
+    this->color = color;
+    MarkDirty(this);
+}
+
+/**
+ * @brief Replaces the text of a label. Unchanged text does not dirty the node.
+ */
+proc void SetText(CFXUINodeRef this, const char* text)
+{
+    if (this->text != nullptr && strcmp(this->text, text) == 0)
+        return;
+    free(this->text);
+    this->text = CFStrDup((char*)text);
+    MarkDirty(this);
+}
+
+/**
+ * @brief Shows or hides the node and its subtree.
+ */
+proc void SetVisible(CFXUINodeRef this, bool visible)
+{
+    if (this->visible == visible)
+        return;
+    this->visible = visible;
+    if (this->parent != nullptr)
+        this->parent->restructured = true;
+    MarkDirty(this);
+}
+
+/**
+ * @brief Turns clipping of the node's children to its bounds on or off.
+ */
+proc void SetClip(CFXUINodeRef this, bool clip)
+{
+    if (this->clip == clip)
+        return;
+    this->clip = clip;
+    // The clip rects live in the layer's batches, which only reassembly rebuilds
+    this->restructured = true;
+    MarkDirty(this);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rect.h"
+#include "tglm.h"
+
+extern CFClassRef CFXUINode;
+typedef struct __CFXUINode* CFXUINodeRef;
+
+/**
+ * @brief The kind of geometry a UI node emits.
+ *
+ * - CFX_UI_GROUP:  No geometry; only positions and clips its children.
+ * - CFX_UI_PANEL:  A nine-slice panel stretched from an atlas region.
+ * - CFX_UI_IMAGE:  A single quad from an atlas region.
+ * - CFX_UI_LABEL:  One quad per character from the layer's bitmap font.
+ */
+typedef enum CFXUINodeKind {
+    CFX_UI_GROUP,
+    CFX_UI_PANEL,
+    CFX_UI_IMAGE,
+    CFX_UI_LABEL
+} CFXUINodeKind;
+
+/**
+ * @struct CFXUIVertex
+ * @brief Vertex layout of the UI vertex buffer: position, atlas uv and tint.
+ */
+typedef struct CFXUIVertex {
+    Vec2 position;
+    Vec2 uv;
+    Vec4 color;
+} CFXUIVertex;
+
+/**
+ * @struct __CFXUINode
+ * @brief A node in a retained UI tree.
+ *
+ * A node's frame is relative to its parent and is only turned into absolute
+ * bounds and vertices when the node has been marked dirty. The generated
+ * vertices are cached on the node, so an unchanged subtree costs nothing
+ * until the layer needs to reassemble its vertex buffer.
+ *
+ * Members:
+ * - obj:           Base object information for the node.
+ * - kind:          The kind of geometry emitted.
+ * - parent:        Parent node, or nullptr for a root.
+ * - children:      Child nodes, owned by this node.
+ * - childCount:    Number of children.
+ * - childCapacity: Allocated size of children.
+ * - frame:         Position and size relative to the parent.
+ * - bounds:        Absolute position and size, computed by layout.
+ * - source:        Atlas region in pixels for panels and images.
+ * - border:        Nine-slice insets in pixels (left, top, right, bottom).
+ * - color:         Tint applied to every vertex.
+ * - text:          Label text.
+ * - textScale:     Label glyph scale relative to the font cell size.
+ * - visible:       Hidden nodes emit no geometry, and neither do their children.
+ * - clip:          Clip children to this node's bounds; change it with SetClip.
+ * - dirty:         This node's layout and geometry must be regenerated.
+ * - childDirty:    Some descendant is dirty.
+ * - restructured:  Children were added, removed or reclipped since the last layout.
+ * - vertices:      Cached geometry for this node (children excluded).
+ * - vertexCount:   Number of cached vertices.
+ * - vertexCapacity: Allocated size of vertices.
+ * - offset:        First vertex of this node in the layer buffer, or -1.
+ */
+typedef struct __CFXUINode {
+    __CFObject obj;
+    CFXUINodeKind kind;
+    CFXUINodeRef parent;
+    CFXUINodeRef* children;
+    int childCount;
+    int childCapacity;
+    CFXRect frame;
+    CFXRect bounds;
+    CFXRect source;
+    Vec4 border;
+    Vec4 color;
+    char* text;
+    GLfloat textScale;
+    bool visible;
+    bool clip;
+    bool dirty;
+    bool childDirty;
+    bool restructured;
+    CFXUIVertex* vertices;
+    int vertexCount;
+    int vertexCapacity;
+    int offset;
+} __CFXUINode;
+
+extern proc void* Ctor(
+    CFXUINodeRef this,
+    CFXUINodeKind kind,
+    CFXRect frame);
+
+extern proc void MarkDirty(
+    CFXUINodeRef this);
+
+extern proc void AddChild(
+    CFXUINodeRef this,
+    CFXUINodeRef child);
+
+extern proc void RemoveChild(
+    CFXUINodeRef this,
+    CFXUINodeRef child);
+
+extern proc void SetFrame(
+    CFXUINodeRef this,
+    CFXRect frame);
+
+extern proc void SetSource(
+    CFXUINodeRef this,
+    CFXRect source,
+    Vec4 border);
+
+extern proc void SetColor(
+    CFXUINodeRef this,
+    Vec4 color);
+
+extern proc void SetText(
+    CFXUINodeRef this,
+    const char* text);
+
+extern proc void SetVisible(
+    CFXUINodeRef this,
+    bool visible);
+
+extern proc void SetClip(
+    CFXUINodeRef this,
+    bool clip);
+
+/**
+ * @brief Creates a new CFXUINode of the given kind.
+ *
+ * @param kind   The kind of geometry the node emits.
+ * @param frame  Position and size relative to the parent.
+ * @return A reference to the newly created CFXUINode.
+ */
+static inline CFXUINodeRef NewCFXUINode(CFXUINodeKind kind, CFXRect frame)
+{
+    return Ctor((CFXUINodeRef)CFCreate(CFXUINode), kind, frame);
+}
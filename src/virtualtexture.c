@@ -0,0 +1,400 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <corefw.h>   // IWYU pragma: keep
+#include "corefx.h"             // IWYU pragma: keep
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+#include "virtualtexture.h"
+
+class2(CFXVirtualTexture);
+
+static const char Magic[4] = { 'C', 'F', 'V', 'T' };
+
+/**
+ * Image texels repeated around each page for bilinear filtering.
+ */
+constexpr int PageBorder = 1;
+
+static int PowerOfTwo(int n)
+{
+    int p = 1;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+/**
+ * @brief Derives the per level page counts, file indices and page table layout.
+ *
+ * Level L of the image is ceil(width / 2^L) texels wide, and the chain
+ * stops at the first level whose page table is a single texel.
+ */
+static void Layout(CFXVirtualTextureRef this)
+{
+    this->payload = this->pageSize - 2 * this->border;
+    this->tableWidth = PowerOfTwo((this->width + this->payload - 1) / this->payload);
+    this->tableHeight = PowerOfTwo((this->height + this->payload - 1) / this->payload);
+
+    int levels = 1;
+    while ((1 << (levels - 1)) < Max(this->tableWidth, this->tableHeight) && levels < CFX_VIRTUAL_TEXTURE_MAX_LEVELS)
+        levels++;
+    this->levels = levels;
+
+    int w = this->width, h = this->height, file = 0, table = 0;
+    for (int level = 0; level < levels; level++) {
+        this->pagesX[level] = Max((w + this->payload - 1) / this->payload, 1);
+        this->pagesY[level] = Max((h + this->payload - 1) / this->payload, 1);
+        this->fileIndex[level] = file;
+        this->tableIndex[level] = table;
+        file += this->pagesX[level] * this->pagesY[level];
+        table += Max(this->tableWidth >> level, 1) * Max(this->tableHeight >> level, 1);
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+}
+
+static int TableSize(CFXVirtualTextureRef this)
+{
+    int last = this->levels - 1;
+    return this->tableIndex[last] + Max(this->tableWidth >> last, 1) * Max(this->tableHeight >> last, 1);
+}
+
+/**
+ * @brief Constructor for the CFXVirtualTexture object.
+ *
+ * @param this  Pointer to the CFXVirtualTexture instance to initialize.
+ * @param path  Page file written by CFXVirtualTexture_Split.
+ * @param side  Slots across the physical page cache, clamped to GL_MAX_TEXTURE_SIZE.
+ * @return      Pointer to the initialized CFXVirtualTexture instance.
+ */
+proc void* Ctor(CFXVirtualTextureRef this, const char* path, int side)
+{
+    CFXVirtualTexture->dtor = dtor;
+    this->file = nullptr;
+    this->table = nullptr;
+    this->tableImage = nullptr;
+    this->tableDirty = false;
+    this->physical = nullptr;
+    this->pageTable = nullptr;
+    this->slots = nullptr;
+    this->pageBuffer = nullptr;
+    this->frame = 0;
+    this->uploadsPerFrame = 8;
+    this->uploads = 0;
+    this->misses = 0;
+
+    CFXVirtualTextureHeader header;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr || fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, Magic, sizeof(Magic)) != 0
+        || header.pageSize <= 2 * header.border) {
+        printf("| ERROR::VIRTUALTEXTURE: Failed to open %s\n", path);
+        if (file != nullptr)
+            fclose(file);
+        return this;
+    }
+    this->file = file;
+    this->width = header.width;
+    this->height = header.height;
+    this->pageSize = header.pageSize;
+    this->border = header.border;
+    Layout(this);
+
+    GLint maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    this->side = Max(side, 2);
+    while (this->side > 2 && (this->side * this->pageSize > maxSize || this->side > 255))
+        this->side--;
+    this->slots = malloc(this->side * this->side * sizeof(CFXVirtualPage));
+    for (int i = 0; i < this->side * this->side; i++)
+        this->slots[i] = (CFXVirtualPage) { -1, 0, 0, -1 };
+
+    int entries = TableSize(this);
+    this->table = malloc(entries * sizeof(int));
+    for (int i = 0; i < entries; i++)
+        this->table[i] = -1;
+    this->tableImage = calloc(entries, 4);
+    this->tableDirty = true;
+    this->pageBuffer = malloc((size_t)this->pageSize * this->pageSize * 4);
+
+    this->physical = NewCFXTexture2D(GL_RGBA8, GL_RGBA, (char*)path);
+    this->physical->wrapS = GL_CLAMP_TO_EDGE;
+    this->physical->wrapT = GL_CLAMP_TO_EDGE;
+    Allocate(this->physical, this->side * this->pageSize, this->side * this->pageSize, 1);
+
+    this->pageTable = NewCFXTexture2D(GL_RGBA8, GL_RGBA, (char*)path);
+    this->pageTable->wrapS = GL_CLAMP_TO_EDGE;
+    this->pageTable->wrapT = GL_CLAMP_TO_EDGE;
+    this->pageTable->filterMin = GL_NEAREST_MIPMAP_NEAREST;
+    this->pageTable->filterMag = GL_NEAREST;
+    Allocate(this->pageTable, this->tableWidth, this->tableHeight, this->levels);
+    return this;
+}
+
+/**
+ * @brief Destructor for the CFXVirtualTexture object.
+ *
+ * @param self Pointer to the CFXVirtualTexture instance to be destroyed.
+ */
+static void dtor(void* self)
+{
+    CFXVirtualTextureRef this = self;
+    if (this->file != nullptr)
+        fclose(this->file);
+    if (this->physical != nullptr)
+        CFUnref(this->physical);
+    if (this->pageTable != nullptr)
+        CFUnref(this->pageTable);
+    free(this->table);
+    free(this->tableImage);
+    free(this->slots);
+    free(this->pageBuffer);
+}
+
+static int* Entry(CFXVirtualTextureRef this, int level, int x, int y)
+{
+    return &this->table[this->tableIndex[level] + y * Max(this->tableWidth >> level, 1) + x];
+}
+
+/**
+ * @brief Picks the least recently used slot not needed this frame, or -1.
+ */
+static int Victim(CFXVirtualTextureRef this)
+{
+    int best = -1;
+    for (int i = 0; i < this->side * this->side; i++) {
+        if (this->slots[i].lastUsed == this->frame)
+            continue;
+        if (best < 0 || this->slots[i].lastUsed < this->slots[best].lastUsed)
+            best = i;
+    }
+    return best;
+}
+
+/**
+ * @brief Marks a page as needed, streaming it in when it is not resident and the budget allows.
+ */
+static void Request(CFXVirtualTextureRef this, int level, int x, int y)
+{
+    int* entry = Entry(this, level, x, y);
+    if (*entry >= 0) {
+        this->slots[*entry].lastUsed = this->frame;
+        return;
+    }
+    int slot = this->uploads < this->uploadsPerFrame ? Victim(this) : -1;
+    if (slot < 0) {
+        this->misses++;
+        return;
+    }
+
+    CFXVirtualPage* page = &this->slots[slot];
+    if (page->level >= 0)
+        *Entry(this, page->level, page->x, page->y) = -1;
+    *page = (CFXVirtualPage) { -1, 0, 0, -1 };
+    this->tableDirty = true;
+
+    size_t pageBytes = (size_t)this->pageSize * this->pageSize * 4;
+    off_t offset = (off_t)sizeof(CFXVirtualTextureHeader)
+        + (off_t)(this->fileIndex[level] + y * this->pagesX[level] + x) * (off_t)pageBytes;
+    if (fseeko(this->file, offset, SEEK_SET) != 0 || fread(this->pageBuffer, pageBytes, 1, this->file) != 1) {
+        printf("| ERROR::VIRTUALTEXTURE: Failed to read page %d,%d of level %d\n", x, y, level);
+        this->misses++;
+        return;
+    }
+    SubImage(this->physical, 0, (slot % this->side) * this->pageSize, (slot / this->side) * this->pageSize,
+        this->pageSize, this->pageSize, this->pageBuffer);
+
+    *page = (CFXVirtualPage) { level, x, y, this->frame };
+    *entry = slot;
+    this->uploads++;
+}
+
+/**
+ * @brief Rewrites and uploads the page table, coarsest level first.
+ *
+ * Missing pages inherit the entry of their parent, so every texel names a
+ * resident page once the single top level page has been loaded.
+ */
+static void UploadTable(CFXVirtualTextureRef this)
+{
+    for (int level = this->levels - 1; level >= 0; level--) {
+        int tw = Max(this->tableWidth >> level, 1), th = Max(this->tableHeight >> level, 1);
+        int pw = Max(this->tableWidth >> (level + 1), 1);
+        for (int y = 0; y < th; y++) {
+            for (int x = 0; x < tw; x++) {
+                int i = this->tableIndex[level] + y * tw + x;
+                unsigned char* texel = &this->tableImage[i * 4];
+                int slot = this->table[i];
+                if (slot >= 0) {
+                    texel[0] = (unsigned char)(slot % this->side);
+                    texel[1] = (unsigned char)(slot / this->side);
+                    texel[2] = (unsigned char)level;
+                    texel[3] = 255;
+                } else if (level + 1 < this->levels) {
+                    memcpy(texel, &this->tableImage[(this->tableIndex[level + 1] + (y >> 1) * pw + (x >> 1)) * 4], 4);
+                } else {
+                    memset(texel, 0, 4);
+                }
+            }
+        }
+        SubImage(this->pageTable, level, 0, 0, tw, th, &this->tableImage[this->tableIndex[level] * 4]);
+    }
+    this->tableDirty = false;
+}
+
+/**
+ * @brief Streams in the pages the camera needs and updates the page table.
+ *
+ * @param this            Reference to the virtual texture.
+ * @param region          Visible part of the image, in level 0 texels.
+ * @param texelsPerPixel  Level 0 texels per screen pixel; selects the finest level needed.
+ */
+proc void Update(CFXVirtualTextureRef this, CFXRect region, GLfloat texelsPerPixel)
+{
+    if (this->file == nullptr)
+        return;
+    this->frame++;
+    this->uploads = 0;
+    this->misses = 0;
+
+    int finest = texelsPerPixel > 1.0f ? (int)floorf(log2f(texelsPerPixel)) : 0;
+    if (finest > this->levels - 1)
+        finest = this->levels - 1;
+
+    for (int level = this->levels - 1; level >= finest; level--) {
+        float span = (float)(this->payload << level);
+        int x0 = Max((int)floorf(region.x / span), 0);
+        int y0 = Max((int)floorf(region.y / span), 0);
+        int x1 = (int)floorf((region.x + region.w - 1) / span);
+        int y1 = (int)floorf((region.y + region.h - 1) / span);
+        x1 = x1 < this->pagesX[level] - 1 ? x1 : this->pagesX[level] - 1;
+        y1 = y1 < this->pagesY[level] - 1 ? y1 : this->pagesY[level] - 1;
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                Request(this, level, x, y);
+    }
+
+    if (this->tableDirty)
+        UploadTable(this);
+}
+
+/**
+ * @brief Binds the page cache and page table and sets the CFX_VIRTUAL_TEXTURE_GLSL uniforms.
+ *
+ * @param this    Reference to the virtual texture.
+ * @param shader  Shader in use that includes CFX_VIRTUAL_TEXTURE_GLSL.
+ * @param unit    Texture unit for the page cache; the page table takes unit + 1.
+ */
+proc void Bind(CFXVirtualTextureRef this, CFXShaderRef shader, GLint unit)
+{
+    if (this->file == nullptr)
+        return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    Bind(this->physical);
+    glActiveTexture(GL_TEXTURE0 + unit + 1);
+    Bind(this->pageTable);
+    glActiveTexture(GL_TEXTURE0);
+    SetInteger(shader, "vtPhysical", unit);
+    SetInteger(shader, "vtPageTable", unit + 1);
+    SetVector4(shader, "vtInfo", this->width, this->height, this->payload, this->border);
+    SetVector3(shader, "vtPhysicalInfo", this->pageSize, this->side * this->pageSize, this->levels - 1);
+}
+
+/**
+ * @brief Halves an RGBA8 image with a 2x2 box filter, repeating the last row and column of odd sizes.
+ */
+static unsigned char* Downsample(const unsigned char* src, int w, int h, int* nw, int* nh)
+{
+    *nw = (w + 1) / 2;
+    *nh = (h + 1) / 2;
+    unsigned char* dst = malloc((size_t)*nw * *nh * 4);
+    for (int y = 0; y < *nh; y++) {
+        int y0 = y * 2, y1 = y * 2 + 1 < h ? y * 2 + 1 : h - 1;
+        for (int x = 0; x < *nw; x++) {
+            int x0 = x * 2, x1 = x * 2 + 1 < w ? x * 2 + 1 : w - 1;
+            for (int c = 0; c < 4; c++) {
+                int sum = src[((size_t)y0 * w + x0) * 4 + c] + src[((size_t)y0 * w + x1) * 4 + c]
+                    + src[((size_t)y1 * w + x0) * 4 + c] + src[((size_t)y1 * w + x1) * 4 + c];
+                dst[((size_t)y * *nw + x) * 4 + c] = (unsigned char)((sum + 2) >> 2);
+            }
+        }
+    }
+    return dst;
+}
+
+/**
+ * @brief Cuts an image into the page file read by CFXVirtualTexture.
+ *
+ * Meant as an offline step: the whole image and its mip chain are held in
+ * memory while splitting. Rows are kept top to bottom, so v points down.
+ *
+ * @param image     Source image, any format stb_image reads.
+ * @param path      Page file to write.
+ * @param pageSize  Page size in texels including the border, e.g. 128.
+ * @return          Whether the page file was written.
+ */
+bool CFXVirtualTexture_Split(const char* image, const char* path, int pageSize)
+{
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char* pixels = stbi_load(image, &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+        printf("| ERROR::VIRTUALTEXTURE: Failed to load %s\n", image);
+        return false;
+    }
+    FILE* out = fopen(path, "wb");
+    if (out == nullptr) {
+        printf("| ERROR::VIRTUALTEXTURE: Failed to create %s\n", path);
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    __CFXVirtualTexture layout = { 0 };
+    layout.width = width;
+    layout.height = height;
+    layout.pageSize = pageSize;
+    layout.border = PageBorder;
+    Layout(&layout);
+    CFXVirtualTextureHeader header = { { 'C', 'F', 'V', 'T' }, width, height, pageSize, PageBorder, layout.levels };
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+    unsigned char* page = malloc((size_t)pageSize * pageSize * 4);
+    unsigned char* level = pixels;
+    int w = width, h = height;
+    for (int l = 0; l < layout.levels && ok; l++) {
+        for (int py = 0; py < layout.pagesY[l] && ok; py++) {
+            for (int px = 0; px < layout.pagesX[l] && ok; px++) {
+                for (int y = 0; y < pageSize; y++) {
+                    int sy = py * layout.payload - PageBorder + y;
+                    sy = sy < 0 ? 0 : sy >= h ? h - 1 : sy;
+                    for (int x = 0; x < pageSize; x++) {
+                        int sx = px * layout.payload - PageBorder + x;
+                        sx = sx < 0 ? 0 : sx >= w ? w - 1 : sx;
+                        memcpy(&page[((size_t)y * pageSize + x) * 4], &level[((size_t)sy * w + sx) * 4], 4);
+                    }
+                }
+                ok = fwrite(page, (size_t)pageSize * pageSize * 4, 1, out) == 1;
+            }
+        }
+        if (l + 1 < layout.levels) {
+            unsigned char* next = Downsample(level, w, h, &w, &h);
+            if (level != pixels)
+                free(level);
+            level = next;
+        }
+    }
+    if (level != pixels)
+        free(level);
+    free(page);
+    stbi_image_free(pixels);
+    if (fclose(out) != 0)
+        ok = false;
+    if (!ok)
+        printf("| ERROR::VIRTUALTEXTURE: Failed to write %s\n", path);
+    return ok;
+}
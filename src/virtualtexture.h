@@ -0,0 +1,182 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <emscripten.h>
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <GLFW/glfw3.h>
+#include <corefw.h>   // IWYU pragma: keep
+#include "rect.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "tglm.h"
+
+extern CFClassRef CFXVirtualTexture;
+typedef struct __CFXVirtualTexture* CFXVirtualTextureRef;
+
+#define CFX_VIRTUAL_TEXTURE_MAX_LEVELS 16
+
+/**
+ * GLSL for sampling a virtual texture; paste it into a fragment shader after
+ * the version line and call VirtualTexture(uv) with uv in [0, 1], v down.
+ * The uniforms are set by Bind.
+ *
+ * The mip level comes from the screen space derivatives of the texel
+ * coordinate. The page table entry for that level names the physical slot
+ * and the level actually resident there, which is coarser when the page is
+ * still streaming, so the lookup always lands on loaded texels.
+ */
+#define CFX_VIRTUAL_TEXTURE_GLSL                                                                  \
+    "uniform sampler2D vtPhysical;\n"                                                             \
+    "uniform sampler2D vtPageTable;\n"                                                            \
+    "uniform vec4 vtInfo;\n"                                                                      \
+    "uniform vec3 vtPhysicalInfo;\n"                                                              \
+    "vec4 VirtualTexture(vec2 uv) {\n"                                                            \
+    "    vec2 texel = clamp(uv, 0.0, 1.0) * vtInfo.xy;\n"                                         \
+    "    vec2 dx = dFdx(texel), dy = dFdy(texel);\n"                                              \
+    "    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));\n"                     \
+    "    int level = int(clamp(floor(lod), 0.0, vtPhysicalInfo.z));\n"                            \
+    "    texel = min(texel, vtInfo.xy - 0.5);\n"                                                  \
+    "    ivec2 page = ivec2(texel / (vtInfo.z * exp2(float(level))));\n"                          \
+    "    vec4 entry = floor(texelFetch(vtPageTable, page, level) * 255.0 + 0.5);\n"               \
+    "    vec2 local = texel / exp2(entry.z);\n"                                                   \
+    "    local -= floor(local / vtInfo.z) * vtInfo.z;\n"                                          \
+    "    vec2 physical = (entry.xy * vtPhysicalInfo.x + vtInfo.w + local) / vtPhysicalInfo.y;\n"  \
+    "    return texture(vtPhysical, physical);\n"                                                 \
+    "}\n"
+
+/**
+ * @struct CFXVirtualTextureHeader
+ * @brief Header of a page file written by CFXVirtualTexture_Split.
+ *
+ * It is followed by every page of every level, level 0 first and rows of
+ * pages top to bottom, each pageSize * pageSize RGBA8 texels. A page holds
+ * pageSize - 2 * border texels of the image and a border copied from its
+ * neighbours so bilinear filtering does not bleed between slots.
+ */
+typedef struct CFXVirtualTextureHeader {
+    char magic[4];
+    uint32_t width;
+    uint32_t height;
+    uint32_t pageSize;
+    uint32_t border;
+    uint32_t levels;
+} CFXVirtualTextureHeader;
+
+/**
+ * @struct CFXVirtualPage
+ * @brief A slot of the physical page cache.
+ *
+ * Members:
+ * - level:     Mip level of the page held, or -1 when the slot is free.
+ * - x, y:      Page coordinates within the level.
+ * - lastUsed:  Frame the page was last needed in.
+ */
+typedef struct CFXVirtualPage {
+    int level;
+    int x;
+    int y;
+    int lastUsed;
+} CFXVirtualPage;
+
+/**
+ * @struct __CFXVirtualTexture
+ * @brief An image larger than any texture, streamed from a page file on demand.
+ *
+ * Update is given the part of the image the camera sees and how many image
+ * texels fall on a screen pixel. It picks the mip level, touches every page
+ * of that level and of all coarser levels under the view, and reads missing
+ * pages from disk into free or least recently used slots of the physical
+ * texture, coarsest first and at most uploadsPerFrame per frame. Pages
+ * needed this frame are never evicted.
+ *
+ * The page table is a mipmapped texture with one texel per page, its level
+ * 0 rounded up to a power of two so every level halves exactly. When a page
+ * is not resident its entry repeats its parent's, which is how the shader
+ * falls back to coarser data instead of sampling garbage.
+ *
+ * Members:
+ * - obj:             Base object information for the virtual texture.
+ * - file:            Open page file, or nullptr when loading failed.
+ * - width, height:   Size of the image in texels.
+ * - pageSize:        Size of a page including its border, in texels.
+ * - border:          Border on each side of a page, in texels.
+ * - payload:         Image texels across a page, pageSize - 2 * border.
+ * - levels:          Number of mip levels; the last fits in one page.
+ * - pagesX, pagesY:  Per level: pages across and down.
+ * - fileIndex:       Per level: index of the level's first page in the file.
+ * - tableIndex:      Per level: offset of the level in table.
+ * - tableWidth, tableHeight: Size of page table level 0.
+ * - table:           Per page of every level: slot holding it, or -1.
+ * - tableImage:      RGBA8 page table texels of every level.
+ * - tableDirty:      Whether table changed since the last upload.
+ * - physical:        Page cache texture.
+ * - pageTable:       Page table texture.
+ * - side:            Slots across the physical texture.
+ * - slots:           The side * side cache slots.
+ * - pageBuffer:      Staging buffer for one page.
+ * - frame:           Number of Update calls, used for LRU.
+ * - uploadsPerFrame: Most pages read from disk in one Update.
+ * - uploads:         Pages read in the last Update.
+ * - misses:          Pages needed but not resident after the last Update.
+ */
+typedef struct __CFXVirtualTexture {
+    __CFObject obj;
+    FILE* file;
+    int width;
+    int height;
+    int pageSize;
+    int border;
+    int payload;
+    int levels;
+    int pagesX[CFX_VIRTUAL_TEXTURE_MAX_LEVELS];
+    int pagesY[CFX_VIRTUAL_TEXTURE_MAX_LEVELS];
+    int fileIndex[CFX_VIRTUAL_TEXTURE_MAX_LEVELS];
+    int tableIndex[CFX_VIRTUAL_TEXTURE_MAX_LEVELS];
+    int tableWidth;
+    int tableHeight;
+    int* table;
+    unsigned char* tableImage;
+    bool tableDirty;
+    CFXTexture2DRef physical;
+    CFXTexture2DRef pageTable;
+    int side;
+    CFXVirtualPage* slots;
+    unsigned char* pageBuffer;
+    int frame;
+    int uploadsPerFrame;
+    int uploads;
+    int misses;
+} __CFXVirtualTexture;
+
+extern proc void* Ctor(
+    CFXVirtualTextureRef this,
+    const char* path,
+    int side);
+
+extern proc void Update(
+    CFXVirtualTextureRef this,
+    CFXRect region,
+    GLfloat texelsPerPixel);
+
+extern proc void Bind(
+    CFXVirtualTextureRef this,
+    CFXShaderRef shader,
+    GLint unit);
+
+extern bool CFXVirtualTexture_Split(
+    const char* image,
+    const char* path,
+    int pageSize);
+
+/**
+ * @brief Opens a page file written by CFXVirtualTexture_Split.
+ *
+ * @param path  Page file.
+ * @param side  Slots across the physical page cache; it holds side * side pages.
+ * @return A reference to the newly created CFXVirtualTexture.
+ */
+static inline CFXVirtualTextureRef NewCFXVirtualTexture(const char* path, int side)
+{
+    return Ctor((CFXVirtualTextureRef)CFCreate(CFXVirtualTexture), path, side);
+}
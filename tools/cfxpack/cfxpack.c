@@ -0,0 +1,249 @@
+/**
+ * cfxpack: builds a CFX asset pack from a directory.
+ *
+ *     cfxpack [-i] [-c] <directory> <output>
+ *
+ * Every regular file under the directory is stored under its path relative
+ * to it, in the layout described in src/packformat.h. Entries are written
+ * in name order, so the same tree always gives the same pack.
+ *
+ *     -i  Store images decoded, rows bottom to top, so loading them skips
+ *         the image decoder. Images with alpha keep four channels, others
+ *         three; load them with the matching alpha flag.
+ *     -c  Compress decoded images as independent LZ4 blocks, when that
+ *         saves space. Other files stay as they are, to be read in place.
+ */
+#define _XOPEN_SOURCE 700
+#include <ftw.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <lz4.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "packformat.h"
+
+/**
+ * A file found under the directory.
+ */
+typedef struct PackFile {
+    char* path;
+    const char* name;
+    uint64_t size;
+} PackFile;
+
+static PackFile* Files;
+static size_t FileCount;
+static size_t FileCapacity;
+static size_t RootLength;
+
+static int Collect(const char* path, const struct stat* info, int type, struct FTW* ftw)
+{
+    (void)ftw;
+    if (type != FTW_F || !S_ISREG(info->st_mode))
+        return 0;
+    if (FileCount == FileCapacity) {
+        FileCapacity = FileCapacity ? FileCapacity * 2 : 64;
+        Files = realloc(Files, FileCapacity * sizeof(PackFile));
+    }
+    PackFile* file = &Files[FileCount++];
+    file->path = strdup(path);
+    file->name = file->path + RootLength;
+    while (*file->name == '/')
+        file->name++;
+    file->size = (uint64_t)info->st_size;
+    return 0;
+}
+
+static int CompareName(const void* a, const void* b)
+{
+    return strcmp(((const PackFile*)a)->name, ((const PackFile*)b)->name);
+}
+
+static unsigned char* ReadFile(const PackFile* file)
+{
+    FILE* in = fopen(file->path, "rb");
+    if (in == nullptr)
+        return nullptr;
+    unsigned char* data = malloc(file->size + 1);
+    size_t n = fread(data, 1, (size_t)file->size, in);
+    fclose(in);
+    if (n != file->size) {
+        free(data);
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * @brief Replaces an image's file contents with its pixels, as CFX_PACK_IMAGE.
+ */
+static void DecodeImage(CFXPackEntry* entry, unsigned char** blob)
+{
+    int width, height, channels;
+    if (!stbi_info_from_memory(*blob, (int)entry->size, &width, &height, &channels))
+        return;
+    channels = channels == 2 || channels == 4 ? 4 : 3;
+    unsigned char* pixels = stbi_load_from_memory(*blob, (int)entry->size, &width, &height, &(int){ 0 }, channels);
+    if (pixels == nullptr)
+        return;
+    free(*blob);
+    *blob = pixels;
+    entry->flags |= CFX_PACK_IMAGE;
+    entry->size = entry->packedSize = (uint64_t)width * height * channels;
+    entry->blockSize = CFX_PACK_BLOCK_SIZE;
+    entry->width = (uint32_t)width;
+    entry->height = (uint32_t)height;
+    entry->channels = (uint32_t)channels;
+}
+
+/**
+ * @brief Compresses a decoded image block by block, keeping the result if it is smaller.
+ */
+static void Compress(CFXPackEntry* entry, unsigned char** blob)
+{
+    uint32_t count = CFXPack_BlockCount(entry);
+    size_t table = count * sizeof(uint32_t);
+    unsigned char* packed = malloc(table + (size_t)count * LZ4_compressBound((int)entry->blockSize));
+    uint32_t* ends = (uint32_t*)packed;
+    uint32_t end = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t start = (uint64_t)i * entry->blockSize;
+        int length = (int)(entry->size - start < entry->blockSize ? entry->size - start : entry->blockSize);
+        int n = LZ4_compress_default((const char*)*blob + start, (char*)packed + table + end, length, LZ4_compressBound(length));
+        if (n <= 0) {
+            free(packed);
+            return;
+        }
+        end += (uint32_t)n;
+        ends[i] = end;
+    }
+    if (table + end >= entry->size) {
+        free(packed);
+        return;
+    }
+    free(*blob);
+    *blob = packed;
+    entry->flags |= CFX_PACK_LZ4;
+    entry->packedSize = table + end;
+}
+
+static bool Pad(FILE* out, uint64_t* offset, uint64_t to)
+{
+    static const char zeros[CFX_PACK_ALIGNMENT] = {};
+    while (*offset < to) {
+        size_t n = to - *offset < sizeof(zeros) ? (size_t)(to - *offset) : sizeof(zeros);
+        if (fwrite(zeros, 1, n, out) != n)
+            return false;
+        *offset += n;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool images = false;
+    bool compress = false;
+    int option;
+    while ((option = getopt(argc, argv, "ic")) != -1) {
+        if (option == 'i')
+            images = true;
+        else if (option == 'c')
+            compress = true;
+        else
+            argc = 0;
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, "usage: %s [-i] [-c] <directory> <output>\n", argv[0]);
+        return 2;
+    }
+    const char* root = argv[optind];
+    const char* output = argv[optind + 1];
+    RootLength = strlen(root);
+    while (RootLength > 1 && root[RootLength - 1] == '/')
+        RootLength--;
+    if (nftw(root, Collect, 32, FTW_PHYS) != 0) {
+        perror(root);
+        return 1;
+    }
+    qsort(Files, FileCount, sizeof(PackFile), CompareName);
+    stbi_set_flip_vertically_on_load(true);
+
+    uint32_t slotCount = 2;
+    while (slotCount < FileCount * 2)
+        slotCount *= 2;
+
+    CFXPackHeader header = {};
+    memcpy(header.magic, CFX_PACK_MAGIC, sizeof(CFX_PACK_MAGIC));
+    header.version = CFX_PACK_VERSION;
+    header.entryCount = (uint32_t)FileCount;
+    header.slotCount = slotCount;
+    header.slots = sizeof(CFXPackHeader);
+    header.entries = header.slots + slotCount * sizeof(uint32_t);
+    header.names = header.entries + FileCount * sizeof(CFXPackEntry);
+
+    uint32_t* slots = calloc(slotCount, sizeof(uint32_t));
+    CFXPackEntry* entries = calloc(FileCount ? FileCount : 1, sizeof(CFXPackEntry));
+    uint64_t names = 0;
+    for (size_t i = 0; i < FileCount; i++) {
+        size_t length = strlen(Files[i].name);
+        entries[i].hash = CFXPack_Hash(Files[i].name, length);
+        entries[i].name = (uint32_t)names;
+        entries[i].nameLength = (uint32_t)length;
+        names += length + 1;
+        uint32_t mask = slotCount - 1;
+        uint64_t slot = entries[i].hash;
+        while (slots[slot & mask] != 0)
+            slot++;
+        slots[slot & mask] = (uint32_t)i + 1;
+    }
+
+    FILE* out = fopen(output, "wb");
+    if (out == nullptr) {
+        perror(output);
+        return 1;
+    }
+    // Blobs are written first, behind room for the tables, which need their sizes
+    uint64_t offset = 0;
+    bool ok = Pad(out, &offset, header.names);
+    for (size_t i = 0; ok && i < FileCount; i++)
+        ok = fwrite(Files[i].name, 1, entries[i].nameLength + 1, out) == entries[i].nameLength + 1;
+    offset += names;
+    uint64_t unpacked = 0;
+    for (size_t i = 0; ok && i < FileCount; i++) {
+        CFXPackEntry* entry = &entries[i];
+        entry->size = entry->packedSize = Files[i].size;
+        unsigned char* blob = ReadFile(&Files[i]);
+        if (blob == nullptr) {
+            fprintf(stderr, "%s: failed to read\n", Files[i].path);
+            ok = false;
+            break;
+        }
+        if (images)
+            DecodeImage(entry, &blob);
+        if (compress && (entry->flags & CFX_PACK_IMAGE))
+            Compress(entry, &blob);
+        unpacked += entry->size;
+        ok = Pad(out, &offset, CFXPack_Align(offset));
+        entry->offset = offset;
+        ok = ok && fwrite(blob, 1, (size_t)entry->packedSize, out) == entry->packedSize && fputc(0, out) != EOF;
+        offset += entry->packedSize + 1;
+        free(blob);
+    }
+    header.size = offset;
+    ok = ok && fseek(out, 0, SEEK_SET) == 0
+        && fwrite(&header, sizeof(header), 1, out) == 1
+        && fwrite(slots, sizeof(uint32_t), slotCount, out) == slotCount
+        && fwrite(entries, sizeof(CFXPackEntry), FileCount, out) == FileCount;
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "%s: failed to write\n", output);
+        remove(output);
+        return 1;
+    }
+    printf("%s: %zu files, %llu bytes holding %llu\n", output, FileCount,
+        (unsigned long long)header.size, (unsigned long long)unpacked);
+    return 0;
+}
@@ -0,0 +1,269 @@
+/**
+ * packbench: compares the ways an asset pack can deliver texture pixels.
+ *
+ *     packbench [-t threads] [-n runs] <plain.pack> <raw.pack> <lz4.pack>
+ *
+ * The three packs are built by cfxpack from the same directory: without
+ * flags, with -i and with -i -c. For every image the raw pack holds
+ * decoded, each method produces its pixels in a destination buffer, as the
+ * texture loader does in a staging buffer:
+ *
+ *     png      stb_image decodes the file from the mapped plain pack.
+ *     raw      the pixels are copied out of the mapped raw pack.
+ *     lz4      the blocks are decompressed from the mapped LZ4 pack, on one thread.
+ *     lz4 x N  the same on N threads, each claiming the next block.
+ *
+ * Packs are mapped once, so after the first run the page cache is warm;
+ * the first run's time is reported apart from the best. Drop the page
+ * cache before running for cold storage numbers.
+ */
+#define _XOPEN_SOURCE 700
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <lz4.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "packformat.h"
+
+typedef struct Pack {
+    const char* path;
+    const unsigned char* data;
+    size_t size;
+    const CFXPackHeader* header;
+    const CFXPackEntry* entries;
+} Pack;
+
+/**
+ * One image, found in all three packs.
+ */
+typedef struct Image {
+    const CFXPackEntry* plain;
+    const CFXPackEntry* raw;
+    const CFXPackEntry* lz4;
+    unsigned char* out;
+} Image;
+
+/**
+ * A block of an image; the threads claim these in order.
+ */
+typedef struct Block {
+    int image;
+    uint32_t index;
+} Block;
+
+static Pack Packs[3];
+static Image* Images;
+static int ImageCount;
+static Block* Blocks;
+static int BlockCount;
+static atomic_int NextBlock;
+static atomic_int Failures;
+
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static bool Map(Pack* pack, const char* path)
+{
+    pack->path = path;
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CFXPackHeader)) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    pack->size = (size_t)info.st_size;
+    void* data = mmap(nullptr, pack->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    pack->data = data;
+    pack->header = data;
+    pack->entries = (const CFXPackEntry*)(pack->data + pack->header->entries);
+    return memcmp(pack->header->magic, CFX_PACK_MAGIC, sizeof(CFX_PACK_MAGIC)) == 0
+        && pack->header->version == CFX_PACK_VERSION
+        && pack->header->size == pack->size;
+}
+
+static const char* Name(const Pack* pack, const CFXPackEntry* entry)
+{
+    return (const char*)pack->data + pack->header->names + entry->name;
+}
+
+/**
+ * @brief Decompresses or copies one block, as CFXAssetPack's Unpack does.
+ */
+static bool Unpack(const Pack* pack, const CFXPackEntry* entry, uint32_t block, unsigned char* out)
+{
+    uint32_t count = CFXPack_BlockCount(entry);
+    uint64_t start = (uint64_t)block * entry->blockSize;
+    uint64_t length = entry->blockSize == 0 ? entry->size : entry->size - start;
+    if (entry->blockSize != 0 && length > entry->blockSize)
+        length = entry->blockSize;
+    const unsigned char* blob = pack->data + entry->offset;
+    if ((entry->flags & CFX_PACK_LZ4) == 0) {
+        memcpy(out + start, blob + start, (size_t)length);
+        return true;
+    }
+    const uint32_t* ends = (const uint32_t*)blob;
+    const char* blocks = (const char*)(ends + count);
+    uint32_t begin = block > 0 ? ends[block - 1] : 0;
+    int n = LZ4_decompress_safe(blocks + begin, (char*)out + start, (int)(ends[block] - begin), (int)length);
+    return n == (int)length;
+}
+
+static bool DecodePng(void)
+{
+    bool ok = true;
+    for (int i = 0; i < ImageCount; i++) {
+        const CFXPackEntry* entry = Images[i].plain;
+        int width, height, channels;
+        unsigned char* pixels = stbi_load_from_memory(Packs[0].data + entry->offset, (int)entry->size,
+            &width, &height, &channels, (int)Images[i].raw->channels);
+        ok = ok && pixels != nullptr;
+        if (pixels != nullptr)
+            memcpy(Images[i].out, pixels, (size_t)Images[i].raw->size);
+        stbi_image_free(pixels);
+    }
+    return ok;
+}
+
+static bool CopyRaw(void)
+{
+    for (int i = 0; i < ImageCount; i++)
+        memcpy(Images[i].out, Packs[1].data + Images[i].raw->offset, (size_t)Images[i].raw->size);
+    return true;
+}
+
+static void* Worker(void* unused)
+{
+    (void)unused;
+    int next;
+    while ((next = atomic_fetch_add(&NextBlock, 1)) < BlockCount) {
+        Block* block = &Blocks[next];
+        if (!Unpack(&Packs[2], Images[block->image].lz4, block->index, Images[block->image].out))
+            atomic_fetch_add(&Failures, 1);
+    }
+    return nullptr;
+}
+
+static bool DecompressLz4(int threads)
+{
+    atomic_store(&NextBlock, 0);
+    atomic_store(&Failures, 0);
+    pthread_t* workers = malloc(threads * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+        if (pthread_create(&workers[started], nullptr, Worker, nullptr) == 0)
+            started++;
+    Worker(nullptr);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], nullptr);
+    free(workers);
+    return atomic_load(&Failures) == 0;
+}
+
+static void Report(const char* method, int threads, int runs, uint64_t read, uint64_t written)
+{
+    double first = 0, best = 0;
+    for (int run = 0; run < runs; run++) {
+        double start = Now();
+        bool ok = method[0] == 'p' ? DecodePng()
+            : method[0] == 'r'     ? CopyRaw()
+                                   : DecompressLz4(threads);
+        double seconds = Now() - start;
+        if (!ok) {
+            printf("%-8s failed\n", method);
+            return;
+        }
+        if (run == 0)
+            first = seconds;
+        if (run == 0 || seconds < best)
+            best = seconds;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), threads > 1 ? "%s x %d" : "%s", method, threads);
+    printf("%-10s %10.2f %10.2f %10.1f %10.1f %10.1f\n", label, first * 1e3, best * 1e3,
+        read / 1048576.0, written / 1048576.0 / best, read / 1048576.0 / best);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int runs = 5;
+    int option;
+    while ((option = getopt(argc, argv, "t:n:")) != -1) {
+        if (option == 't')
+            threads = atoi(optarg);
+        else if (option == 'n')
+            runs = atoi(optarg);
+        else
+            argc = 0;
+    }
+    if (argc - optind != 3 || threads < 1 || runs < 1) {
+        fprintf(stderr, "usage: %s [-t threads] [-n runs] <plain.pack> <raw.pack> <lz4.pack>\n", argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (!Map(&Packs[i], argv[optind + i])) {
+            fprintf(stderr, "%s: not a version %d pack\n", argv[optind + i], CFX_PACK_VERSION);
+            return 1;
+        }
+    }
+    if (Packs[0].header->entryCount != Packs[1].header->entryCount
+        || Packs[1].header->entryCount != Packs[2].header->entryCount) {
+        fprintf(stderr, "the packs were not built from the same directory\n");
+        return 1;
+    }
+
+    // Entries are in name order in every pack, so the same index is the same file
+    uint64_t plainBytes = 0, rawBytes = 0, lz4Bytes = 0;
+    Images = calloc(Packs[1].header->entryCount + 1, sizeof(Image));
+    for (uint32_t i = 0; i < Packs[1].header->entryCount; i++) {
+        Image image = { &Packs[0].entries[i], &Packs[1].entries[i], &Packs[2].entries[i], nullptr };
+        if ((image.raw->flags & CFX_PACK_IMAGE) == 0 || (image.lz4->flags & CFX_PACK_IMAGE) == 0
+            || image.plain->flags != 0)
+            continue;
+        if (strcmp(Name(&Packs[0], image.plain), Name(&Packs[1], image.raw)) != 0
+            || strcmp(Name(&Packs[1], image.raw), Name(&Packs[2], image.lz4)) != 0) {
+            fprintf(stderr, "the packs were not built from the same directory\n");
+            return 1;
+        }
+        image.out = malloc((size_t)image.raw->size);
+        for (uint32_t b = 0; b < CFXPack_BlockCount(image.lz4); b++) {
+            Blocks = realloc(Blocks, (BlockCount + 1) * sizeof(Block));
+            Blocks[BlockCount++] = (Block) { ImageCount, b };
+        }
+        plainBytes += image.plain->packedSize;
+        rawBytes += image.raw->packedSize;
+        lz4Bytes += image.lz4->packedSize;
+        Images[ImageCount++] = image;
+    }
+    if (ImageCount == 0) {
+        fprintf(stderr, "%s holds no decoded images; build it with cfxpack -i\n", Packs[1].path);
+        return 1;
+    }
+
+    printf("%d images, %.1f MB of pixels in %d blocks\n\n", ImageCount, rawBytes / 1048576.0, BlockCount);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "method", "first ms", "best ms", "read MB", "out MB/s", "read MB/s");
+    stbi_set_flip_vertically_on_load(true);
+    Report("png", 1, runs, plainBytes, rawBytes);
+    Report("raw", 1, runs, rawBytes, rawBytes);
+    Report("lz4", 1, runs, lz4Bytes, rawBytes);
+    if (threads > 1)
+        Report("lz4", threads, runs, lz4Bytes, rawBytes);
+    return 0;
+}